@@ -38,8 +38,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <assert.h>
+#include <signal.h>
+
+#ifdef HAVE_BACKTRACE
+#include <execinfo.h>
+#endif
 
 #ifdef WITH_VALGRIND
 #include <valgrind/valgrind.h>
@@ -71,9 +77,32 @@
 #define DO_UNLOCK() \
 	EGG_SECURE_GLOBALS.unlock ();
 
+#ifndef EGG_SECURE_DEFAULT_HARDENING
+#define EGG_SECURE_DEFAULT_HARDENING EGG_SECURE_HARDEN_DEFAULT
+#endif
+
+/* Used when the huge page size can't be read from /proc/meminfo */
+#define DEFAULT_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/* Largest alignment an aligned allocation may get from the fallback */
+#define FALLBACK_ALIGNMENT 16
+
 static int show_warning = 1;
 int egg_secure_warnings = 1;
 
+#if EGG_SECURE_DEFAULT_HARDENING != EGG_SECURE_HARDEN_FAST
+/* Set from the environment or egg_secure_set_hardening() on first use */
+static int hardening = 0;
+#endif
+
+/* Set from the environment or egg_secure_set_pages() on first use */
+static int page_source = 0;
+
+/* Set from the environment or egg_secure_set_profiling() on first use */
+static int profile_read = 0;
+static size_t profile_interval = 0;
+static unsigned int profile_depth = 1;
+
 /*
  * We allocate all memory in units of sizeof(void*). This
  * is our definition of 'word'.
@@ -93,6 +122,8 @@ typedef struct _Cell {
 	size_t n_words;         /* Amount of secure memory in words */
 	size_t requested;       /* Amount actually requested by app, in bytes, 0 if unused */
 	const char *tag;        /* Tag which describes the allocation */
+	struct _Site *site;     /* Profiled call site, if this allocation was sampled */
+	size_t sampled;         /* Bytes this allocation stands for in its site */
 	struct _Cell *next;     /* Next in memory ring */
 	struct _Cell *prev;     /* Previous in memory ring */
 } Cell;
@@ -106,6 +137,8 @@ typedef struct _Block {
 	size_t n_used;              /* Number of used allocations */
 	struct _Cell* used_cells;   /* Ring of used allocations */
 	struct _Cell* unused_cells; /* Ring of unused allocations */
+	unsigned long serial;       /* Increasing creation number, used by cursors */
+	int pages;                  /* Page source that actually served the block */
 	struct _Block *next;        /* Next block in list */
 } Block;
 
@@ -291,6 +324,223 @@ pool_valid (void* item)
 
 #endif /* G_DISABLE_ASSERT */
 
+/* -----------------------------------------------------------------------------
+ * HARDENING LEVEL
+ */
+
+#if EGG_SECURE_DEFAULT_HARDENING == EGG_SECURE_HARDEN_FAST
+
+/* A constant, so that the checks are compiled out of a fast build */
+static inline int
+sec_hardening (void)
+{
+	return EGG_SECURE_HARDEN_FAST;
+}
+
+#else /* EGG_SECURE_DEFAULT_HARDENING != EGG_SECURE_HARDEN_FAST */
+
+static inline int
+sec_hardening (void)
+{
+	const char *env;
+
+	if (hardening != 0)
+		return hardening;
+
+	env = getenv ("SECMEM_HARDENING");
+	if (env == NULL || env[0] == '\0')
+		hardening = EGG_SECURE_DEFAULT_HARDENING;
+	else if (strcmp (env, "fast") == 0)
+		hardening = EGG_SECURE_HARDEN_FAST;
+	else if (strcmp (env, "paranoid") == 0)
+		hardening = EGG_SECURE_HARDEN_PARANOID;
+	else if (strcmp (env, "default") == 0)
+		hardening = EGG_SECURE_HARDEN_DEFAULT;
+	else {
+		if (egg_secure_warnings)
+			fprintf (stderr, "invalid SECMEM_HARDENING level: %s\n", env);
+		hardening = EGG_SECURE_DEFAULT_HARDENING;
+	}
+
+	return hardening;
+}
+
+#endif /* EGG_SECURE_DEFAULT_HARDENING != EGG_SECURE_HARDEN_FAST */
+
+/* -----------------------------------------------------------------------------
+ * PROFILING
+ *
+ * Allocations are sampled about once every profile_interval bytes, and each
+ * sample stands for that many bytes, or its own length if larger. Samples
+ * are aggregated per tag and call site. Sites live outside of secure memory,
+ * and are never freed, so cells can keep pointing to them.
+ */
+
+#define PROFILE_MAX_DEPTH  16
+#define PROFILE_BUCKETS    251
+
+#ifdef __GNUC__
+#define SEC_CALLER() __builtin_return_address (0)
+#else
+#define SEC_CALLER() NULL
+#endif
+
+typedef struct _Site {
+	const char *tag;
+	void *frames[PROFILE_MAX_DEPTH];
+	unsigned int n_frames;
+	size_t live_bytes;
+	size_t live_samples;
+	size_t total_bytes;
+	struct _Site *next;
+} Site;
+
+static Site *profile_sites[PROFILE_BUCKETS];
+static size_t profile_countdown = 0;
+static unsigned long profile_random = 1;
+static volatile sig_atomic_t profile_requested = 0;
+
+static void
+sec_profile_on_signal (int signum)
+{
+	profile_requested = 1;
+}
+
+static inline size_t
+sec_profiling (void)
+{
+	struct sigaction sa;
+	const char *env;
+
+	if (profile_read)
+		return profile_interval;
+
+	profile_read = 1;
+	env = getenv ("SECMEM_PROFILE");
+	if (env == NULL || env[0] == '\0')
+		return profile_interval;
+
+	profile_interval = strtoul (env, NULL, 10);
+	env = getenv ("SECMEM_PROFILE_DEPTH");
+	if (env != NULL && env[0] != '\0')
+		profile_depth = strtoul (env, NULL, 10);
+
+	/* Report on SIGUSR2, unless someone else is using it */
+	if (profile_interval > 0 && sigaction (SIGUSR2, NULL, &sa) == 0 &&
+	    sa.sa_handler == SIG_DFL) {
+		memset (&sa, 0, sizeof (sa));
+		sa.sa_handler = sec_profile_on_signal;
+		sigemptyset (&sa.sa_mask);
+		sa.sa_flags = SA_RESTART;
+		sigaction (SIGUSR2, &sa, NULL);
+	}
+
+	return profile_interval;
+}
+
+static size_t
+sec_profile_next_countdown (void)
+{
+	/* Vary the distance between samples, so as not to follow a pattern */
+	profile_random = profile_random * 1103515245 + 12345;
+	return 1 + (profile_random >> 16) % (2 * profile_interval - 1);
+}
+
+static unsigned int
+sec_profile_frames (void *caller,
+                    void **frames)
+{
+	unsigned int n_frames = 0;
+#ifdef HAVE_BACKTRACE
+	void *trace[PROFILE_MAX_DEPTH + 8];
+	int n_trace, i;
+
+	/* Start the backtrace at the caller, skipping our own frames */
+	if (profile_depth > 1) {
+		n_trace = backtrace (trace, PROFILE_MAX_DEPTH + 8);
+		for (i = 0; i < n_trace && trace[i] != caller; i++);
+		for (; i < n_trace && n_frames < profile_depth &&
+		       n_frames < PROFILE_MAX_DEPTH; i++)
+			frames[n_frames++] = trace[i];
+	}
+#endif
+
+	if (n_frames == 0)
+		frames[n_frames++] = caller;
+	return n_frames;
+}
+
+static Site *
+sec_profile_site (const char *tag,
+                  void *caller)
+{
+	void *frames[PROFILE_MAX_DEPTH];
+	unsigned int n_frames, i;
+	size_t hash = 0;
+	Site *site;
+
+	n_frames = sec_profile_frames (caller, frames);
+	for (i = 0; i < n_frames; i++)
+		hash = (hash * 31) ^ (size_t)frames[i];
+
+	for (site = profile_sites[hash % PROFILE_BUCKETS]; site; site = site->next) {
+		if (site->n_frames == n_frames && strcmp (site->tag, tag) == 0 &&
+		    memcmp (site->frames, frames, n_frames * sizeof (void *)) == 0)
+			return site;
+	}
+
+	site = calloc (1, sizeof (Site));
+	if (site == NULL)
+		return NULL;
+
+	site->tag = tag;
+	memcpy (site->frames, frames, n_frames * sizeof (void *));
+	site->n_frames = n_frames;
+	site->next = profile_sites[hash % PROFILE_BUCKETS];
+	profile_sites[hash % PROFILE_BUCKETS] = site;
+	return site;
+}
+
+static void
+sec_profile_sample (Cell *cell,
+                    void *caller)
+{
+	size_t weight;
+	Site *site;
+
+	ASSERT (cell->site == NULL);
+
+	if (profile_countdown == 0)
+		profile_countdown = sec_profile_next_countdown ();
+	if (cell->requested < profile_countdown) {
+		profile_countdown -= cell->requested;
+		return;
+	}
+
+	profile_countdown = 0;
+	site = sec_profile_site (cell->tag, caller);
+	if (site == NULL)
+		return;
+
+	weight = cell->requested > profile_interval ? cell->requested : profile_interval;
+	cell->site = site;
+	cell->sampled = weight;
+	site->live_bytes += weight;
+	site->live_samples++;
+	site->total_bytes += weight;
+}
+
+static void
+sec_profile_release (Cell *cell)
+{
+	ASSERT (cell->site->live_samples > 0);
+
+	cell->site->live_bytes -= cell->sampled;
+	cell->site->live_samples--;
+	cell->site = NULL;
+	cell->sampled = 0;
+}
+
 /* -----------------------------------------------------------------------------
  * SEC ALLOCATION
  *
@@ -325,6 +575,9 @@ sec_write_guards (Cell *cell)
 static inline void
 sec_check_guards (Cell *cell)
 {
+	if (sec_hardening () == EGG_SECURE_HARDEN_FAST)
+		return;
+
 #ifdef WITH_VALGRIND
 	VALGRIND_MAKE_MEM_DEFINED (cell->words, sizeof (word_t));
 	VALGRIND_MAKE_MEM_DEFINED (cell->words + cell->n_words - 1, sizeof (word_t));
@@ -333,6 +586,16 @@ sec_check_guards (Cell *cell)
 	ASSERT(((void**)cell->words)[0] == (void*)cell);
 	ASSERT(((void**)cell->words)[cell->n_words - 1] == (void*)cell);
 
+#ifdef G_DISABLE_ASSERT
+	/* Paranoid checks remain even when assertions are compiled out */
+	if (sec_hardening () == EGG_SECURE_HARDEN_PARANOID &&
+	    (((void**)cell->words)[0] != (void*)cell ||
+	     ((void**)cell->words)[cell->n_words - 1] != (void*)cell)) {
+		fprintf (stderr, "secure memory guards have been overwritten\n");
+		abort ();
+	}
+#endif
+
 #ifdef WITH_VALGRIND
 	VALGRIND_MAKE_MEM_NOACCESS (cell->words, sizeof (word_t));
 	VALGRIND_MAKE_MEM_NOACCESS (cell->words + cell->n_words - 1, sizeof (word_t));
@@ -401,6 +664,28 @@ sec_cell_to_memory (Cell *cell)
 	return cell->words + 1;
 }
 
+static inline Cell*
+sec_cell_for_memory (void *memory)
+{
+	word_t *word;
+	Cell *cell;
+
+	word = memory;
+	--word;
+
+#ifdef WITH_VALGRIND
+	VALGRIND_MAKE_MEM_DEFINED (word, sizeof (word_t));
+#endif
+
+	cell = *word;
+
+#ifdef WITH_VALGRIND
+	VALGRIND_MAKE_MEM_NOACCESS (word, sizeof (word_t));
+#endif
+
+	return cell;
+}
+
 static inline int
 sec_is_valid_word (Block *block, word_t *word)
 {
@@ -488,18 +773,39 @@ sec_neighbor_after (Block *block, Cell *cell)
 	return cell;
 }
 
+static inline size_t
+sec_align_lead (Cell *cell,
+                size_t alignment)
+{
+	size_t lead;
+
+	/* Words to skip at the start of the cell, so its memory is aligned */
+	lead = (uintptr_t)(cell->words + 1) & (alignment - 1);
+	if (lead != 0)
+		lead = (alignment - lead) / sizeof (word_t);
+
+	/* The skipped words become a free cell, which needs room for both guards */
+	if (lead == 1)
+		lead += alignment / sizeof (word_t);
+
+	return lead;
+}
+
 static void*
 sec_alloc (Block *block,
            const char *tag,
-           size_t length)
+           size_t length,
+           size_t alignment)
 {
 	Cell *cell, *other;
 	size_t n_words;
+	size_t lead = 0;
 	void *memory;
 
 	ASSERT (block);
 	ASSERT (length);
 	ASSERT (tag);
+	ASSERT (alignment >= sizeof (word_t));
 
 	if (!block->unused_cells)
 		return NULL;
@@ -516,7 +822,11 @@ sec_alloc (Block *block,
 
 	/* Look for a cell of at least our required size */
 	cell = block->unused_cells;
-	while (cell->n_words < n_words) {
+	for (;;) {
+		if (alignment > sizeof (word_t))
+			lead = sec_align_lead (cell, alignment);
+		if (cell->n_words >= n_words + lead)
+			break;
 		cell = cell->next;
 		if (cell == block->unused_cells) {
 			cell = NULL;
@@ -533,6 +843,22 @@ sec_alloc (Block *block,
 	ASSERT (cell->words);
 	sec_check_guards (cell);
 
+	/* Split off the unaligned start of the cell as a separate free cell */
+	if (lead > 0) {
+		other = pool_alloc ();
+		if (!other)
+			return NULL;
+		other->n_words = lead;
+		other->words = cell->words;
+		cell->n_words -= lead;
+		cell->words += lead;
+
+		sec_write_guards (other);
+		sec_write_guards (cell);
+
+		sec_insert_cell_ring (&block->unused_cells, other);
+	}
+
 	/* Steal from the cell if it's too long */
 	if (cell->n_words > n_words + WASTE) {
 		other = pool_alloc ();
@@ -591,12 +917,20 @@ sec_free (Block *block, void *memory)
 #endif
 
 	sec_check_guards (cell);
-	sec_clear_noaccess (memory, 0, cell->requested);
+
+	/* Wipe the entire cell, not only what was last requested */
+	if (sec_hardening () == EGG_SECURE_HARDEN_PARANOID)
+		sec_clear_noaccess (memory, 0, (cell->n_words - 2) * sizeof (word_t));
+	else
+		sec_clear_noaccess (memory, 0, cell->requested);
 
 	sec_check_guards (cell);
 	ASSERT (cell->requested > 0);
 	ASSERT (cell->tag != NULL);
 
+	if (cell->site)
+		sec_profile_release (cell);
+
 	/* Remove from the used cell ring */
 	sec_remove_cell_ring (&block->used_cells, cell);
 
@@ -644,7 +978,7 @@ memcpy_with_vbits (void *dest,
 	int vbits_setup = 0;
 	void *vbits = NULL;
 
-	if (RUNNING_ON_VALGRIND) {
+	if (RUNNING_ON_VALGRIND && sec_hardening () != EGG_SECURE_HARDEN_FAST) {
 		vbits = malloc (length);
 		if (vbits != NULL)
 			vbits_setup = VALGRIND_GET_VBITS (src, vbits, length);
@@ -667,7 +1001,8 @@ static void*
 sec_realloc (Block *block,
              const char *tag,
              void *memory,
-             size_t length)
+             size_t length,
+             size_t alignment)
 {
 	Cell *cell, *other;
 	word_t *word;
@@ -755,7 +1090,7 @@ sec_realloc (Block *block,
 	}
 
 	/* That didn't work, try alloc/free */
-	alloc = sec_alloc (block, tag, length);
+	alloc = sec_alloc (block, tag, length, alignment);
 	if (alloc) {
 		memcpy_with_vbits (alloc, memory, valid);
 		sec_free (block, memory);
@@ -847,19 +1182,47 @@ sec_validate (Block *block)
 
 /* -----------------------------------------------------------------------------
  * LOCKED MEMORY
+ *
+ * Pages come from one of several page sources. The default source maps and
+ * locks ordinary pages. The huge source serves blocks of at least one huge
+ * page from whole huge pages, using explicit hugetlb pages if any are
+ * reserved, otherwise an aligned mapping marked for transparent huge pages.
+ * Smaller blocks, and blocks for which neither can be mapped and locked, get
+ * ordinary pages. The source that served a block is recorded with it. All
+ * sources release pages the same way, as long as the size is the one that
+ * was acquired.
  */
 
+static inline int
+sec_page_source (void)
+{
+	const char *env;
+
+	if (page_source != 0)
+		return page_source;
+
+	env = getenv ("SECMEM_PAGES");
+	if (env == NULL || env[0] == '\0' || strcmp (env, "default") == 0)
+		page_source = EGG_SECURE_PAGES_DEFAULT;
+	else if (strcmp (env, "huge") == 0)
+		page_source = EGG_SECURE_PAGES_HUGE;
+	else {
+		if (egg_secure_warnings)
+			fprintf (stderr, "invalid SECMEM_PAGES source: %s\n", env);
+		page_source = EGG_SECURE_PAGES_DEFAULT;
+	}
+
+	return page_source;
+}
+
 static void*
-sec_acquire_pages (size_t *sz,
-                   const char *during_tag)
+sec_acquire_ordinary_pages (size_t *sz,
+                            int *served,
+                            const char *during_tag)
 {
 	void *pages;
 	unsigned long pgsize;
 
-	ASSERT (sz);
-	ASSERT (*sz);
-	ASSERT (during_tag);
-
 	/* Make sure sz is a multiple of the page size */
 	pgsize = getpagesize ();
 	*sz = (*sz + pgsize -1) & ~(pgsize - 1);
@@ -886,6 +1249,7 @@ sec_acquire_pages (size_t *sz,
 
 	DEBUG_ALLOC ("gkr-secure-memory: new block ", *sz);
 
+	*served = EGG_SECURE_PAGES_DEFAULT;
 	show_warning = 1;
 	return pages;
 
@@ -898,6 +1262,109 @@ sec_acquire_pages (size_t *sz,
 
 }
 
+static size_t
+sec_huge_page_size (void)
+{
+	static size_t huge = 0;
+	unsigned long kb;
+	char line[128];
+	FILE *file;
+
+	if (huge != 0)
+		return huge;
+
+	huge = DEFAULT_HUGE_PAGE_SIZE;
+	file = fopen ("/proc/meminfo", "r");
+	if (file != NULL) {
+		while (fgets (line, sizeof (line), file)) {
+			if (sscanf (line, "Hugepagesize: %lu kB", &kb) == 1) {
+				if (kb > 0)
+					huge = kb * 1024;
+				break;
+			}
+		}
+		fclose (file);
+	}
+
+	return huge;
+}
+
+static void*
+sec_acquire_huge_pages (size_t *sz,
+                        int *served,
+                        const char *during_tag)
+{
+#if defined(HAVE_MLOCK)
+	size_t huge, len;
+	char *pages;
+	char *aligned;
+
+	/* Rounding a smaller block up to a huge page would only waste locked memory */
+	huge = sec_huge_page_size ();
+	if (*sz < huge)
+		return sec_acquire_ordinary_pages (sz, served, during_tag);
+
+	len = (*sz + huge - 1) & ~(huge - 1);
+
+#ifdef MAP_HUGETLB
+	pages = mmap (0, len, PROT_READ | PROT_WRITE,
+	              MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
+	if (pages != MAP_FAILED) {
+		if (mlock (pages, len) == 0) {
+			DEBUG_ALLOC ("gkr-secure-memory: new hugetlb block ", len);
+			*served = EGG_SECURE_PAGES_HUGE;
+			*sz = len;
+			return pages;
+		}
+		munmap (pages, len);
+	}
+#endif
+
+#ifdef MADV_HUGEPAGE
+	/* Transparent huge pages need an aligned mapping, so map extra and trim */
+	pages = mmap (0, len + huge, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+	if (pages != MAP_FAILED) {
+		aligned = (char *)(((uintptr_t)pages + huge - 1) & ~((uintptr_t)huge - 1));
+		if (aligned != pages)
+			munmap (pages, aligned - pages);
+		if (aligned + len != pages + len + huge)
+			munmap (aligned + len, (pages + len + huge) - (aligned + len));
+
+		madvise (aligned, len, MADV_HUGEPAGE);
+		if (mlock (aligned, len) == 0) {
+			DEBUG_ALLOC ("gkr-secure-memory: new huge block ", len);
+			*served = EGG_SECURE_PAGES_HUGE;
+			*sz = len;
+			return aligned;
+		}
+		munmap (aligned, len);
+	}
+#endif
+
+#endif /* HAVE_MLOCK */
+
+	/* Probably over the locked memory limit, try something smaller */
+	return sec_acquire_ordinary_pages (sz, served, during_tag);
+}
+
+static void*
+sec_acquire_pages (size_t *sz,
+                   int *served,
+                   const char *during_tag)
+{
+	ASSERT (sz);
+	ASSERT (*sz);
+	ASSERT (served);
+	ASSERT (during_tag);
+
+	switch (sec_page_source ()) {
+	case EGG_SECURE_PAGES_HUGE:
+		return sec_acquire_huge_pages (sz, served, during_tag);
+	default:
+		return sec_acquire_ordinary_pages (sz, served, during_tag);
+	}
+}
+
 static void
 sec_release_pages (void *pages, size_t sz)
 {
@@ -923,6 +1390,7 @@ sec_release_pages (void *pages, size_t sz)
  */
 
 static Block *all_blocks = NULL;
+static unsigned long block_serial = 0;
 
 static Block*
 sec_block_create (size_t size,
@@ -951,7 +1419,7 @@ sec_block_create (size_t size,
 	if (size < DEFAULT_BLOCK_SIZE)
 		size = DEFAULT_BLOCK_SIZE;
 
-	block->words = sec_acquire_pages (&size, during_tag);
+	block->words = sec_acquire_pages (&size, &block->pages, during_tag);
 	block->n_words = size / sizeof (word_t);
 	if (!block->words) {
 		pool_free (block);
@@ -970,12 +1438,27 @@ sec_block_create (size_t size,
 	sec_write_guards (cell);
 	sec_insert_cell_ring (&block->unused_cells, cell);
 
+	block->serial = ++block_serial;
 	block->next = all_blocks;
 	all_blocks = block;
 
 	return block;
 }
 
+static Block *
+sec_block_after (unsigned long cursor)
+{
+	Block *block;
+
+	/* Blocks are prepended, so serials decrease along the list */
+	for (block = all_blocks; block; block = block->next) {
+		if (cursor == 0 || block->serial < cursor)
+			return block;
+	}
+
+	return NULL;
+}
+
 static void
 sec_block_destroy (Block *block)
 {
@@ -1015,17 +1498,37 @@ sec_block_destroy (Block *block)
  * PUBLIC FUNCTIONALITY
  */
 
-void*
-egg_secure_alloc_full (const char *tag,
-                       size_t length,
-                       int flags)
+static void
+sec_profile_report_if_requested (void)
+{
+	if (profile_requested) {
+		profile_requested = 0;
+		egg_secure_profile_print ();
+	}
+}
+
+static void*
+sec_alloc_full (const char *tag,
+                size_t length,
+                size_t alignment,
+                int flags,
+                void *caller)
 {
 	Block *block;
+	size_t size;
 	void *memory = NULL;
 
 	if (tag == NULL)
 		tag = "?";
 
+	/* Must be a power of two, word alignment is always given */
+	if (alignment & (alignment - 1)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (alignment < sizeof (word_t))
+		alignment = sizeof (word_t);
+
 	if (length > 0xFFFFFFFF / 2) {
 		if (egg_secure_warnings)
 			fprintf (stderr, "tried to allocate an insane amount of memory: %lu\n",
@@ -1040,18 +1543,30 @@ egg_secure_alloc_full (const char *tag,
 	DO_LOCK ();
 
 		for (block = all_blocks; block; block = block->next) {
-			memory = sec_alloc (block, tag, length);
+			memory = sec_alloc (block, tag, length, alignment);
 			if (memory)
 				break;
 		}
 
 		/* None of the current blocks have space, allocate new */
 		if (!memory) {
-			block = sec_block_create (length, tag);
+			/* Room for the guards on either side of the memory */
+			size = (sec_size_to_words (length) + 2) * sizeof (word_t);
+
+			/* And for the longest lead that sec_align_lead() can skip */
+			if (alignment > sizeof (word_t))
+				size += alignment + sizeof (word_t);
+			block = sec_block_create (size, tag);
 			if (block)
-				memory = sec_alloc (block, tag, length);
+				memory = sec_alloc (block, tag, length, alignment);
 		}
 
+		if (memory && sec_profiling ())
+			sec_profile_sample (sec_cell_for_memory (memory), caller);
+
+		if (memory && sec_hardening () == EGG_SECURE_HARDEN_PARANOID)
+			sec_validate (block);
+
 #ifdef WITH_VALGRIND
 		if (memory != NULL)
 			VALGRIND_MALLOCLIKE_BLOCK (memory, length, sizeof (void*), 1);
@@ -1059,8 +1574,22 @@ egg_secure_alloc_full (const char *tag,
 
 	DO_UNLOCK ();
 
+	if (profile_interval)
+		sec_profile_report_if_requested ();
+
 	if (!memory && (flags & EGG_SECURE_USE_FALLBACK) && EGG_SECURE_GLOBALS.fallback != NULL) {
 		memory = EGG_SECURE_GLOBALS.fallback (NULL, length);
+
+		/*
+		 * The fallback cannot be asked for alignment. Beyond what malloc()
+		 * usually gives, a realloc() could lose it later, so don't try.
+		 */
+		if (memory && (alignment > FALLBACK_ALIGNMENT ||
+		               ((uintptr_t)memory & (alignment - 1)))) {
+			EGG_SECURE_GLOBALS.fallback (memory, 0);
+			memory = NULL;
+		}
+
 		if (memory) /* Our returned memory is always zeroed */
 			memset (memory, 0, length);
 	}
@@ -1072,12 +1601,32 @@ egg_secure_alloc_full (const char *tag,
 }
 
 void*
-egg_secure_realloc_full (const char *tag,
-                         void *memory,
-                         size_t length,
-                         int flags)
+egg_secure_alloc_full (const char *tag,
+                       size_t length,
+                       int flags)
+{
+	return sec_alloc_full (tag, length, sizeof (word_t), flags, SEC_CALLER ());
+}
+
+void*
+egg_secure_alloc_aligned_full (const char *tag,
+                               size_t length,
+                               size_t alignment,
+                               int flags)
+{
+	return sec_alloc_full (tag, length, alignment, flags, SEC_CALLER ());
+}
+
+static void*
+sec_realloc_full (const char *tag,
+                  void *memory,
+                  size_t length,
+                  size_t alignment,
+                  int flags,
+                  void *caller)
 {
 	Block *block = NULL;
+	Cell *cell;
 	size_t previous = 0;
 	int donew = 0;
 	void *alloc = NULL;
@@ -1085,6 +1634,13 @@ egg_secure_realloc_full (const char *tag,
 	if (tag == NULL)
 		tag = "?";
 
+	if (alignment & (alignment - 1)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (alignment < sizeof (word_t))
+		alignment = sizeof (word_t);
+
 	if (length > 0xFFFFFFFF / 2) {
 		if (egg_secure_warnings)
 			fprintf (stderr, "tried to allocate an insane amount of memory: %lu\n",
@@ -1093,7 +1649,7 @@ egg_secure_realloc_full (const char *tag,
 	}
 
 	if (memory == NULL)
-		return egg_secure_alloc_full (tag, length, flags);
+		return sec_alloc_full (tag, length, alignment, flags, caller);
 	if (!length) {
 		egg_secure_free_full (memory, flags);
 		return NULL;
@@ -1111,7 +1667,18 @@ egg_secure_realloc_full (const char *tag,
 				VALGRIND_FREELIKE_BLOCK (memory, sizeof (word_t));
 #endif
 
-				alloc = sec_realloc (block, tag, memory, length);
+				/* Sampled again below, at the new length */
+				cell = sec_cell_for_memory (memory);
+				if (cell->site)
+					sec_profile_release (cell);
+
+				alloc = sec_realloc (block, tag, memory, length, alignment);
+
+				if (alloc && sec_profiling ())
+					sec_profile_sample (sec_cell_for_memory (alloc), caller);
+
+				if (sec_hardening () == EGG_SECURE_HARDEN_PARANOID)
+					sec_validate (block);
 
 #ifdef WITH_VALGRIND
 				/* Now tell valgrind about either the new block or old one */
@@ -1149,7 +1716,7 @@ egg_secure_realloc_full (const char *tag,
 	}
 
 	if (donew) {
-		alloc = egg_secure_alloc_full (tag, length, flags);
+		alloc = sec_alloc_full (tag, length, alignment, flags, caller);
 		if (alloc) {
 			memcpy_with_vbits (alloc, memory, previous);
 			egg_secure_free_full (memory, flags);
@@ -1162,6 +1729,25 @@ egg_secure_realloc_full (const char *tag,
 	return alloc;
 }
 
+void*
+egg_secure_realloc_full (const char *tag,
+                         void *memory,
+                         size_t length,
+                         int flags)
+{
+	return sec_realloc_full (tag, memory, length, sizeof (word_t), flags, SEC_CALLER ());
+}
+
+void*
+egg_secure_realloc_aligned_full (const char *tag,
+                                 void *memory,
+                                 size_t length,
+                                 size_t alignment,
+                                 int flags)
+{
+	return sec_realloc_full (tag, memory, length, alignment, flags, SEC_CALLER ());
+}
+
 void
 egg_secure_free (void *memory)
 {
@@ -1194,10 +1780,15 @@ egg_secure_free_full (void *memory, int flags)
 			sec_free (block, memory);
 			if (block->n_used == 0)
 				sec_block_destroy (block);
+			else if (sec_hardening () == EGG_SECURE_HARDEN_PARANOID)
+				sec_validate (block);
 		}
 
 	DO_UNLOCK ();
 
+	if (profile_interval)
+		sec_profile_report_if_requested ();
+
 	if (!block) {
 		if ((flags & EGG_SECURE_USE_FALLBACK) && EGG_SECURE_GLOBALS.fallback) {
 			EGG_SECURE_GLOBALS.fallback (memory, 0);
@@ -1233,6 +1824,9 @@ egg_secure_validate (void)
 {
 	Block *block = NULL;
 
+	if (sec_hardening () == EGG_SECURE_HARDEN_FAST)
+		return;
+
 	DO_LOCK ();
 
 		for (block = all_blocks; block; block = block->next)
@@ -1241,6 +1835,256 @@ egg_secure_validate (void)
 	DO_UNLOCK ();
 }
 
+int
+egg_secure_validate_step (unsigned long *cursor,
+                          unsigned int max_blocks)
+{
+	Block *block;
+	unsigned int n;
+	int done = 0;
+
+	ASSERT (cursor);
+	ASSERT (max_blocks > 0);
+
+	if (sec_hardening () == EGG_SECURE_HARDEN_FAST) {
+		*cursor = 0;
+		return 1;
+	}
+
+	DO_LOCK ();
+
+		/* Pick up after the last block validated */
+		block = sec_block_after (*cursor);
+		for (n = 0; block != NULL && n < max_blocks; n++) {
+			sec_validate (block);
+			*cursor = block->serial;
+			block = block->next;
+		}
+
+		if (block == NULL) {
+			*cursor = 0;
+			done = 1;
+		}
+
+	DO_UNLOCK ();
+
+	return done;
+}
+
+void
+egg_secure_set_hardening (int level)
+{
+	ASSERT (level >= EGG_SECURE_HARDEN_FAST && level <= EGG_SECURE_HARDEN_PARANOID);
+
+	/* A no-op in fast builds, which have no checks to turn on */
+#if EGG_SECURE_DEFAULT_HARDENING != EGG_SECURE_HARDEN_FAST
+	DO_LOCK ();
+
+		hardening = level;
+
+	DO_UNLOCK ();
+#endif
+}
+
+int
+egg_secure_get_hardening (void)
+{
+	int level;
+
+	DO_LOCK ();
+
+		level = sec_hardening ();
+
+	DO_UNLOCK ();
+
+	return level;
+}
+
+void
+egg_secure_set_pages (int source)
+{
+	ASSERT (source >= EGG_SECURE_PAGES_DEFAULT && source <= EGG_SECURE_PAGES_HUGE);
+
+	DO_LOCK ();
+
+		page_source = source;
+
+	DO_UNLOCK ();
+}
+
+int
+egg_secure_get_pages (void)
+{
+	int source;
+
+	DO_LOCK ();
+
+		source = sec_page_source ();
+
+	DO_UNLOCK ();
+
+	return source;
+}
+
+int
+egg_secure_get_pages_for (const void *memory)
+{
+	Block *block = NULL;
+	int source = 0;
+
+	DO_LOCK ();
+
+		/* Find out where it belongs to */
+		for (block = all_blocks; block; block = block->next) {
+			if (sec_is_valid_word (block, (word_t*)memory)) {
+				source = block->pages;
+				break;
+			}
+		}
+
+	DO_UNLOCK ();
+
+	return source;
+}
+
+void
+egg_secure_set_profiling (size_t interval,
+                          unsigned int depth)
+{
+	DO_LOCK ();
+
+		/* Don't read the environment later on, and overwrite this */
+		profile_read = 1;
+		profile_interval = interval;
+		profile_depth = depth > 0 ? depth : 1;
+		profile_countdown = 0;
+
+	DO_UNLOCK ();
+}
+
+size_t
+egg_secure_get_profiling (void)
+{
+	size_t interval;
+
+	DO_LOCK ();
+
+		interval = sec_profiling ();
+
+	DO_UNLOCK ();
+
+	return interval;
+}
+
+static Site *
+sec_profile_next_site (Site *site,
+                       unsigned int *bucket)
+{
+	if (site != NULL && site->next != NULL)
+		return site->next;
+	if (site != NULL)
+		(*bucket)++;
+	for (; *bucket < PROFILE_BUCKETS; (*bucket)++) {
+		if (profile_sites[*bucket] != NULL)
+			return profile_sites[*bucket];
+	}
+	return NULL;
+}
+
+void
+egg_secure_profile_foreach (egg_secure_site_func func,
+                            void *user_data)
+{
+	egg_secure_site rec;
+	unsigned int bucket = 0;
+	Site *site = NULL;
+
+	ASSERT (func);
+
+	DO_LOCK ();
+
+		while ((site = sec_profile_next_site (site, &bucket)) != NULL) {
+			rec.tag = site->tag;
+			rec.frames = site->frames;
+			rec.n_frames = site->n_frames;
+			rec.live_bytes = site->live_bytes;
+			rec.live_samples = site->live_samples;
+			rec.total_bytes = site->total_bytes;
+			if ((func) (&rec, user_data))
+				break;
+		}
+
+	DO_UNLOCK ();
+}
+
+static int
+sec_profile_tag_seen (Site *site)
+{
+	unsigned int bucket = 0;
+	Site *other = NULL;
+
+	/* Whether an earlier site has the same tag */
+	while ((other = sec_profile_next_site (other, &bucket)) != site) {
+		if (strcmp (other->tag, site->tag) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+void
+egg_secure_profile_print (void)
+{
+	unsigned int bucket = 0, other_bucket;
+	size_t live, samples, total;
+	Site *site = NULL, *other;
+#ifndef HAVE_BACKTRACE
+	unsigned int i;
+#endif
+
+	DO_LOCK ();
+
+		fprintf (stderr, "secure memory profile, sampled every %lu bytes\n",
+		         (unsigned long)profile_interval);
+
+		/* Totals for each tag */
+		while ((site = sec_profile_next_site (site, &bucket)) != NULL) {
+			if (sec_profile_tag_seen (site))
+				continue;
+			live = samples = total = 0;
+			other_bucket = 0;
+			other = NULL;
+			while ((other = sec_profile_next_site (other, &other_bucket)) != NULL) {
+				if (strcmp (other->tag, site->tag) == 0) {
+					live += other->live_bytes;
+					samples += other->live_samples;
+					total += other->total_bytes;
+				}
+			}
+			fprintf (stderr, "%-24s %10lu live bytes %8lu samples %12lu total bytes\n",
+			         site->tag, (unsigned long)live, (unsigned long)samples,
+			         (unsigned long)total);
+		}
+
+		/* And for each call site */
+		bucket = 0;
+		while ((site = sec_profile_next_site (site, &bucket)) != NULL) {
+			fprintf (stderr, "\n%-24s %10lu live bytes %8lu samples %12lu total bytes\n",
+			         site->tag, (unsigned long)site->live_bytes,
+			         (unsigned long)site->live_samples,
+			         (unsigned long)site->total_bytes);
+#ifdef HAVE_BACKTRACE
+			fflush (stderr);
+			backtrace_symbols_fd (site->frames, site->n_frames, STDERR_FILENO);
+#else
+			for (i = 0; i < site->n_frames; i++)
+				fprintf (stderr, "    %p\n", site->frames[i]);
+#endif
+		}
+
+		fflush (stderr);
+
+	DO_UNLOCK ();
+}
 
 static egg_secure_rec *
 records_for_ring (Cell *cell_ring,
@@ -1309,6 +2153,57 @@ egg_secure_records (unsigned int *count)
 	return records;
 }
 
+static int
+records_foreach_ring (Cell *cell_ring,
+                      egg_secure_rec_func func,
+                      void *user_data)
+{
+	egg_secure_rec rec;
+	Cell *cell;
+
+	cell = cell_ring;
+	if (cell == NULL)
+		return 0;
+
+	do {
+		rec.request_length = cell->requested;
+		rec.block_length = cell->n_words * sizeof (word_t);
+		rec.tag = cell->tag;
+		if ((func) (&rec, user_data))
+			return 1;
+		cell = cell->next;
+	} while (cell != cell_ring);
+
+	return 0;
+}
+
+void
+egg_secure_records_foreach (egg_secure_rec_func func,
+                            void *user_data)
+{
+	unsigned long cursor = 0;
+	Block *block;
+	int stop = 0;
+
+	ASSERT (func);
+
+	/* Only hold the lock for one block at a time */
+	while (!stop) {
+		DO_LOCK ();
+
+			block = sec_block_after (cursor);
+			if (block == NULL) {
+				stop = 1;
+			} else {
+				cursor = block->serial;
+				stop = records_foreach_ring (block->unused_cells, func, user_data) ||
+				       records_foreach_ring (block->used_cells, func, user_data);
+			}
+
+		DO_UNLOCK ();
+	}
+}
+
 char*
 egg_secure_strdup_full (const char *tag,
                         const char *str,
@@ -1321,7 +2216,7 @@ egg_secure_strdup_full (const char *tag,
 		return NULL;
 
 	len = strlen (str) + 1;
-	res = (char *)egg_secure_alloc_full (tag, len, options);
+	res = (char *)sec_alloc_full (tag, len, sizeof (word_t), options, SEC_CALLER ());
 	strcpy (res, str);
 	return res;
 }
@@ -1343,7 +2238,7 @@ egg_secure_strndup_full (const char *tag,
 	if (end != NULL)
 		length = (end - str);
 	len = length + 1;
-	res = (char *)egg_secure_alloc_full (tag, len, options);
+	res = (char *)sec_alloc_full (tag, len, sizeof (word_t), options, SEC_CALLER ());
 	memcpy (res, str, len);
 	return res;
 }
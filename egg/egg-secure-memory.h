@@ -81,6 +81,12 @@ extern egg_secure_glob EGG_SECURE_GLOBALS;
 	static inline void* egg_secure_realloc (void *p, size_t length) { \
 		return egg_secure_realloc_full (G_STRINGIFY (tag), p, length, EGG_SECURE_USE_FALLBACK); \
 	} \
+	static inline void* egg_secure_alloc_aligned (size_t length, size_t alignment) { \
+		return egg_secure_alloc_aligned_full (G_STRINGIFY (tag), length, alignment, EGG_SECURE_USE_FALLBACK); \
+	} \
+	static inline void* egg_secure_realloc_aligned (void *p, size_t length, size_t alignment) { \
+		return egg_secure_realloc_aligned_full (G_STRINGIFY (tag), p, length, alignment, EGG_SECURE_USE_FALLBACK); \
+	} \
 	static inline void* egg_secure_strdup (const char *str) { \
 		return egg_secure_strdup_full (G_STRINGIFY (tag), str, EGG_SECURE_USE_FALLBACK); \
 	} \
@@ -92,6 +98,22 @@ void*  egg_secure_alloc_full   (const char *tag, size_t length, int options);
 
 void*  egg_secure_realloc_full (const char *tag, void *p, size_t length, int options);
 
+/*
+ * Aligned allocations
+ *
+ * The returned memory is aligned to a multiple of alignment, which must
+ * be a power of two. It keeps its guards and is freed with egg_secure_free()
+ * like any other secure memory. Use the aligned realloc to keep the
+ * alignment if the memory has to move.
+ *
+ * The fallback is only used for alignments up to 16 bytes, when the
+ * memory it returns happens to be aligned.
+ */
+
+void*  egg_secure_alloc_aligned_full   (const char *tag, size_t length, size_t alignment, int options);
+
+void*  egg_secure_realloc_aligned_full (const char *tag, void *p, size_t length, size_t alignment, int options);
+
 void   egg_secure_free         (void* p);
 
 void   egg_secure_free_full    (void* p, int fallback);
@@ -110,6 +132,104 @@ void   egg_secure_strclear     (char *str);
 
 void   egg_secure_strfree      (char *str);
 
+/*
+ * Hardening levels
+ *
+ * How much consistency checking is done on each operation. Memory is
+ * always wiped on free and always locked, regardless of the level.
+ *
+ * FAST: no guard checks, validation or valgrind vbits bookkeeping.
+ * DEFAULT: guards are checked on every allocation, free and realloc.
+ * PARANOID: in addition the whole block is validated after each
+ * operation, and the entire cell is wiped on free.
+ *
+ * The default level is chosen at build time, and can be overridden at
+ * runtime with the SECMEM_HARDENING environment variable, or by calling
+ * egg_secure_set_hardening(). A build with the fast level is the exception:
+ * its checks are compiled out, and the level can't be changed at runtime.
+ * There egg_secure_set_hardening() does nothing, and the environment is
+ * ignored, so egg_secure_get_hardening() always returns FAST.
+ */
+
+#define EGG_SECURE_HARDEN_FAST      1
+#define EGG_SECURE_HARDEN_DEFAULT   2
+#define EGG_SECURE_HARDEN_PARANOID  3
+
+void   egg_secure_set_hardening (int level);
+
+int    egg_secure_get_hardening (void);
+
+/*
+ * Page sources
+ *
+ * Where the locked pages behind secure memory come from. Only blocks
+ * created after a change use the new source.
+ *
+ * DEFAULT: ordinary pages, mapped and locked one block at a time.
+ * HUGE: blocks of at least one huge page are made of huge pages, to reduce
+ * the number of TLB entries and mlock calls used by large amounts of secure
+ * memory. Explicit hugetlb pages are used if the system has any reserved,
+ * then transparent huge pages. Smaller blocks get ordinary pages, as do
+ * blocks for which huge pages can't be locked, for example when they would
+ * exceed the locked memory limit.
+ *
+ * The source can be chosen at runtime with the SECMEM_PAGES environment
+ * variable, set to 'default' or 'huge', or by calling egg_secure_set_pages().
+ * egg_secure_get_pages_for() returns the source that actually served the
+ * block holding some secure memory, or zero if it isn't secure memory.
+ */
+
+#define EGG_SECURE_PAGES_DEFAULT    1
+#define EGG_SECURE_PAGES_HUGE       2
+
+void   egg_secure_set_pages     (int source);
+
+int    egg_secure_get_pages     (void);
+
+int    egg_secure_get_pages_for (const void *memory);
+
+/*
+ * Profiling
+ *
+ * Samples secure allocations about once every interval bytes, and keeps
+ * an estimate of the live and total bytes allocated for each tag and call
+ * site. The call site is the caller of the egg_secure_xxx() function, or
+ * a backtrace of up to depth frames starting there, where supported.
+ * Memory allocated through the fallback is not profiled. An interval of
+ * zero turns profiling off, which is the default.
+ *
+ * Profiling can be turned on at startup with the SECMEM_PROFILE environment
+ * variable set to the interval, and SECMEM_PROFILE_DEPTH. In that case
+ * egg_secure_profile_print() is called after the next allocation or free
+ * following a SIGUSR2, if no other handler was set for it.
+ *
+ * egg_secure_profile_foreach() calls func for each site while holding the
+ * lock. The site is only valid during the callback, and func must not call
+ * into secure memory. Return non-zero from func to stop.
+ */
+
+typedef struct {
+	const char *tag;
+	void * const *frames;
+	unsigned int n_frames;
+	size_t live_bytes;
+	size_t live_samples;
+	size_t total_bytes;
+} egg_secure_site;
+
+typedef int (* egg_secure_site_func) (const egg_secure_site *site,
+                                      void *user_data);
+
+void   egg_secure_set_profiling   (size_t interval,
+                                   unsigned int depth);
+
+size_t egg_secure_get_profiling   (void);
+
+void   egg_secure_profile_foreach (egg_secure_site_func func,
+                                   void *user_data);
+
+void   egg_secure_profile_print   (void);
+
 typedef struct {
 	const char *tag;
 	size_t request_length;
@@ -118,4 +238,27 @@ typedef struct {
 
 egg_secure_rec *   egg_secure_records    (unsigned int *count);
 
+/*
+ * Incremental variants of egg_secure_validate() and egg_secure_records()
+ * which only hold the lock for a bounded amount of work at a time.
+ *
+ * egg_secure_validate_step() validates at most max_blocks blocks after
+ * the one the cursor points to. Start with a cursor of zero. Returns 1
+ * when a full pass is complete, and the cursor is reset to zero.
+ *
+ * egg_secure_records_foreach() calls func for each record, without
+ * copying them, holding the lock one block at a time. The record is only
+ * valid during the callback, and func must not call into secure memory.
+ * Return non-zero from func to stop.
+ */
+
+int    egg_secure_validate_step (unsigned long *cursor,
+                                 unsigned int max_blocks);
+
+typedef int (* egg_secure_rec_func) (const egg_secure_rec *rec,
+                                     void *user_data);
+
+void   egg_secure_records_foreach (egg_secure_rec_func func,
+                                   void *user_data);
+
 #endif /* EGG_SECURE_MEMORY_H */
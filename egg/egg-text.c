@@ -0,0 +1,133 @@
+/*
+ * libsecret
+ *
+ * Copyright (C) 2012 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "egg-text.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define ONES    G_GUINT64_CONSTANT (0x0101010101010101)
+#define HIGHS   G_GUINT64_CONSTANT (0x8080808080808080)
+
+/*
+ * Length of the run of ASCII characters at the start of data, not
+ * counting nul characters, which are not valid in counted text.
+ */
+static gsize
+ascii_prefix (const guchar *data,
+              gsize n_data)
+{
+	gsize i = 0;
+	guint64 word;
+#ifdef __SSE2__
+	__m128i chunk;
+	gint mask;
+
+	for (; i + 16 <= n_data; i += 16) {
+		chunk = _mm_loadu_si128 ((const __m128i *)(data + i));
+		mask = _mm_movemask_epi8 (chunk) |
+		       _mm_movemask_epi8 (_mm_cmpeq_epi8 (chunk, _mm_setzero_si128 ()));
+		if (mask != 0)
+			return i + g_bit_nth_lsf (mask, -1);
+	}
+#endif
+
+	for (; i + 8 <= n_data; i += 8) {
+		memcpy (&word, data + i, 8);
+		if ((word & HIGHS) || ((word - ONES) & ~word & HIGHS))
+			break;
+	}
+
+	for (; i < n_data; i++) {
+		if (data[i] == 0 || data[i] & 0x80)
+			break;
+	}
+
+	return i;
+}
+
+/*
+ * Same result as g_utf8_validate(), but runs of ASCII are checked many
+ * bytes at a time. Each other character is left to g_utf8_validate().
+ */
+gboolean
+egg_text_utf8_validate (const gchar *data,
+                        gssize n_data)
+{
+	const guchar *at;
+	gsize remaining;
+	gsize n_char;
+
+	g_return_val_if_fail (data != NULL || n_data == 0, FALSE);
+
+	if (n_data < 0)
+		n_data = strlen (data);
+
+	at = (const guchar *)data;
+	remaining = n_data;
+
+	for (;;) {
+		n_char = ascii_prefix (at, remaining);
+		at += n_char;
+		remaining -= n_char;
+		if (remaining == 0)
+			return TRUE;
+
+		n_char = MIN ((gsize)g_utf8_skip[*at], remaining);
+		if (!g_utf8_validate ((const gchar *)at, n_char, NULL))
+			return FALSE;
+		at += n_char;
+		remaining -= n_char;
+	}
+}
+
+/*
+ * Whether the whole string parses with g_ascii_strtoll() in base 10:
+ * optional leading space, an optional sign and then digits. Like the
+ * parser, the empty string is accepted and overflow is not checked.
+ */
+gboolean
+egg_text_decimal_validate (const gchar *data)
+{
+	const gchar *at;
+
+	g_return_val_if_fail (data != NULL, FALSE);
+
+	if (data[0] == '\0')
+		return TRUE;
+
+	at = data;
+	while (g_ascii_isspace (*at))
+		at++;
+	if (*at == '-' || *at == '+')
+		at++;
+	if (!g_ascii_isdigit (*at))
+		return FALSE;
+	while (g_ascii_isdigit (*at))
+		at++;
+
+	return *at == '\0';
+}
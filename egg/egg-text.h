@@ -0,0 +1,32 @@
+/*
+ * libsecret
+ *
+ * Copyright (C) 2012 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef EGG_TEXT_H_
+#define EGG_TEXT_H_
+
+#include <glib.h>
+
+gboolean              egg_text_utf8_validate                 (const gchar *data,
+                                                              gssize n_data);
+
+gboolean              egg_text_decimal_validate              (const gchar *data);
+
+#endif /* EGG_TEXT_H_ */
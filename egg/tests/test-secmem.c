@@ -151,6 +151,117 @@ test_realloc (void)
 	g_assert (p == NULL);
 }
 
+static void
+test_alloc_aligned_block (void)
+{
+	gsize alignments[] = { 16, 32, 64, 4096 };
+	gsize lengths[] = { 16352, 16384 };
+	gpointer p;
+	guint i, j;
+
+	/* Near the size of a new block, which must fit the guards and the lead */
+	for (i = 0; i < G_N_ELEMENTS (alignments); i++) {
+		for (j = 0; j < G_N_ELEMENTS (lengths); j++) {
+			p = egg_secure_alloc_aligned_full ("tests", lengths[j], alignments[i], 0);
+			g_assert (p != NULL);
+			g_assert_cmpuint ((gsize)p % alignments[i], ==, 0);
+			g_assert_cmpint (G_MAXSIZE, ==, find_non_zero (p, lengths[j]));
+			egg_secure_validate ();
+			egg_secure_free_full (p, 0);
+		}
+	}
+}
+
+static void
+test_alloc_aligned (void)
+{
+	gsize alignments[] = { 16, 32, 64, 4096 };
+	gpointer p, p2, small;
+	guint i;
+
+	/* Not a power of two */
+	p = egg_secure_alloc_aligned_full ("tests", 64, 24, 0);
+	g_assert (p == NULL);
+
+	for (i = 0; i < G_N_ELEMENTS (alignments); i++) {
+
+		/* Throw off the alignment of the next free cell */
+		small = egg_secure_alloc_full ("tests", 8, 0);
+		g_assert (small != NULL);
+
+		p = egg_secure_alloc_aligned_full ("tests", 100, alignments[i], 0);
+		g_assert (p != NULL);
+		g_assert_cmpuint ((gsize)p % alignments[i], ==, 0);
+		g_assert_cmpint (G_MAXSIZE, ==, find_non_zero (p, 100));
+		g_assert (egg_secure_check (p));
+
+		memset (p, 0x67, 100);
+
+		/* Grows past its neighbor, so has to move */
+		p2 = egg_secure_alloc_full ("tests", 8, 0);
+		p = egg_secure_realloc_aligned_full ("tests", p, 16200, alignments[i], 0);
+		g_assert (p != NULL);
+		g_assert_cmpuint ((gsize)p % alignments[i], ==, 0);
+		g_assert_cmpint (find_non_zero (p, 100), ==, 0);
+		g_assert_cmpint (G_MAXSIZE, ==, find_non_zero ((gchar *)p + 100, 16100));
+
+		/* Freed like any other secure memory */
+		egg_secure_free_full (p, 0);
+		egg_secure_free_full (p2, 0);
+		egg_secure_free_full (small, 0);
+		egg_secure_validate ();
+	}
+}
+
+static int
+on_profile_site (const egg_secure_site *site,
+                 gpointer user_data)
+{
+	gsize *live = user_data;
+
+	g_assert (site->n_frames > 0);
+	g_assert (site->frames[0] != NULL);
+	if (g_str_equal (site->tag, "profiled"))
+		*live += site->live_bytes;
+	return 0;
+}
+
+static gsize
+profiled_live_bytes (void)
+{
+	gsize live = 0;
+	egg_secure_profile_foreach (on_profile_site, &live);
+	return live;
+}
+
+static void
+test_profile (void)
+{
+	gpointer p, p2;
+
+	/* Sample every allocation, so the estimates are exact */
+	egg_secure_set_profiling (1, 4);
+	g_assert_cmpuint (egg_secure_get_profiling (), ==, 1);
+
+	p = egg_secure_alloc_full ("profiled", 100, 0);
+	p2 = egg_secure_alloc_full ("profiled", 50, 0);
+	g_assert_cmpuint (profiled_live_bytes (), ==, 150);
+
+	p = egg_secure_realloc_full ("profiled", p, 16200, 0);
+	g_assert_cmpuint (profiled_live_bytes (), ==, 16250);
+
+	egg_secure_free_full (p2, 0);
+	g_assert_cmpuint (profiled_live_bytes (), ==, 16200);
+	egg_secure_free_full (p, 0);
+	g_assert_cmpuint (profiled_live_bytes (), ==, 0);
+
+	/* Nothing recorded when off */
+	egg_secure_set_profiling (0, 0);
+	p = egg_secure_alloc_full ("profiled", 100, 0);
+	g_assert_cmpuint (profiled_live_bytes (), ==, 0);
+	egg_secure_free_full (p, 0);
+}
+
 static void
 test_multialloc (void)
 {
@@ -218,6 +329,181 @@ test_multialloc (void)
 	egg_secure_warnings = 1;
 }
 
+#if EGG_SECURE_DEFAULT_HARDENING == EGG_SECURE_HARDEN_FAST
+
+static void
+test_hardening_fixed (void)
+{
+	gpointer p;
+
+	/* The checks were compiled out, so the level can't be raised */
+	egg_secure_set_hardening (EGG_SECURE_HARDEN_PARANOID);
+	g_assert_cmpint (egg_secure_get_hardening (), ==, EGG_SECURE_HARDEN_FAST);
+
+	p = egg_secure_alloc_full ("tests", 64, 0);
+	g_assert (p != NULL);
+	g_assert_cmpint (find_non_zero (p, 64), ==, G_MAXSIZE);
+	egg_secure_validate ();
+	egg_secure_free_full (p, 0);
+}
+
+#else /* EGG_SECURE_DEFAULT_HARDENING != EGG_SECURE_HARDEN_FAST */
+
+static void
+test_hardening (void)
+{
+	gpointer p, q;
+	int level, previous;
+
+	previous = egg_secure_get_hardening ();
+
+	for (level = EGG_SECURE_HARDEN_FAST; level <= EGG_SECURE_HARDEN_PARANOID; level++) {
+		egg_secure_set_hardening (level);
+		g_assert_cmpint (egg_secure_get_hardening (), ==, level);
+
+		p = egg_secure_alloc_full ("tests", 64, 0);
+		g_assert (p != NULL);
+		g_assert_cmpint (find_non_zero (p, 64), ==, G_MAXSIZE);
+		memset (p, 0x67, 64);
+
+		q = egg_secure_alloc_full ("tests", 32, 0);
+		g_assert (q != NULL);
+
+		p = egg_secure_realloc_full ("tests", p, 4096, 0);
+		g_assert (p != NULL);
+		g_assert_cmpint (find_non_zero (((gchar*)p) + 64, 4096 - 64), ==, G_MAXSIZE);
+
+		egg_secure_validate ();
+
+		egg_secure_free_full (q, 0);
+		egg_secure_free_full (p, 0);
+	}
+
+	egg_secure_set_hardening (previous);
+}
+
+#endif /* EGG_SECURE_DEFAULT_HARDENING != EGG_SECURE_HARDEN_FAST */
+
+static void
+test_pages (void)
+{
+	gpointer p, q;
+	int source, previous;
+
+	previous = egg_secure_get_pages ();
+
+	for (source = EGG_SECURE_PAGES_DEFAULT; source <= EGG_SECURE_PAGES_HUGE; source++) {
+		egg_secure_set_pages (source);
+		g_assert_cmpint (egg_secure_get_pages (), ==, source);
+
+		p = egg_secure_alloc_full ("tests", 64, 0);
+		g_assert (p != NULL);
+		g_assert_cmpint (find_non_zero (p, 64), ==, G_MAXSIZE);
+		memset (p, 0x67, 64);
+
+		/* Bigger than a default block, so new pages are acquired */
+		q = egg_secure_alloc_full ("tests", 65536, 0);
+		g_assert (q != NULL);
+		g_assert_cmpint (find_non_zero (q, 65536), ==, G_MAXSIZE);
+		memset (q, 0x67, 65536);
+
+		/* But smaller than a huge page, so always ordinary pages */
+		g_assert_cmpint (egg_secure_get_pages_for (q), ==, EGG_SECURE_PAGES_DEFAULT);
+
+		egg_secure_validate ();
+
+		egg_secure_free_full (q, 0);
+		egg_secure_free_full (p, 0);
+	}
+
+	egg_secure_set_pages (previous);
+
+	g_assert_cmpint (egg_secure_get_pages_for (&source), ==, 0);
+}
+
+#if EGG_SECURE_DEFAULT_HARDENING != EGG_SECURE_HARDEN_FAST
+
+static void
+test_validate_step (void)
+{
+	gpointer memory[64];
+	unsigned long cursor = 0;
+	int i, steps, previous;
+
+	/* Fast hardening skips validation entirely */
+	previous = egg_secure_get_hardening ();
+	egg_secure_set_hardening (EGG_SECURE_HARDEN_DEFAULT);
+
+	/* Large enough that each one needs its own block */
+	for (i = 0; i < G_N_ELEMENTS (memory); i++) {
+		memory[i] = egg_secure_alloc_full ("tests", 16384, 0);
+		g_assert (memory[i] != NULL);
+	}
+
+	for (steps = 1; !egg_secure_validate_step (&cursor, 4); steps++)
+		g_assert (cursor != 0);
+	g_assert_cmpuint (cursor, ==, 0);
+	g_assert_cmpint (steps, >=, G_N_ELEMENTS (memory) / 4);
+
+	/* Blocks going away between steps doesn't confuse the cursor */
+	g_assert (!egg_secure_validate_step (&cursor, 8));
+	for (i = 0; i < G_N_ELEMENTS (memory); i++)
+		egg_secure_free_full (memory[i], 0);
+	while (!egg_secure_validate_step (&cursor, 8));
+	g_assert_cmpuint (cursor, ==, 0);
+
+	egg_secure_set_hardening (previous);
+}
+
+#endif /* EGG_SECURE_DEFAULT_HARDENING != EGG_SECURE_HARDEN_FAST */
+
+static int
+on_count_record (const egg_secure_rec *rec,
+                 void *user_data)
+{
+	guint *count = user_data;
+
+	g_assert (rec != NULL);
+	g_assert_cmpuint (rec->request_length, <=, rec->block_length);
+	(*count)++;
+	return 0;
+}
+
+static int
+on_stop_record (const egg_secure_rec *rec,
+                void *user_data)
+{
+	guint *count = user_data;
+	(*count)++;
+	return 1;
+}
+
+static void
+test_records_foreach (void)
+{
+	egg_secure_rec *records;
+	gpointer p, q;
+	guint count, streamed;
+
+	p = egg_secure_alloc_full ("tests", 64, 0);
+	q = egg_secure_alloc_full ("tests", 20000, 0);
+
+	records = egg_secure_records (&count);
+	g_assert (records != NULL);
+	free (records);
+
+	streamed = 0;
+	egg_secure_records_foreach (on_count_record, &streamed);
+	g_assert_cmpuint (streamed, ==, count);
+
+	streamed = 0;
+	egg_secure_records_foreach (on_stop_record, &streamed);
+	g_assert_cmpuint (streamed, ==, 1);
+
+	egg_secure_free_full (p, 0);
+	egg_secure_free_full (q, 0);
+}
+
 static void
 test_clear (void)
 {
@@ -260,7 +546,20 @@ main (int argc, char **argv)
 	g_test_add_func ("/secmem/realloc_across", test_realloc_across);
 	g_test_add_func ("/secmem/alloc_two", test_alloc_two);
 	g_test_add_func ("/secmem/realloc", test_realloc);
+	g_test_add_func ("/secmem/alloc_aligned", test_alloc_aligned);
+	g_test_add_func ("/secmem/alloc_aligned_block", test_alloc_aligned_block);
 	g_test_add_func ("/secmem/multialloc", test_multialloc);
+#if EGG_SECURE_DEFAULT_HARDENING == EGG_SECURE_HARDEN_FAST
+	g_test_add_func ("/secmem/hardening_fixed", test_hardening_fixed);
+#else
+	g_test_add_func ("/secmem/hardening", test_hardening);
+#endif
+	g_test_add_func ("/secmem/pages", test_pages);
+	g_test_add_func ("/secmem/profile", test_profile);
+#if EGG_SECURE_DEFAULT_HARDENING != EGG_SECURE_HARDEN_FAST
+	g_test_add_func ("/secmem/validate_step", test_validate_step);
+#endif
+	g_test_add_func ("/secmem/records_foreach", test_records_foreach);
 	g_test_add_func ("/secmem/clear", test_clear);
 	g_test_add_func ("/secmem/strclear", test_strclear);
 
@@ -0,0 +1,111 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/* libsecret - GLib wrapper for Secret Service
+ *
+ * Copyright 2012 Red Hat Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ */
+
+#include "config.h"
+
+#include "egg/egg-text.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const gchar *UTF8_SAMPLES[] = {
+	"",
+	"password",
+	"a long plain ASCII password, long enough for a few vector loops",
+	"caf\xc3\xa9",
+	"\xe2\x82\xac uro",
+	"\xf0\x9f\x94\x91 key",
+	"\xc3\x28",             /* Bad continuation */
+	"\xc0\xaf",             /* Overlong */
+	"\xed\xa0\x80",         /* Surrogate */
+	"\xf4\x90\x80\x80",     /* Beyond U+10FFFF */
+	"\xe2\x82",             /* Truncated */
+	"\x80 stray",
+	"\xff",
+};
+
+static void
+test_utf8 (void)
+{
+	gsize len;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (UTF8_SAMPLES); i++) {
+		len = strlen (UTF8_SAMPLES[i]);
+		g_assert_cmpint (egg_text_utf8_validate (UTF8_SAMPLES[i], -1), ==,
+		                 g_utf8_validate (UTF8_SAMPLES[i], -1, NULL));
+		g_assert_cmpint (egg_text_utf8_validate (UTF8_SAMPLES[i], len), ==,
+		                 g_utf8_validate (UTF8_SAMPLES[i], len, NULL));
+	}
+}
+
+static void
+test_utf8_every_offset (void)
+{
+	gchar buffer[80];
+	gsize i;
+
+	/* A multibyte, invalid or nul character at each offset of an ASCII run */
+	for (i = 0; i + 2 < sizeof (buffer); i++) {
+		memset (buffer, 'x', sizeof (buffer));
+
+		memcpy (buffer + i, "\xc3\xa9", 2);
+		g_assert (egg_text_utf8_validate (buffer, sizeof (buffer)));
+
+		buffer[i + 1] = 'x';
+		g_assert (!egg_text_utf8_validate (buffer, sizeof (buffer)));
+
+		buffer[i] = '\0';
+		g_assert (!egg_text_utf8_validate (buffer, sizeof (buffer)));
+		g_assert (egg_text_utf8_validate (buffer, -1));
+	}
+
+	/* Cut off in the middle of a character */
+	memset (buffer, 'x', sizeof (buffer));
+	memcpy (buffer + 30, "\xe2\x82\xac", 3);
+	g_assert (egg_text_utf8_validate (buffer, 33));
+	g_assert (!egg_text_utf8_validate (buffer, 32));
+}
+
+static void
+test_decimal (void)
+{
+	const gchar *valid[] = { "0", "42", "-42", "+7", " 12", "", "99999999999999999999" };
+	const gchar *invalid[] = { " ", "-", "12a", "12 ", "1.5", "0x10", "a" };
+	gchar *end;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (valid); i++) {
+		g_assert (egg_text_decimal_validate (valid[i]));
+		g_ascii_strtoll (valid[i], &end, 10);
+		g_assert (end[0] == '\0');
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (invalid); i++) {
+		g_assert (!egg_text_decimal_validate (invalid[i]));
+		g_ascii_strtoll (invalid[i], &end, 10);
+		g_assert (end[0] != '\0');
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/text/utf8", test_utf8);
+	g_test_add_func ("/text/utf8_every_offset", test_utf8_every_offset);
+	g_test_add_func ("/text/decimal", test_decimal);
+
+	return g_test_run ();
+}
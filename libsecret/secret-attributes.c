@@ -17,6 +17,8 @@
 #include "secret-attributes.h"
 #include "secret-private.h"
 
+#include "egg/egg-text.h"
+
 #include <string.h>
 
 /**
@@ -169,7 +171,7 @@ secret_attributes_buildv (const SecretSchema *schema,
 				g_critical ("The value for attribute '%s' was NULL", attribute_name);
 				return NULL;
 			}
-			if (!g_utf8_validate (string, -1, NULL)) {
+			if (!egg_text_utf8_validate (string, -1)) {
 				g_critical ("The value for attribute '%s' was not a valid UTF-8 string.", attribute_name);
 				g_hash_table_unref (attributes);
 				return NULL;
@@ -203,7 +205,6 @@ _secret_attributes_validate (const SecretSchema *schema,
 	gboolean any;
 	gchar *key;
 	gchar *value;
-	gchar *end;
 	gint i;
 
 	g_return_val_if_fail (schema != NULL, FALSE);
@@ -254,16 +255,14 @@ _secret_attributes_validate (const SecretSchema *schema,
 			}
 			break;
 		case SECRET_SCHEMA_ATTRIBUTE_INTEGER:
-			end = NULL;
-			g_ascii_strtoll (value, &end, 10);
-			if (!end || end[0] != '\0') {
+			if (!egg_text_decimal_validate (value)) {
 				g_warning ("%s: invalid %s integer value for %s schema: %s",
 				           pretty_function, key, schema->name, value);
 				return FALSE;
 			}
 			break;
 		case SECRET_SCHEMA_ATTRIBUTE_STRING:
-			if (!g_utf8_validate (value, -1, NULL)) {
+			if (!egg_text_utf8_validate (value, -1)) {
 				g_warning ("%s: invalid %s string value for %s schema: %s",
 				           pretty_function, key, schema->name, value);
 				return FALSE;
@@ -305,3 +304,325 @@ _secret_attributes_copy (GHashTable *attributes)
 
 	return copy;
 }
+
+/*
+ * An immutable set of attributes, sorted by name and stored contiguously,
+ * with the hash of each attribute computed up front. Comparing two sets
+ * is a single merge-style pass. A set made from an a{ss} variant borrows
+ * the strings in the variant, rather than copying them.
+ */
+
+typedef struct {
+	const gchar *name;
+	const gchar *value;
+	guint name_hash;
+	guint hash;
+} SecretAttribute;
+
+struct _SecretAttributeSet {
+	gint refs;
+	guint n_attributes;
+	GVariant *variant;
+	SecretAttribute attributes[1];
+};
+
+static gint
+attribute_compare (gconstpointer a,
+                   gconstpointer b,
+                   gpointer user_data)
+{
+	const SecretAttribute *aa = a;
+	const SecretAttribute *ab = b;
+	return strcmp (aa->name, ab->name);
+}
+
+static SecretAttributeSet *
+attribute_set_alloc (guint n_attributes,
+                     gsize n_strings)
+{
+	SecretAttributeSet *set;
+	gsize size;
+
+	size = G_STRUCT_OFFSET (SecretAttributeSet, attributes) +
+	       sizeof (SecretAttribute) * MAX (n_attributes, 1) + n_strings;
+	set = g_malloc (size);
+	set->refs = 1;
+	set->n_attributes = 0;
+	set->variant = NULL;
+	return set;
+}
+
+static void
+attribute_set_add (SecretAttributeSet *set,
+                   const gchar *name,
+                   const gchar *value)
+{
+	SecretAttribute *attr;
+
+	attr = set->attributes + set->n_attributes++;
+	attr->name = name;
+	attr->value = value;
+	attr->name_hash = g_str_hash (name);
+	attr->hash = (attr->name_hash * 33) ^ g_str_hash (value);
+}
+
+static void
+attribute_set_sort (SecretAttributeSet *set)
+{
+	guint i, n;
+
+	/* A stable sort, so repeated names keep their order */
+	g_qsort_with_data (set->attributes, set->n_attributes, sizeof (SecretAttribute),
+	                   attribute_compare, NULL);
+
+	/* When a name is repeated, the last value wins like in a hash table */
+	for (i = 0, n = 0; i < set->n_attributes; i++) {
+		if (n > 0 && set->attributes[n - 1].name_hash == set->attributes[i].name_hash &&
+		    g_str_equal (set->attributes[n - 1].name, set->attributes[i].name))
+			n--;
+		set->attributes[n++] = set->attributes[i];
+	}
+	set->n_attributes = n;
+}
+
+SecretAttributeSet *
+_secret_attribute_set_new (GHashTable *attributes,
+                           const gchar *schema_name)
+{
+	SecretAttributeSet *set;
+	GHashTableIter iter;
+	const gchar *name;
+	const gchar *value;
+	gsize n_strings = 0;
+	guint n_attributes;
+	gchar *strings;
+	gsize len;
+
+	g_return_val_if_fail (attributes != NULL, NULL);
+
+	/* Measure first, so the strings go in the same allocation */
+	g_hash_table_iter_init (&iter, attributes);
+	while (g_hash_table_iter_next (&iter, (gpointer *)&name, (gpointer *)&value))
+		n_strings += strlen (name) + strlen (value) + 2;
+	n_attributes = g_hash_table_size (attributes);
+	if (schema_name) {
+		n_strings += strlen (schema_name) + 1;
+		n_attributes++;
+	}
+
+	set = attribute_set_alloc (n_attributes, n_strings);
+	strings = (gchar *)(set->attributes + MAX (n_attributes, 1));
+
+	/* As in _secret_attributes_to_variant() */
+	g_hash_table_iter_init (&iter, attributes);
+	while (g_hash_table_iter_next (&iter, (gpointer *)&name, (gpointer *)&value)) {
+		if (schema_name && g_str_equal (name, "xdg:schema"))
+			continue;
+		len = strlen (name) + 1;
+		memcpy (strings, name, len);
+		name = strings;
+		strings += len;
+		len = strlen (value) + 1;
+		memcpy (strings, value, len);
+		attribute_set_add (set, name, strings);
+		strings += len;
+	}
+
+	if (schema_name) {
+		len = strlen (schema_name) + 1;
+		memcpy (strings, schema_name, len);
+		attribute_set_add (set, "xdg:schema", strings);
+	}
+
+	attribute_set_sort (set);
+	return set;
+}
+
+SecretAttributeSet *
+_secret_attribute_set_new_for_variant (GVariant *variant)
+{
+	SecretAttributeSet *set;
+	GVariantIter iter;
+	const gchar *name;
+	const gchar *value;
+
+	g_return_val_if_fail (variant != NULL, NULL);
+	g_return_val_if_fail (g_variant_is_of_type (variant, G_VARIANT_TYPE ("a{ss}")), NULL);
+
+	set = attribute_set_alloc (g_variant_n_children (variant), 0);
+	set->variant = g_variant_ref_sink (variant);
+
+	/* The strings stay valid as long as the variant is held */
+	g_variant_iter_init (&iter, variant);
+	while (g_variant_iter_next (&iter, "{&s&s}", &name, &value))
+		attribute_set_add (set, name, value);
+
+	attribute_set_sort (set);
+	return set;
+}
+
+SecretAttributeSet *
+_secret_attribute_set_ref (SecretAttributeSet *set)
+{
+	g_return_val_if_fail (set != NULL, NULL);
+	g_atomic_int_inc (&set->refs);
+	return set;
+}
+
+void
+_secret_attribute_set_unref (gpointer data)
+{
+	SecretAttributeSet *set = data;
+
+	if (set != NULL && g_atomic_int_dec_and_test (&set->refs)) {
+		if (set->variant)
+			g_variant_unref (set->variant);
+		g_free (set);
+	}
+}
+
+guint
+_secret_attribute_set_size (SecretAttributeSet *set)
+{
+	g_return_val_if_fail (set != NULL, 0);
+	return set->n_attributes;
+}
+
+const gchar *
+_secret_attribute_set_lookup (SecretAttributeSet *set,
+                              const gchar *name)
+{
+	guint lo, hi, mid;
+	gint res;
+
+	g_return_val_if_fail (set != NULL, NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	lo = 0;
+	hi = set->n_attributes;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		res = strcmp (name, set->attributes[mid].name);
+		if (res == 0)
+			return set->attributes[mid].value;
+		else if (res < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return NULL;
+}
+
+GVariant *
+_secret_attribute_set_to_variant (SecretAttributeSet *set)
+{
+	GVariantBuilder builder;
+	guint i;
+
+	g_return_val_if_fail (set != NULL, NULL);
+
+	if (set->variant && set->n_attributes == g_variant_n_children (set->variant))
+		return g_variant_ref (set->variant);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{ss}"));
+	for (i = 0; i < set->n_attributes; i++)
+		g_variant_builder_add (&builder, "{ss}", set->attributes[i].name,
+		                       set->attributes[i].value);
+
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+GHashTable *
+_secret_attribute_set_to_table (SecretAttributeSet *set)
+{
+	GHashTable *attributes;
+	guint i;
+
+	g_return_val_if_fail (set != NULL, NULL);
+
+	attributes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	for (i = 0; i < set->n_attributes; i++)
+		g_hash_table_insert (attributes, g_strdup (set->attributes[i].name),
+		                     g_strdup (set->attributes[i].value));
+
+	return attributes;
+}
+
+/* Whether every attribute in set is also in other, with the same value */
+gboolean
+_secret_attribute_set_subset (SecretAttributeSet *set,
+                              SecretAttributeSet *other)
+{
+	const SecretAttribute *attr;
+	const SecretAttribute *match;
+	guint i, j;
+
+	g_return_val_if_fail (set != NULL, FALSE);
+	g_return_val_if_fail (other != NULL, FALSE);
+
+	if (set->n_attributes > other->n_attributes)
+		return FALSE;
+
+	for (i = 0, j = 0; i < set->n_attributes; i++) {
+		attr = set->attributes + i;
+
+		/* Both are sorted, so skip past smaller names in other */
+		while (j < other->n_attributes && strcmp (other->attributes[j].name, attr->name) < 0)
+			j++;
+		if (j == other->n_attributes)
+			return FALSE;
+
+		match = other->attributes + j;
+		if (match->hash != attr->hash ||
+		    !g_str_equal (match->name, attr->name) ||
+		    !g_str_equal (match->value, attr->value))
+			return FALSE;
+		j++;
+	}
+
+	return TRUE;
+}
+
+gboolean
+_secret_attribute_set_equal (SecretAttributeSet *set,
+                             SecretAttributeSet *other)
+{
+	guint i;
+
+	g_return_val_if_fail (set != NULL, FALSE);
+	g_return_val_if_fail (other != NULL, FALSE);
+
+	if (set == other)
+		return TRUE;
+	if (set->n_attributes != other->n_attributes)
+		return FALSE;
+
+	/* Same size, so each attribute must line up with its counterpart */
+	for (i = 0; i < set->n_attributes; i++) {
+		if (set->attributes[i].hash != other->attributes[i].hash)
+			return FALSE;
+	}
+
+	for (i = 0; i < set->n_attributes; i++) {
+		if (!g_str_equal (set->attributes[i].name, other->attributes[i].name) ||
+		    !g_str_equal (set->attributes[i].value, other->attributes[i].value))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+guint
+_secret_attribute_set_hash (SecretAttributeSet *set)
+{
+	guint hash = 0;
+	guint i;
+
+	g_return_val_if_fail (set != NULL, 0);
+
+	for (i = 0; i < set->n_attributes; i++)
+		hash = (hash * 31) + set->attributes[i].hash;
+
+	return hash;
+}
@@ -550,6 +550,10 @@ secret_collection_initable_init (GInitable *initable,
 
 	self = SECRET_COLLECTION (initable);
 
+	/* An already resolved default service is used without a round trip */
+	if (self->pv->service == NULL)
+		collection_take_service (self, _secret_service_get_instance ());
+
 	if (self->pv->service == NULL) {
 		service = secret_service_get_sync (SECRET_SERVICE_NONE, cancellable, error);
 		if (service == NULL)
@@ -668,13 +672,17 @@ on_init_base (GObject *source,
 		                                 g_dbus_proxy_get_object_path (proxy));
 		g_simple_async_result_complete (res);
 
-	} else if (self->pv->service == NULL) {
-		secret_service_get (SECRET_SERVICE_NONE, init->cancellable,
-		                    on_init_service, g_object_ref (res));
-
 	} else {
-		collection_ensure_for_flags_async (self, self->pv->init_flags,
-		                                   init->cancellable, res);
+		/* An already resolved default service is used without a round trip */
+		if (self->pv->service == NULL)
+			collection_take_service (self, _secret_service_get_instance ());
+
+		if (self->pv->service == NULL)
+			secret_service_get (SECRET_SERVICE_NONE, init->cancellable,
+			                    on_init_service, g_object_ref (res));
+		else
+			collection_ensure_for_flags_async (self, self->pv->init_flags,
+			                                   init->cancellable, res);
 	}
 
 	g_object_unref (res);
@@ -895,11 +903,14 @@ secret_collection_load_items_sync (SecretCollection *self,
                                    GError **error)
 {
 	SecretItem *item;
+	SecretItem **loaded;
 	GHashTable *items;
+	GPtrArray *missing;
 	GVariant *paths;
 	GVariantIter iter;
 	const gchar *path;
 	gboolean ret = TRUE;
+	guint i;
 
 	g_return_val_if_fail (SECRET_IS_COLLECTION (self), FALSE);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
@@ -909,28 +920,29 @@ secret_collection_load_items_sync (SecretCollection *self,
 	g_return_val_if_fail (paths != NULL, FALSE);
 
 	items = items_table_new ();
+	missing = g_ptr_array_new ();
 
 	g_variant_iter_init (&iter, paths);
 	while (g_variant_iter_next (&iter, "&o", &path)) {
 		item = _secret_collection_find_item_instance (self, path);
-
-		/* No such collection yet create a new one */
-		if (item == NULL) {
-			item = secret_item_new_for_dbus_path_sync (self->pv->service, path,
-			                                           SECRET_ITEM_NONE,
-			                                           cancellable, error);
-			if (item == NULL) {
-				ret = FALSE;
-				break;
-			}
-		}
-
-		g_hash_table_insert (items, g_strdup (path), item);
+		if (item == NULL)
+			g_ptr_array_add (missing, (gpointer)path);
+		else
+			g_hash_table_insert (items, g_strdup (path), item);
 	}
 
+	/* No such items yet, load them all at once */
+	loaded = g_new0 (SecretItem *, missing->len);
+	ret = _secret_item_new_for_dbus_paths_sync (self->pv->service, (const gchar **)missing->pdata,
+	                                            missing->len, loaded, cancellable, error);
+	for (i = 0; ret && i < missing->len; i++)
+		g_hash_table_insert (items, g_strdup (missing->pdata[i]), loaded[i]);
+
 	if (ret)
 		collection_update_items (self, items);
 
+	g_free (loaded);
+	g_ptr_array_free (missing, TRUE);
 	g_hash_table_unref (items);
 	g_variant_unref (paths);
 	return ret;
@@ -1510,25 +1522,44 @@ collection_load_items_sync (SecretCollection *self,
                             GError **error)
 {
 	SecretService *service = secret_collection_get_service (self);
-	SecretItem *item;
-	gint have = 0;
-	guint i;
+	SecretItem **found;
+	SecretItem **loaded;
+	GPtrArray *missing;
+	gboolean ret;
+	gint have;
+	gint i, j;
 
-	for (i = 0; have < want && paths[i] != NULL; i++) {
-		item = _secret_collection_find_item_instance (self, paths[i]);
-		if (item == NULL)
-			item = secret_item_new_for_dbus_path_sync (service, paths[i], SECRET_ITEM_NONE,
-			                                           cancellable, error);
-		if (item == NULL) {
-			return FALSE;
+	for (have = 0; have < want && paths[have] != NULL; have++);
 
-		} else {
-			*items = g_list_prepend (*items, item);
-			have++;
-		}
+	found = g_new0 (SecretItem *, have);
+	missing = g_ptr_array_new ();
+	for (i = 0; i < have; i++) {
+		found[i] = _secret_collection_find_item_instance (self, paths[i]);
+		if (found[i] == NULL)
+			g_ptr_array_add (missing, paths[i]);
 	}
 
-	return TRUE;
+	/* Items without a proxy yet are loaded all at once */
+	loaded = g_new0 (SecretItem *, missing->len);
+	ret = _secret_item_new_for_dbus_paths_sync (service, (const gchar **)missing->pdata,
+	                                            missing->len, loaded, cancellable, error);
+
+	for (i = have - 1, j = missing->len - 1; i >= 0; i--) {
+		if (found[i] == NULL && ret)
+			found[i] = loaded[j--];
+		if (found[i] != NULL)
+			*items = g_list_prepend (*items, found[i]);
+	}
+
+	if (!ret) {
+		g_list_free_full (*items, g_object_unref);
+		*items = NULL;
+	}
+
+	g_ptr_array_free (missing, TRUE);
+	g_free (loaded);
+	g_free (found);
+	return ret;
 }
 
 /**
@@ -1600,13 +1631,9 @@ secret_collection_search_sync (SecretCollection *self,
 	if (!ret)
 		return NULL;
 
-	if (flags & SECRET_SEARCH_UNLOCK) {
-		secret_service_unlock_sync (secret_collection_get_service (self),
-		                            items, cancellable, NULL, NULL);
-	}
-
-	if (flags & SECRET_SEARCH_LOAD_SECRETS)
-		secret_item_load_secrets_sync (items, NULL, NULL);
+	/* Same pipeline as secret_service_search_sync(), failures are ignored */
+	_secret_service_unlock_load_items_sync (secret_collection_get_service (self),
+	                                        items, flags, cancellable);
 
 	return items;
 }
@@ -1778,6 +1805,9 @@ secret_collection_get_flags (SecretCollection *self)
  *
  * Get the list of items in this collection.
  *
+ * If the items have not been loaded yet, %NULL is returned. Use
+ * secret_collection_load_items() to load them.
+ *
  * Returns: (transfer full) (element-type SecretUnstable.Item): a list of items,
  * when done, the list should be freed with g_list_free, and each item should
  * be released with g_object_unref()
@@ -26,6 +26,8 @@
 
 #include <glib/gi18n-lib.h>
 
+#include <string.h>
+
 /**
  * SECTION:secret-item
  * @title: SecretItem
@@ -105,6 +107,9 @@ struct _SecretItemPrivate {
 	/* Locked by mutex */
 	GMutex mutex;
 	SecretValue *value;
+
+	/* Only touched in the main thread, see item_new_unloaded() */
+	guint properties_watch;
 };
 
 static GInitableIface *secret_item_initable_parent_iface = NULL;
@@ -254,6 +259,12 @@ secret_item_dispose (GObject *obj)
 
 	g_cancellable_cancel (self->pv->cancellable);
 
+	if (self->pv->properties_watch) {
+		g_dbus_connection_signal_unsubscribe (g_dbus_proxy_get_connection (G_DBUS_PROXY (self)),
+		                                      self->pv->properties_watch);
+		self->pv->properties_watch = 0;
+	}
+
 	G_OBJECT_CLASS (secret_item_parent_class)->dispose (obj);
 }
 
@@ -487,6 +498,11 @@ secret_item_initable_init (GInitable *initable,
 	}
 
 	self = SECRET_ITEM (initable);
+
+	/* An already resolved default service is used without a round trip */
+	if (!self->pv->service)
+		item_take_service (self, _secret_service_get_instance ());
+
 	if (!self->pv->service) {
 		service = secret_service_get_sync (SECRET_SERVICE_NONE, cancellable, error);
 		if (service == NULL)
@@ -552,12 +568,16 @@ on_init_base (GObject *source,
 		                                 g_dbus_proxy_get_object_path (proxy));
 		g_simple_async_result_complete (res);
 
-	} else if (self->pv->service == NULL) {
-		secret_service_get (SECRET_SERVICE_NONE, init->cancellable,
-		                    on_init_service, g_object_ref (res));
-
 	} else {
-		item_ensure_for_flags_async (self, self->pv->init_flags, res);
+		/* An already resolved default service is used without a round trip */
+		if (self->pv->service == NULL)
+			item_take_service (self, _secret_service_get_instance ());
+
+		if (self->pv->service == NULL)
+			secret_service_get (SECRET_SERVICE_NONE, init->cancellable,
+			                    on_init_service, g_object_ref (res));
+		else
+			item_ensure_for_flags_async (self, self->pv->init_flags, res);
 	}
 
 	g_object_unref (res);
@@ -665,6 +685,9 @@ typedef struct {
 	GCancellable *cancellable;
 	SecretItem *item;
 	SecretValue *value;
+	GHashTable *properties;
+	SecretItemCreateFlags flags;
+	gint pending;
 } CreateClosure;
 
 static void
@@ -674,6 +697,7 @@ create_closure_free (gpointer data)
 	g_clear_object (&closure->cancellable);
 	g_clear_object (&closure->item);
 	secret_value_unref (closure->value);
+	g_hash_table_unref (closure->properties);
 	g_slice_free (CreateClosure, closure);
 }
 
@@ -697,6 +721,324 @@ on_create_item (GObject *source,
 	g_object_unref (res);
 }
 
+static void
+on_item_properties_changed (GDBusConnection *connection,
+                            const gchar *sender_name,
+                            const gchar *object_path,
+                            const gchar *interface_name,
+                            const gchar *signal_name,
+                            GVariant *parameters,
+                            gpointer user_data)
+{
+	const gchar **invalidated;
+	GDBusProxy *proxy;
+	GVariant *changed;
+	GVariantIter iter;
+	const gchar *name;
+	GVariant *value;
+	guint i;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)")))
+		return;
+
+	proxy = g_weak_ref_get (user_data);
+	if (proxy == NULL)
+		return;
+
+	g_variant_get (parameters, "(&s@a{sv}^a&s)", NULL, &changed, &invalidated);
+
+	g_variant_iter_init (&iter, changed);
+	while (g_variant_iter_next (&iter, "{&sv}", &name, &value)) {
+		g_dbus_proxy_set_cached_property (proxy, name, value);
+		g_variant_unref (value);
+	}
+	for (i = 0; invalidated[i] != NULL; i++)
+		g_dbus_proxy_set_cached_property (proxy, invalidated[i], NULL);
+
+	g_signal_emit_by_name (proxy, "g-properties-changed", changed, invalidated);
+
+	g_variant_unref (changed);
+	g_free (invalidated);
+	g_object_unref (proxy);
+}
+
+static void
+on_item_name_owner (GObject *obj,
+                    GParamSpec *pspec,
+                    gpointer user_data)
+{
+	gchar *owner;
+
+	/* The service was restarted, what it knows may have changed */
+	owner = g_dbus_proxy_get_name_owner (G_DBUS_PROXY (obj));
+	if (owner != NULL)
+		secret_item_refresh (SECRET_ITEM (obj));
+	g_free (owner);
+}
+
+static void
+free_weak_ref (gpointer data)
+{
+	GWeakRef *ref = data;
+	g_weak_ref_clear (ref);
+	g_slice_free (GWeakRef, ref);
+}
+
+static SecretItem *
+item_new_unloaded (SecretService *service,
+                   const gchar *item_path)
+{
+	GDBusProxy *proxy = G_DBUS_PROXY (service);
+	SecretItem *item;
+	GWeakRef *ref;
+
+	/* Not yet initialized, the caller fills in the cached properties */
+	item = g_object_new (secret_service_get_item_gtype (service),
+	                     "g-flags", G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+	                     "g-interface-info", _secret_gen_item_interface_info (),
+	                     "g-name", g_dbus_proxy_get_name (proxy),
+	                     "g-connection", g_dbus_proxy_get_connection (proxy),
+	                     "g-object-path", item_path,
+	                     "g-interface-name", SECRET_ITEM_INTERFACE,
+	                     "service", service,
+	                     "flags", SECRET_ITEM_NONE,
+	                     NULL);
+
+	/*
+	 * GDBusProxy doesn't follow changes to properties it didn't load, so
+	 * watch for them here, and reload them when the service restarts.
+	 */
+	ref = g_slice_new0 (GWeakRef);
+	g_weak_ref_init (ref, item);
+	item->pv->properties_watch = g_dbus_connection_signal_subscribe (g_dbus_proxy_get_connection (proxy),
+	                                                                 g_dbus_proxy_get_name (proxy),
+	                                                                 SECRET_PROPERTIES_INTERFACE,
+	                                                                 "PropertiesChanged", item_path,
+	                                                                 SECRET_ITEM_INTERFACE,
+	                                                                 G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                                 on_item_properties_changed,
+	                                                                 ref, free_weak_ref);
+	g_signal_connect (item, "notify::g-name-owner", G_CALLBACK (on_item_name_owner), NULL);
+
+	return item;
+}
+
+static SecretItem *
+item_new_seeded (SecretService *service,
+                 const gchar *item_path,
+                 GHashTable *properties)
+{
+	const gchar *prefix = SECRET_ITEM_INTERFACE ".";
+	GDBusProxy *proxy;
+	GHashTableIter iter;
+	SecretItem *item;
+	const gchar *name;
+	GVariant *value;
+
+	/*
+	 * Seed the proxy with the label and attributes we just sent. The
+	 * caller initializes it and loads the properties that only the
+	 * service knows, such as the dates, before handing it out.
+	 */
+
+	item = item_new_unloaded (service, item_path);
+	proxy = G_DBUS_PROXY (item);
+	g_hash_table_iter_init (&iter, properties);
+	while (g_hash_table_iter_next (&iter, (gpointer *)&name, (gpointer *)&value)) {
+		if (g_str_has_prefix (name, prefix))
+			g_dbus_proxy_set_cached_property (proxy, name + strlen (prefix), value);
+	}
+
+	return item;
+}
+
+static SecretItem *
+item_new_for_properties_sync (SecretService *service,
+                              const gchar *item_path,
+                              GHashTable *properties,
+                              GCancellable *cancellable,
+                              GError **error)
+{
+	SecretItem *item;
+
+	item = item_new_seeded (service, item_path, properties);
+	if (!g_initable_init (G_INITABLE (item), cancellable, error) ||
+	    !_secret_util_get_properties_sync (G_DBUS_PROXY (item), cancellable, error)) {
+		g_object_unref (item);
+		return NULL;
+	}
+
+	return item;
+}
+
+typedef struct {
+	GMainLoop *loop;
+	GVariant **properties;
+	GError *error;
+	guint pending;
+} LoadPropertiesSync;
+
+typedef struct {
+	LoadPropertiesSync *load;
+	guint index;
+} LoadPropertiesCall;
+
+static void
+on_load_properties (GObject *source,
+                    GAsyncResult *result,
+                    gpointer user_data)
+{
+	LoadPropertiesCall *call = user_data;
+	LoadPropertiesSync *load = call->load;
+	GError *error = NULL;
+	GVariant *retval;
+
+	retval = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+	if (retval != NULL) {
+		g_variant_get (retval, "(@a{sv})", &load->properties[call->index]);
+		g_variant_unref (retval);
+	} else if (load->error == NULL) {
+		load->error = error;
+	} else {
+		g_error_free (error);
+	}
+
+	if (--load->pending == 0)
+		g_main_loop_quit (load->loop);
+	g_slice_free (LoadPropertiesCall, call);
+}
+
+gboolean
+_secret_item_new_for_dbus_paths_sync (SecretService *service,
+                                      const gchar **paths,
+                                      guint n_paths,
+                                      SecretItem **items,
+                                      GCancellable *cancellable,
+                                      GError **error)
+{
+	GDBusProxy *proxy = G_DBUS_PROXY (service);
+	LoadPropertiesSync load = { NULL, };
+	LoadPropertiesCall *call;
+	SecretSync *sync;
+	GVariantIter iter;
+	const gchar *name;
+	GVariant *value;
+	gchar *owner;
+	guint i, j;
+
+	if (n_paths == 0)
+		return TRUE;
+
+	owner = g_dbus_proxy_get_name_owner (proxy);
+	sync = _secret_sync_new ();
+	load.loop = sync->loop;
+	load.properties = g_new0 (GVariant *, n_paths);
+
+	/* The properties of all the items are requested at once */
+	g_main_context_push_thread_default (sync->context);
+
+	for (i = 0; i < n_paths; i++) {
+		call = g_slice_new (LoadPropertiesCall);
+		call->load = &load;
+		call->index = i;
+		g_dbus_connection_call (g_dbus_proxy_get_connection (proxy),
+		                        owner ? owner : g_dbus_proxy_get_name (proxy),
+		                        paths[i], SECRET_PROPERTIES_INTERFACE, "GetAll",
+		                        g_variant_new ("(s)", SECRET_ITEM_INTERFACE),
+		                        G_VARIANT_TYPE ("(a{sv})"), G_DBUS_CALL_FLAGS_NONE,
+		                        -1, cancellable, on_load_properties, call);
+		load.pending++;
+	}
+
+	g_main_loop_run (sync->loop);
+
+	g_main_context_pop_thread_default (sync->context);
+	_secret_sync_free (sync);
+	g_free (owner);
+
+	/*
+	 * The proxies are created here, rather than while the private main
+	 * context above is pushed, so that they receive signals in the
+	 * caller's main context.
+	 */
+	for (i = 0; load.error == NULL && i < n_paths; i++) {
+		items[i] = item_new_unloaded (service, paths[i]);
+		g_variant_iter_init (&iter, load.properties[i]);
+		while (g_variant_iter_next (&iter, "{&sv}", &name, &value)) {
+			g_dbus_proxy_set_cached_property (G_DBUS_PROXY (items[i]), name, value);
+			g_variant_unref (value);
+		}
+
+		if (!g_initable_init (G_INITABLE (items[i]), cancellable, &load.error)) {
+			for (j = 0; j <= i; j++)
+				g_clear_object (&items[j]);
+		}
+	}
+
+	for (i = 0; i < n_paths; i++) {
+		if (load.properties[i])
+			g_variant_unref (load.properties[i]);
+	}
+	g_free (load.properties);
+
+	if (load.error != NULL) {
+		g_propagate_error (error, load.error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+create_step_done (GSimpleAsyncResult *res,
+                  CreateClosure *closure,
+                  GError *error)
+{
+	if (error != NULL && closure->item != NULL) {
+		g_simple_async_result_take_error (res, error);
+		g_clear_object (&closure->item);
+	} else if (error != NULL) {
+		g_error_free (error);
+	}
+
+	if (--closure->pending > 0)
+		return;
+
+	/* As a convenince mark down the SecretValue on the item */
+	if (closure->item != NULL)
+		_secret_item_set_cached_secret (closure->item, closure->value);
+	g_simple_async_result_complete (res);
+}
+
+static void
+on_create_init (GObject *source,
+                GAsyncResult *result,
+                gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
+	CreateClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	GError *error = NULL;
+
+	g_async_initable_init_finish (G_ASYNC_INITABLE (source), result, &error);
+	create_step_done (res, closure, error);
+	g_object_unref (res);
+}
+
+static void
+on_create_properties (GObject *source,
+                      GAsyncResult *result,
+                      gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
+	CreateClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	GError *error = NULL;
+
+	_secret_util_get_properties_finish (G_DBUS_PROXY (source), secret_item_create,
+	                                    result, &error);
+	create_step_done (res, closure, error);
+	g_object_unref (res);
+}
+
 static void
 on_create_path (GObject *source,
                 GAsyncResult *result,
@@ -709,15 +1051,28 @@ on_create_path (GObject *source,
 	gchar *path;
 
 	path = secret_service_create_item_dbus_path_finish (service, result, &error);
-	if (error == NULL) {
+	if (error != NULL) {
+		g_simple_async_result_take_error (res, error);
+		g_simple_async_result_complete (res);
+
+	/* When replacing, the item may have existed with other properties */
+	} else if (closure->flags & SECRET_ITEM_CREATE_REPLACE) {
 		secret_item_new_for_dbus_path (service, path, SECRET_ITEM_NONE,
 		                               closure->cancellable, on_create_item,
 		                               g_object_ref (res));
+
+	/* The rest of the properties are loaded while the proxy initializes */
 	} else {
-		g_simple_async_result_take_error (res, error);
-		g_simple_async_result_complete (res);
+		closure->item = item_new_seeded (service, path, closure->properties);
+		closure->pending = 2;
+		g_async_initable_init_async (G_ASYNC_INITABLE (closure->item), G_PRIORITY_DEFAULT,
+		                             closure->cancellable, on_create_init, g_object_ref (res));
+		_secret_util_get_properties (G_DBUS_PROXY (closure->item), secret_item_create,
+		                             closure->cancellable, on_create_properties,
+		                             g_object_ref (res));
 	}
 
+	g_free (path);
 	g_object_unref (res);
 }
 
@@ -803,9 +1158,11 @@ secret_item_create (SecretCollection *collection,
 	closure = g_slice_new0 (CreateClosure);
 	closure->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
 	closure->value = secret_value_ref (value);
+	closure->properties = item_properties_new (label, schema, attributes);
+	closure->flags = flags;
 	g_simple_async_result_set_op_res_gpointer (res, closure, create_closure_free);
 
-	properties = item_properties_new (label, schema, attributes);
+	properties = closure->properties;
 	g_object_get (collection, "service", &service, NULL);
 
 	collection_path = g_dbus_proxy_get_object_path (G_DBUS_PROXY (collection));
@@ -814,7 +1171,6 @@ secret_item_create (SecretCollection *collection,
 	                                      value, flags, cancellable,
 	                                      on_create_path, g_object_ref (res));
 
-	g_hash_table_unref (properties);
 	g_object_unref (service);
 	g_object_unref (res);
 }
@@ -912,8 +1268,14 @@ secret_item_create_sync (SecretCollection *collection,
 	                                                  value, flags, cancellable, error);
 
 	if (path != NULL) {
-		item = secret_item_new_for_dbus_path_sync (service, path, SECRET_ITEM_NONE,
-		                                           cancellable, error);
+		if (flags & SECRET_ITEM_CREATE_REPLACE)
+			item = secret_item_new_for_dbus_path_sync (service, path, SECRET_ITEM_NONE,
+			                                           cancellable, error);
+		else
+			item = item_new_for_properties_sync (service, path, properties,
+			                                     cancellable, error);
+		if (item != NULL)
+			_secret_item_set_cached_secret (item, value);
 		g_free (path);
 	}
 
@@ -2004,6 +2366,381 @@ secret_item_set_label_sync (SecretItem *self,
 	                                       cancellable, error);
 }
 
+typedef struct {
+	GCancellable *cancellable;
+	GVariant *label;
+	GVariant *attributes;
+	SecretValue *value;
+	gint pending;
+	gboolean label_set;
+	gboolean attributes_set;
+	gboolean secret_set;
+	GError *error;
+} UpdateClosure;
+
+static void
+update_closure_free (gpointer data)
+{
+	UpdateClosure *closure = data;
+	g_clear_object (&closure->cancellable);
+	if (closure->label)
+		g_variant_unref (closure->label);
+	if (closure->attributes)
+		g_variant_unref (closure->attributes);
+	if (closure->value)
+		secret_value_unref (closure->value);
+	g_clear_error (&closure->error);
+	g_slice_free (UpdateClosure, closure);
+}
+
+static void
+update_take_error (UpdateClosure *closure,
+                   GError *error)
+{
+	if (closure->error == NULL)
+		closure->error = error;
+	else
+		g_error_free (error);
+}
+
+static void
+update_complete_one (GSimpleAsyncResult *res)
+{
+	SecretItem *self = SECRET_ITEM (g_async_result_get_source_object (G_ASYNC_RESULT (res)));
+	UpdateClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	GObject *obj = G_OBJECT (self);
+	GDBusProxy *proxy = G_DBUS_PROXY (self);
+
+	closure->pending--;
+	if (closure->pending > 0) {
+		g_object_unref (self);
+		return;
+	}
+
+	/* Update the cached state for whatever succeeded, in one burst */
+	g_object_freeze_notify (obj);
+
+	if (closure->label_set) {
+		g_dbus_proxy_set_cached_property (proxy, "Label", closure->label);
+		g_object_notify (obj, "label");
+	}
+	if (closure->attributes_set) {
+		g_dbus_proxy_set_cached_property (proxy, "Attributes", closure->attributes);
+		g_object_notify (obj, "attributes");
+	}
+	if (closure->secret_set)
+		_secret_item_set_cached_secret (self, closure->value);
+
+	g_object_thaw_notify (obj);
+
+	if (closure->error != NULL) {
+		g_simple_async_result_take_error (res, closure->error);
+		closure->error = NULL;
+	}
+
+	g_simple_async_result_complete (res);
+	g_object_unref (self);
+}
+
+static void
+update_property_finish (GObject *source,
+                        GAsyncResult *result,
+                        gpointer user_data,
+                        gboolean *property_set)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
+	UpdateClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	GError *error = NULL;
+	GVariant *retval;
+
+	retval = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+	if (retval != NULL) {
+		*property_set = TRUE;
+		g_variant_unref (retval);
+	} else {
+		update_take_error (closure, error);
+	}
+
+	update_complete_one (res);
+}
+
+static void
+on_update_label (GObject *source,
+                 GAsyncResult *result,
+                 gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
+	UpdateClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+
+	update_property_finish (source, result, res, &closure->label_set);
+	g_object_unref (res);
+}
+
+static void
+on_update_attributes (GObject *source,
+                      GAsyncResult *result,
+                      gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
+	UpdateClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+
+	update_property_finish (source, result, res, &closure->attributes_set);
+	g_object_unref (res);
+}
+
+static void
+on_update_secret (GObject *source,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
+	UpdateClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	GError *error = NULL;
+	GVariant *retval;
+
+	retval = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), result, &error);
+	if (retval != NULL) {
+		closure->secret_set = TRUE;
+		g_variant_unref (retval);
+	} else {
+		update_take_error (closure, error);
+	}
+
+	update_complete_one (res);
+	g_object_unref (res);
+}
+
+static void
+update_send_secret (SecretItem *self,
+                    GSimpleAsyncResult *res)
+{
+	UpdateClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	SecretSession *session;
+	GVariant *encoded;
+
+	session = _secret_service_get_session (self->pv->service);
+	encoded = _secret_session_encode_secret (session, closure->value);
+	g_dbus_proxy_call (G_DBUS_PROXY (self), "SetSecret",
+	                   g_variant_new ("(@(oayays))", encoded),
+	                   G_DBUS_CALL_FLAGS_NO_AUTO_START, -1, closure->cancellable,
+	                   on_update_secret, g_object_ref (res));
+}
+
+static void
+on_update_ensure_session (GObject *source,
+                          GAsyncResult *result,
+                          gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
+	SecretItem *self = SECRET_ITEM (g_async_result_get_source_object (user_data));
+	UpdateClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	GError *error = NULL;
+
+	secret_service_ensure_session_finish (self->pv->service, result, &error);
+	if (error == NULL) {
+		update_send_secret (self, res);
+	} else {
+		update_take_error (closure, error);
+		update_complete_one (res);
+	}
+
+	g_object_unref (self);
+	g_object_unref (res);
+}
+
+static void
+update_set_property (SecretItem *self,
+                     GSimpleAsyncResult *res,
+                     const gchar *property,
+                     GVariant *value,
+                     GAsyncReadyCallback callback)
+{
+	UpdateClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	GDBusProxy *proxy = G_DBUS_PROXY (self);
+
+	g_dbus_connection_call (g_dbus_proxy_get_connection (proxy),
+	                        g_dbus_proxy_get_name (proxy),
+	                        g_dbus_proxy_get_object_path (proxy),
+	                        SECRET_PROPERTIES_INTERFACE,
+	                        "Set",
+	                        g_variant_new ("(ssv)",
+	                                       g_dbus_proxy_get_interface_name (proxy),
+	                                       property, value),
+	                        G_VARIANT_TYPE ("()"),
+	                        G_DBUS_CALL_FLAGS_NO_AUTO_START, -1,
+	                        closure->cancellable, callback,
+	                        g_object_ref (res));
+	closure->pending++;
+}
+
+/**
+ * secret_item_update:
+ * @self: an item
+ * @label: (allow-none): a new label, or %NULL to leave unchanged
+ * @schema: (allow-none): the schema for the attributes
+ * @attributes: (allow-none) (element-type utf8 utf8): a new set of
+ *              attributes, or %NULL to leave unchanged
+ * @value: (allow-none): a new secret value, or %NULL to leave unchanged
+ * @cancellable: optional cancellation object
+ * @callback: called when the operation completes
+ * @user_data: data to pass to the callback
+ *
+ * Update the label, attributes and secret value of this item together.
+ *
+ * This is equivalent to calling secret_item_set_label(),
+ * secret_item_set_attributes() and secret_item_set_secret(), but all the
+ * changes are sent to the secret service at once. The properties of this
+ * item are updated, and notified, together once all the changes have
+ * completed. If some of the changes fail, the others are still applied,
+ * and the first error is reported.
+ *
+ * This function returns immediately and completes asynchronously.
+ */
+void
+secret_item_update (SecretItem *self,
+                    const gchar *label,
+                    const SecretSchema *schema,
+                    GHashTable *attributes,
+                    SecretValue *value,
+                    GCancellable *cancellable,
+                    GAsyncReadyCallback callback,
+                    gpointer user_data)
+{
+	const gchar *schema_name = NULL;
+	GSimpleAsyncResult *res;
+	UpdateClosure *closure;
+
+	g_return_if_fail (SECRET_IS_ITEM (self));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	if (attributes != NULL && schema != NULL) {
+		if (!_secret_attributes_validate (schema, attributes, G_STRFUNC, FALSE))
+			return; /* Warnings raised already */
+		schema_name = schema->name;
+	}
+
+	res = g_simple_async_result_new (G_OBJECT (self), callback,
+	                                 user_data, secret_item_update);
+	closure = g_slice_new0 (UpdateClosure);
+	closure->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	if (label != NULL)
+		closure->label = g_variant_ref_sink (g_variant_new_string (label));
+	if (attributes != NULL)
+		closure->attributes = g_variant_ref_sink (_secret_attributes_to_variant (attributes, schema_name));
+	if (value != NULL)
+		closure->value = secret_value_ref (value);
+	g_simple_async_result_set_op_res_gpointer (res, closure, update_closure_free);
+
+	/* Held until all calls have been sent */
+	closure->pending = 1;
+
+	if (closure->label)
+		update_set_property (self, res, "Label", closure->label, on_update_label);
+	if (closure->attributes)
+		update_set_property (self, res, "Attributes", closure->attributes, on_update_attributes);
+
+	if (closure->value) {
+		closure->pending++;
+		if (_secret_service_get_session (self->pv->service))
+			update_send_secret (self, res);
+		else
+			secret_service_ensure_session (self->pv->service, cancellable,
+			                               on_update_ensure_session,
+			                               g_object_ref (res));
+	}
+
+	/* Nothing was sent, or complete when the replies arrive */
+	if (closure->pending == 1) {
+		closure->pending = 0;
+		g_simple_async_result_complete_in_idle (res);
+	} else {
+		closure->pending--;
+	}
+
+	g_object_unref (res);
+}
+
+/**
+ * secret_item_update_finish:
+ * @self: an item
+ * @result: asynchronous result passed to callback
+ * @error: location to place error on failure
+ *
+ * Complete asynchronous operation to update the label, attributes and
+ * secret value of this item.
+ *
+ * Returns: whether all the changes were successful or not
+ */
+gboolean
+secret_item_update_finish (SecretItem *self,
+                           GAsyncResult *result,
+                           GError **error)
+{
+	g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (self),
+	                      secret_item_update), FALSE);
+
+	if (_secret_util_propagate_error (G_SIMPLE_ASYNC_RESULT (result), error))
+		return FALSE;
+
+	return TRUE;
+}
+
+/**
+ * secret_item_update_sync:
+ * @self: an item
+ * @label: (allow-none): a new label, or %NULL to leave unchanged
+ * @schema: (allow-none): the schema for the attributes
+ * @attributes: (allow-none) (element-type utf8 utf8): a new set of
+ *              attributes, or %NULL to leave unchanged
+ * @value: (allow-none): a new secret value, or %NULL to leave unchanged
+ * @cancellable: optional cancellation object
+ * @error: location to place error on failure
+ *
+ * Update the label, attributes and secret value of this item together.
+ * See secret_item_update() for details.
+ *
+ * This function may block indefinetely. Use the asynchronous version
+ * in user interface threads.
+ *
+ * Returns: whether all the changes were successful or not
+ */
+gboolean
+secret_item_update_sync (SecretItem *self,
+                         const gchar *label,
+                         const SecretSchema *schema,
+                         GHashTable *attributes,
+                         SecretValue *value,
+                         GCancellable *cancellable,
+                         GError **error)
+{
+	SecretSync *sync;
+	gboolean ret;
+
+	g_return_val_if_fail (SECRET_IS_ITEM (self), FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* Warnings raised already */
+	if (attributes != NULL && schema != NULL &&
+	    !_secret_attributes_validate (schema, attributes, G_STRFUNC, FALSE))
+		return FALSE;
+
+	sync = _secret_sync_new ();
+	g_main_context_push_thread_default (sync->context);
+
+	secret_item_update (self, label, schema, attributes, value,
+	                    cancellable, _secret_sync_on_result, sync);
+
+	g_main_loop_run (sync->loop);
+
+	ret = secret_item_update_finish (self, sync->result, error);
+
+	g_main_context_pop_thread_default (sync->context);
+	_secret_sync_free (sync);
+
+	return ret;
+}
+
 /**
  * secret_item_get_locked:
  * @self: an item
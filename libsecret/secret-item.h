@@ -185,6 +185,27 @@ gboolean            secret_item_set_label_sync             (SecretItem *self,
                                                             GCancellable *cancellable,
                                                             GError **error);
 
+void                secret_item_update                     (SecretItem *self,
+                                                            const gchar *label,
+                                                            const SecretSchema *schema,
+                                                            GHashTable *attributes,
+                                                            SecretValue *value,
+                                                            GCancellable *cancellable,
+                                                            GAsyncReadyCallback callback,
+                                                            gpointer user_data);
+
+gboolean            secret_item_update_finish              (SecretItem *self,
+                                                            GAsyncResult *result,
+                                                            GError **error);
+
+gboolean            secret_item_update_sync                (SecretItem *self,
+                                                            const gchar *label,
+                                                            const SecretSchema *schema,
+                                                            GHashTable *attributes,
+                                                            SecretValue *value,
+                                                            GCancellable *cancellable,
+                                                            GError **error);
+
 gboolean            secret_item_get_locked                 (SecretItem *self);
 
 guint64             secret_item_get_created                (SecretItem *self);
@@ -26,6 +26,8 @@
 
 #include <glib/gi18n-lib.h>
 
+#include <string.h>
+
 /**
  * SecretSearchFlags:
  * @SECRET_SEARCH_NONE: no flags
@@ -40,23 +42,45 @@ typedef struct {
 	SecretService *service;
 	GCancellable *cancellable;
 	GHashTable *items;
-	gchar **unlocked;
-	gchar **locked;
+	GVariant *paths;
+	const gchar **unlocked;
+	const gchar **locked;
 	guint loading;
+	guint pending;
 	SecretSearchFlags flags;
 	GVariant *attributes;
+	GList *collections;
+	GVariant **collection_paths;
+	guint searching;
+	gboolean failed;
+	gboolean paths_only;
 } SearchClosure;
 
 static void
 search_closure_free (gpointer data)
 {
 	SearchClosure *closure = data;
-	g_object_unref (closure->service);
+	guint length;
+	guint i;
+
+	g_clear_object (&closure->service);
 	g_clear_object (&closure->cancellable);
 	g_hash_table_unref (closure->items);
-	g_variant_unref (closure->attributes);
-	g_strfreev (closure->unlocked);
-	g_strfreev (closure->locked);
+	if (closure->attributes)
+		g_variant_unref (closure->attributes);
+	g_free (closure->unlocked);
+	g_free (closure->locked);
+	if (closure->paths)
+		g_variant_unref (closure->paths);
+	if (closure->collection_paths) {
+		length = g_list_length (closure->collections);
+		for (i = 0; i < length; i++) {
+			if (closure->collection_paths[i])
+				g_variant_unref (closure->collection_paths[i]);
+		}
+		g_free (closure->collection_paths);
+	}
+	g_list_free_full (closure->collections, g_object_unref);
 	g_slice_free (SearchClosure, closure);
 }
 
@@ -70,7 +94,7 @@ search_closure_take_item (SearchClosure *closure,
 
 static GList *
 search_closure_build_items (SearchClosure *closure,
-                            gchar **paths)
+                            const gchar **paths)
 {
 	GList *results = NULL;
 	SecretItem *item;
@@ -85,20 +109,55 @@ search_closure_build_items (SearchClosure *closure,
 	return g_list_reverse (results);
 }
 
+static GList *
+search_closure_build_results (SearchClosure *closure)
+{
+	GList *items = NULL;
+
+	if (closure->unlocked)
+		items = search_closure_build_items (closure, closure->unlocked);
+	if (closure->locked)
+		items = g_list_concat (items, search_closure_build_items (closure, closure->locked));
+	return items;
+}
+
+static void
+search_step_done (GSimpleAsyncResult *async,
+                  SearchClosure *search)
+{
+	g_assert (search->pending > 0);
+	if (--search->pending == 0)
+		g_simple_async_result_complete (async);
+}
+
 static void
 on_search_secrets (GObject *source,
                    GAsyncResult *result,
                    gpointer user_data)
 {
 	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
+	SearchClosure *search = g_simple_async_result_get_op_res_gpointer (async);
 
 	/* Note that we ignore any unlock failure */
 	secret_item_load_secrets_finish (result, NULL);
 
-	g_simple_async_result_complete (async);
+	search_step_done (async, search);
 	g_object_unref (async);
 }
 
+static void
+search_load_secrets (GSimpleAsyncResult *async,
+                     SearchClosure *search,
+                     GList *items)
+{
+	if (items == NULL)
+		return;
+
+	secret_item_load_secrets (items, search->cancellable,
+	                          on_search_secrets, g_object_ref (async));
+	search->pending++;
+}
+
 static void
 on_search_unlocked (GObject *source,
                     GAsyncResult *result,
@@ -111,18 +170,17 @@ on_search_unlocked (GObject *source,
 	/* Note that we ignore any unlock failure */
 	secret_service_unlock_finish (search->service, result, NULL, NULL);
 
-	/* If loading secrets ... locked items automatically ignored */
+	/*
+	 * If loading secrets, those of the items that were unlocked already
+	 * have been requested, so only the ones just unlocked are left.
+	 */
 	if (search->flags & SECRET_SEARCH_LOAD_SECRETS) {
-		items = g_hash_table_get_values (search->items);
-		secret_item_load_secrets (items, search->cancellable,
-		                          on_search_secrets, g_object_ref (async));
-		g_list_free (items);
-
-	/* No additional options, just complete */
-	} else {
-		g_simple_async_result_complete (async);
+		items = search_closure_build_items (search, search->locked);
+		search_load_secrets (async, search, items);
+		g_list_free_full (items, g_object_unref);
 	}
 
+	search_step_done (async, search);
 	g_object_unref (async);
 }
 
@@ -132,24 +190,32 @@ secret_search_unlock_load_or_complete (GSimpleAsyncResult *async,
 {
 	GList *items;
 
+	/* Held while sending requests, so we don't complete early */
+	search->pending = 1;
+
 	/* If unlocking then unlock all the locked items */
 	if (search->flags & SECRET_SEARCH_UNLOCK) {
 		items = search_closure_build_items (search, search->locked);
-		secret_service_unlock (search->service, items, search->cancellable,
-		                       on_search_unlocked, g_object_ref (async));
+		if (items != NULL) {
+			secret_service_unlock (search->service, items, search->cancellable,
+			                       on_search_unlocked, g_object_ref (async));
+			search->pending++;
+		}
 		g_list_free_full (items, g_object_unref);
+	}
 
-	/* If loading secrets ... locked items automatically ignored */
-	} else if (search->flags & SECRET_SEARCH_LOAD_SECRETS) {
+	/*
+	 * If loading secrets ... locked items automatically ignored. Secrets
+	 * of items that are unlocked already don't depend on the unlock above,
+	 * so are requested at the same time.
+	 */
+	if (search->flags & SECRET_SEARCH_LOAD_SECRETS) {
 		items = g_hash_table_get_values (search->items);
-		secret_item_load_secrets (items, search->cancellable,
-		                          on_search_secrets, g_object_ref (async));
+		search_load_secrets (async, search, items);
 		g_list_free (items);
-
-	/* No additional options, just complete */
-	} else {
-		g_simple_async_result_complete (async);
 	}
+
+	search_step_done (async, search);
 }
 
 static void
@@ -196,6 +262,37 @@ search_load_item_async (SecretService *self,
 	}
 }
 
+static void
+search_load_paths (GSimpleAsyncResult *res,
+                   SearchClosure *closure)
+{
+	gint want = 1;
+	gint count;
+	gint i;
+
+	if (closure->flags & SECRET_SEARCH_ALL)
+		want = G_MAXINT;
+	count = 0;
+
+	for (i = 0; count < want && closure->unlocked[i] != NULL; i++, count++)
+		search_load_item_async (closure->service, res, closure, closure->unlocked[i]);
+	for (i = 0; count < want && closure->locked[i] != NULL; i++, count++)
+		search_load_item_async (closure->service, res, closure, closure->locked[i]);
+
+	/* No items loading, complete operation now */
+	if (closure->loading == 0)
+		secret_search_unlock_load_or_complete (res, closure);
+}
+
+static void
+search_closure_take_paths (SearchClosure *closure,
+                           GVariant *paths)
+{
+	/* The path strings stay owned by the reply, only the arrays are allocated */
+	closure->paths = paths;
+	g_variant_get (paths, "(^a&o^a&o)", &closure->unlocked, &closure->locked);
+}
+
 static void
 on_search_paths (GObject *source,
                  GAsyncResult *result,
@@ -203,28 +300,13 @@ on_search_paths (GObject *source,
 {
 	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
 	SearchClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
-	SecretService *self = closure->service;
 	GError *error = NULL;
-	gint want = 1;
-	gint count;
-	gint i;
+	GVariant *paths;
 
-	secret_service_search_for_dbus_paths_finish (self, result, &closure->unlocked,
-	                                             &closure->locked, &error);
+	paths = _secret_service_search_for_paths_variant_finish (closure->service, result, &error);
 	if (error == NULL) {
-		want = 1;
-		if (closure->flags & SECRET_SEARCH_ALL)
-			want = G_MAXINT;
-		count = 0;
-
-		for (i = 0; count < want && closure->unlocked[i] != NULL; i++, count++)
-			search_load_item_async (self, res, closure, closure->unlocked[i]);
-		for (i = 0; count < want && closure->locked[i] != NULL; i++, count++)
-			search_load_item_async (self, res, closure, closure->locked[i]);
-
-		/* No items loading, complete operation now */
-		if (closure->loading == 0)
-			secret_search_unlock_load_or_complete (res, closure);
+		search_closure_take_paths (closure, paths);
+		search_load_paths (res, closure);
 
 	} else {
 		g_simple_async_result_take_error (res, error);
@@ -352,7 +434,6 @@ secret_service_search_finish (SecretService *service,
 {
 	GSimpleAsyncResult *res;
 	SearchClosure *closure;
-	GList *items = NULL;
 
 	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
@@ -365,40 +446,119 @@ secret_service_search_finish (SecretService *service,
 		return NULL;
 
 	closure = g_simple_async_result_get_op_res_gpointer (res);
-	if (closure->unlocked)
-		items = search_closure_build_items (closure, closure->unlocked);
-	if (closure->locked)
-		items = g_list_concat (items, search_closure_build_items (closure, closure->locked));
-	return items;
+	return search_closure_build_results (closure);
 }
 
-static gboolean
-service_load_items_sync (SecretService *service,
-                         GCancellable *cancellable,
-                         gchar **paths,
-                         GList **items,
-                         gint want,
-                         gint *have,
-                         GError **error)
+static void
+search_closure_unlock_load_sync (SearchClosure *closure)
+{
+	GSimpleAsyncResult *res;
+	SecretSync *sync;
+
+	/* Unlock and load secrets, with as few round trips as possible */
+	if (!(closure->flags & (SECRET_SEARCH_UNLOCK | SECRET_SEARCH_LOAD_SECRETS)))
+		return;
+
+	sync = _secret_sync_new ();
+	g_main_context_push_thread_default (sync->context);
+
+	res = g_simple_async_result_new (G_OBJECT (closure->service), _secret_sync_on_result,
+	                                 sync, search_closure_unlock_load_sync);
+	g_simple_async_result_set_op_res_gpointer (res, closure, NULL);
+	secret_search_unlock_load_or_complete (res, closure);
+
+	if (sync->result == NULL)
+		g_main_loop_run (sync->loop);
+
+	g_main_context_pop_thread_default (sync->context);
+	_secret_sync_free (sync);
+	g_object_unref (res);
+}
+
+static GList *
+search_closure_load_sync (SearchClosure *closure,
+                          GCancellable *cancellable,
+                          GError **error)
 {
+	GPtrArray *missing;
+	SecretItem **loaded;
 	SecretItem *item;
+	gboolean ret;
+	gint want = 1;
+	gint count = 0;
 	guint i;
+	gint j;
 
-	for (i = 0; *have < want && paths[i] != NULL; i++) {
-		item = _secret_service_find_item_instance (service, paths[i]);
-		if (item == NULL)
-			item = secret_item_new_for_dbus_path_sync (service, paths[i], SECRET_ITEM_NONE,
-			                                           cancellable, error);
-		if (item == NULL) {
-			return FALSE;
+	if (closure->flags & SECRET_SEARCH_ALL)
+		want = G_MAXINT;
 
+	/* Load all the items that have no proxy yet at once */
+	missing = g_ptr_array_new ();
+	for (j = 0; count < want && closure->unlocked[j] != NULL; j++, count++)
+		g_ptr_array_add (missing, (gpointer)closure->unlocked[j]);
+	for (j = 0; count < want && closure->locked[j] != NULL; j++, count++)
+		g_ptr_array_add (missing, (gpointer)closure->locked[j]);
+
+	for (i = 0; i < missing->len; ) {
+		item = _secret_service_find_item_instance (closure->service, missing->pdata[i]);
+		if (item != NULL) {
+			search_closure_take_item (closure, item);
+			g_ptr_array_remove_index (missing, i);
 		} else {
-			*items = g_list_prepend (*items, item);
-			(*have)++;
+			i++;
 		}
 	}
 
-	return TRUE;
+	loaded = g_new0 (SecretItem *, missing->len);
+	ret = _secret_item_new_for_dbus_paths_sync (closure->service, (const gchar **)missing->pdata,
+	                                            missing->len, loaded, cancellable, error);
+	for (i = 0; ret && i < missing->len; i++)
+		search_closure_take_item (closure, loaded[i]);
+	g_ptr_array_free (missing, TRUE);
+	g_free (loaded);
+
+	if (!ret)
+		return NULL;
+
+	search_closure_unlock_load_sync (closure);
+	return search_closure_build_results (closure);
+}
+
+void
+_secret_service_unlock_load_items_sync (SecretService *service,
+                                        GList *items,
+                                        SecretSearchFlags flags,
+                                        GCancellable *cancellable)
+{
+	SearchClosure *closure;
+	GPtrArray *unlocked;
+	GPtrArray *locked;
+	const gchar *path;
+	GList *l;
+
+	g_return_if_fail (SECRET_IS_SERVICE (service));
+
+	closure = g_slice_new0 (SearchClosure);
+	closure->service = g_object_ref (service);
+	closure->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	closure->items = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	closure->flags = flags;
+
+	/* The proxies know whether they're locked, no need to ask again */
+	unlocked = g_ptr_array_new ();
+	locked = g_ptr_array_new ();
+	for (l = items; l != NULL; l = g_list_next (l)) {
+		search_closure_take_item (closure, g_object_ref (l->data));
+		path = g_dbus_proxy_get_object_path (l->data);
+		g_ptr_array_add (secret_item_get_locked (l->data) ? locked : unlocked, (gpointer)path);
+	}
+	g_ptr_array_add (unlocked, NULL);
+	g_ptr_array_add (locked, NULL);
+	closure->unlocked = (const gchar **)g_ptr_array_free (unlocked, FALSE);
+	closure->locked = (const gchar **)g_ptr_array_free (locked, FALSE);
+
+	search_closure_unlock_load_sync (closure);
+	search_closure_free (closure);
 }
 
 /**
@@ -443,16 +603,13 @@ secret_service_search_sync (SecretService *service,
                             GCancellable *cancellable,
                             GError **error)
 {
-	gchar **unlocked_paths = NULL;
-	gchar **locked_paths = NULL;
+	SearchClosure *closure;
+	const gchar *schema_name = NULL;
 	GList *items = NULL;
-	GList *locked = NULL;
-	GList *unlocked = NULL;
-	gboolean ret;
-	gint want;
-	gint have;
+	GVariant *paths;
 
 	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), NULL);
+	g_return_val_if_fail (attributes != NULL, NULL);
 	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
@@ -460,6 +617,9 @@ secret_service_search_sync (SecretService *service,
 	if (schema != NULL && !_secret_attributes_validate (schema, attributes, G_STRFUNC, TRUE))
 		return NULL;
 
+	if (schema != NULL && !(schema->flags & SECRET_SCHEMA_DONT_MATCH_NAME))
+		schema_name = schema->name;
+
 	if (service == NULL) {
 		service = secret_service_get_sync (SECRET_SERVICE_NONE, cancellable, error);
 		if (service == NULL)
@@ -468,629 +628,1833 @@ secret_service_search_sync (SecretService *service,
 		g_object_ref (service);
 	}
 
-	if (!secret_service_search_for_dbus_paths_sync (service, schema, attributes, cancellable,
-	                                                &unlocked_paths, &locked_paths, error)) {
-		g_object_unref (service);
-		return NULL;
-	}
-
-	ret = TRUE;
-
-	want = 1;
-	if (flags & SECRET_SEARCH_ALL)
-		want = G_MAXINT;
-	have = 0;
-
-	/* Remember, we're adding to the list backwards */
-
-	if (unlocked_paths) {
-		ret = service_load_items_sync (service, cancellable, unlocked_paths,
-		                               &unlocked, want, &have, error);
-	}
-
-	if (ret && locked_paths) {
-		ret = service_load_items_sync (service, cancellable, locked_paths,
-		                               &locked, want, &have, error);
-	}
-
-	g_strfreev (unlocked_paths);
-	g_strfreev (locked_paths);
+	closure = g_slice_new0 (SearchClosure);
+	closure->service = service;
+	closure->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	closure->items = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	closure->flags = flags;
 
-	if (!ret) {
-		g_list_free_full (unlocked, g_object_unref);
-		g_list_free_full (locked, g_object_unref);
-		g_object_unref (service);
-		return NULL;
+	paths = _secret_service_search_for_paths_variant_sync (service,
+	                                                       _secret_attributes_to_variant (attributes, schema_name),
+	                                                       cancellable, error);
+	if (paths != NULL) {
+		search_closure_take_paths (closure, paths);
+		items = search_closure_load_sync (closure, cancellable, error);
 	}
 
-	/* The lists are backwards at this point ... */
-	items = g_list_concat (items, g_list_copy (locked));
-	items = g_list_concat (items, g_list_copy (unlocked));
-	items = g_list_reverse (items);
-
-	if (flags & SECRET_SEARCH_UNLOCK)
-		secret_service_unlock_sync (service, locked, cancellable, NULL, NULL);
-
-	if (flags & SECRET_SEARCH_LOAD_SECRETS)
-		secret_item_load_secrets_sync (items, NULL, NULL);
-
-	g_list_free (locked);
-	g_list_free (unlocked);
-	g_object_unref (service);
+	search_closure_free (closure);
 	return items;
 }
 
-SecretValue *
-_secret_service_decode_get_secrets_first (SecretService *self,
-                                          GVariant *out)
-{
-	SecretSession *session;
-	SecretValue *value = NULL;
-	GVariantIter *iter;
-	GVariant *variant;
-	const gchar *path;
-
-	g_variant_get (out, "(a{o(oayays)})", &iter);
-	while (g_variant_iter_next (iter, "{&o@(oayays)}", &path, &variant)) {
-		session = _secret_service_get_session (self);
-		value = _secret_session_decode_secret (session, variant);
-		g_variant_unref (variant);
-		break;
-	}
-	g_variant_iter_free (iter);
-	return value;
-}
+typedef struct {
+	GSimpleAsyncResult *res;
+	guint index;
+} SearchCollectionCall;
 
-GHashTable *
-_secret_service_decode_get_secrets_all (SecretService *self,
-                                        GVariant *out)
+static void
+search_collections_merge (SearchClosure *closure)
 {
-	SecretSession *session;
-	GVariantIter *iter;
-	GVariant *variant;
-	GHashTable *values;
-	SecretValue *value;
-	gchar *path;
-
-	session = _secret_service_get_session (self);
-	values = g_hash_table_new_full (g_str_hash, g_str_equal,
-	                                g_free, secret_value_unref);
-	g_variant_get (out, "(a{o(oayays)})", &iter);
-	while (g_variant_iter_loop (iter, "{o@(oayays)}", &path, &variant)) {
-		value = _secret_session_decode_secret (session, variant);
-		if (value && path)
-			g_hash_table_insert (values, g_strdup (path), value);
+	GPtrArray *unlocked;
+	GPtrArray *locked;
+	GHashTable *seen;
+	const gchar **paths;
+	GList *l;
+	guint i, j;
+
+	unlocked = g_ptr_array_new ();
+	locked = g_ptr_array_new ();
+	seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+	/* Merge in the order the collections were passed, ignoring duplicates */
+	for (l = closure->collections, i = 0; l != NULL; l = g_list_next (l), i++) {
+		if (closure->collection_paths[i] == NULL)
+			continue;
+		g_variant_get (closure->collection_paths[i], "(^a&o)", &paths);
+		for (j = 0; paths[j] != NULL; j++) {
+			if (g_hash_table_lookup (seen, paths[j]))
+				continue;
+			g_hash_table_insert (seen, (gpointer)paths[j], (gpointer)paths[j]);
+			g_ptr_array_add (secret_collection_get_locked (l->data) ? locked : unlocked,
+			                 (gpointer)paths[j]);
+		}
+		g_free (paths);
 	}
-	g_variant_iter_free (iter);
-	return values;
-}
 
-typedef struct {
-	GCancellable *cancellable;
-	GPtrArray *paths;
-	GHashTable *objects;
-	gchar **xlocked;
-	guint count;
-	gboolean locking;
-} XlockClosure;
+	g_hash_table_destroy (seen);
 
-static void
-xlock_closure_free (gpointer data)
-{
-	XlockClosure *closure = data;
-	if (closure->cancellable)
-		g_object_unref (closure->cancellable);
-	g_ptr_array_free (closure->paths, TRUE);
-	g_strfreev (closure->xlocked);
-	g_hash_table_unref (closure->objects);
-	g_slice_free (XlockClosure, closure);
+	g_ptr_array_add (unlocked, NULL);
+	closure->unlocked = (const gchar **)g_ptr_array_free (unlocked, FALSE);
+	g_ptr_array_add (locked, NULL);
+	closure->locked = (const gchar **)g_ptr_array_free (locked, FALSE);
 }
 
 static void
-on_xlock_paths (GObject *source,
-                GAsyncResult *result,
-                gpointer user_data)
+on_search_collection_paths (GObject *source,
+                            GAsyncResult *result,
+                            gpointer user_data)
 {
-	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
-	XlockClosure *xlock = g_simple_async_result_get_op_res_gpointer (async);
-	GVariant *lockval;
-	GDBusProxy *object;
+	SearchCollectionCall *call = user_data;
+	GSimpleAsyncResult *res = call->res;
+	SearchClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
 	GError *error = NULL;
-	gint i;
-
-	xlock->count = _secret_service_xlock_paths_finish (SECRET_SERVICE (source), result,
-	                                                   &xlock->xlocked, &error);
+	GVariant *retval;
 
+	retval = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), result, &error);
 	if (error == NULL) {
-		/*
-		 * After a lock or unlock we want the Locked property to immediately
-		 * reflect the new state, and not have to wait for a PropertiesChanged
-		 * signal to be processed later.
-		 */
+		closure->collection_paths[call->index] = retval;
 
-		lockval = g_variant_ref_sink (g_variant_new_boolean (xlock->locking));
-		for (i = 0; xlock->xlocked[i] != NULL; i++) {
-			object =  g_hash_table_lookup (xlock->objects, xlock->xlocked[i]);
-			if (object != NULL)
-				g_dbus_proxy_set_cached_property (object, "Locked", lockval);
-		}
-		g_variant_unref (lockval);
+	/* Only the first error is reported */
+	} else if (!closure->failed) {
+		g_simple_async_result_take_error (res, error);
+		closure->failed = TRUE;
 
 	} else {
-		g_simple_async_result_take_error (async, error);
+		g_error_free (error);
 	}
 
-	g_simple_async_result_complete (async);
-	g_object_unref (async);
+	closure->searching--;
+	if (closure->searching == 0) {
+		if (closure->failed) {
+			g_simple_async_result_complete (res);
+		} else {
+			search_collections_merge (closure);
+			if (closure->paths_only)
+				g_simple_async_result_complete (res);
+			else
+				search_load_paths (res, closure);
+		}
+	}
+
+	g_object_unref (res);
+	g_slice_free (SearchCollectionCall, call);
 }
 
 static void
-on_xlock_service (GObject *source,
-                  GAsyncResult *result,
-                  gpointer user_data)
+search_collections_send (GSimpleAsyncResult *res,
+                         SearchClosure *closure)
 {
-	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
-	XlockClosure *xlock = g_simple_async_result_get_op_res_gpointer (async);
-	GError *error = NULL;
-	SecretService *service;
-
-	service = secret_service_get_finish (result, &error);
-	if (error == NULL) {
-		_secret_service_xlock_paths_async (service, xlock->locking ? "Lock" : "Unlock",
-		                                   (const gchar **)xlock->paths->pdata,
-		                                   xlock->cancellable, on_xlock_paths,
-		                                   g_object_ref (async));
-		g_object_unref (service);
-
-	} else {
-		g_simple_async_result_take_error (async, error);
-		g_simple_async_result_complete (async);
-	}
-
-	g_object_unref (async);
-}
-
-static void
-service_xlock_async (SecretService *service,
-                     gboolean locking,
-                     GList *objects,
-                     GCancellable *cancellable,
-                     GAsyncReadyCallback callback,
-                     gpointer user_data)
-{
-	GSimpleAsyncResult *async;
-	XlockClosure *xlock;
-	const gchar *path;
+	SearchCollectionCall *call;
 	GList *l;
+	guint i;
 
-	async = g_simple_async_result_new (G_OBJECT (service), callback, user_data,
-	                                   service_xlock_async);
-	xlock = g_slice_new0 (XlockClosure);
-	xlock->objects = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
-	xlock->locking = locking;
-	xlock->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
-	xlock->paths = g_ptr_array_new ();
-
-	for (l = objects; l != NULL; l = g_list_next (l)) {
-		path = g_dbus_proxy_get_object_path (l->data);
-		g_ptr_array_add (xlock->paths, (gpointer)path);
-		g_hash_table_insert (xlock->objects, g_strdup (path), g_object_ref (l->data));
+	/* Nothing to search, complete with no items */
+	if (closure->collections == NULL) {
+		closure->unlocked = g_new0 (const gchar *, 1);
+		closure->locked = g_new0 (const gchar *, 1);
+		g_simple_async_result_complete_in_idle (res);
+		return;
 	}
-	g_ptr_array_add (xlock->paths, NULL);
-
-	g_simple_async_result_set_op_res_gpointer (async, xlock, xlock_closure_free);
 
-	if (service == NULL) {
-		secret_service_get (SECRET_SERVICE_NONE, cancellable,
-		                    on_xlock_service, g_object_ref (async));
-	} else {
-		_secret_service_xlock_paths_async (service, xlock->locking ? "Lock" : "Unlock",
-		                                   (const gchar **)xlock->paths->pdata,
-		                                   xlock->cancellable, on_xlock_paths,
-		                                   g_object_ref (async));
+	/* All the searches are sent at once */
+	for (l = closure->collections, i = 0; l != NULL; l = g_list_next (l), i++) {
+		call = g_slice_new0 (SearchCollectionCall);
+		call->res = g_object_ref (res);
+		call->index = i;
+		g_dbus_proxy_call (G_DBUS_PROXY (l->data), "SearchItems",
+		                   g_variant_new ("(@a{ss})", closure->attributes),
+		                   G_DBUS_CALL_FLAGS_NONE, -1, closure->cancellable,
+		                   on_search_collection_paths, call);
+		closure->searching++;
 	}
-
-	g_object_unref (async);
 }
 
-static gint
-service_xlock_finish (SecretService *service,
-                      GAsyncResult *result,
-                      GList **xlocked,
-                      GError **error)
+static void
+on_search_collections_service (GObject *source,
+                               GAsyncResult *result,
+                               gpointer user_data)
 {
-	GSimpleAsyncResult *async;
-	XlockClosure *xlock;
-	GDBusProxy *object;
-	gint i;
-
-	g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (service),
-	                                                      service_xlock_async), -1);
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
+	SearchClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	GError *error = NULL;
 
-	async = G_SIMPLE_ASYNC_RESULT (result);
-	if (_secret_util_propagate_error (async, error))
-		return -1;
+	closure->service = secret_service_get_finish (result, &error);
+	if (error == NULL) {
+		search_collections_send (res, closure);
 
-	xlock = g_simple_async_result_get_op_res_gpointer (async);
-	if (xlocked) {
-		*xlocked = NULL;
-		for (i = 0; xlock->xlocked[i] != NULL; i++) {
-			object = g_hash_table_lookup (xlock->objects, xlock->xlocked[i]);
-			if (object != NULL)
-				*xlocked = g_list_prepend (*xlocked, g_object_ref (object));
-		}
+	} else {
+		g_simple_async_result_take_error (res, error);
+		g_simple_async_result_complete (res);
 	}
 
-	return xlock->count;
+	g_object_unref (res);
 }
 
 /**
- * secret_service_lock:
+ * secret_service_search_collections:
  * @service: (allow-none): the secret service
- * @objects: (element-type Gio.DBusProxy): the items or collections to lock
+ * @collections: (element-type SecretUnstable.Collection): the collections to search
+ * @schema: (allow-none): the schema for the attributes
+ * @attributes: (element-type utf8 utf8): search for items matching these attributes
+ * @flags: search option flags
  * @cancellable: optional cancellation object
  * @callback: called when the operation completes
  * @user_data: data to pass to the callback
  *
- * Lock items or collections in the secret service.
+ * Search for items matching the @attributes in each of the @collections.
+ * The searches are all sent at once, and the matching items are merged
+ * in the order of @collections. An item found by more than one search is
+ * only returned once.
  *
- * The secret service may not be able to lock items individually, and may
- * lock an entire collection instead.
+ * Items in collections that are locked are treated as locked items. The
+ * @flags have the same meaning as for secret_service_search().
  *
  * If @service is NULL, then secret_service_get() will be called to get
  * the default #SecretService proxy.
  *
- * This method returns immediately and completes asynchronously. The secret
- * service may prompt the user. secret_service_prompt() will be used to handle
- * any prompts that show up.
+ * This function returns immediately and completes asynchronously.
  */
 void
-secret_service_lock (SecretService *service,
-                     GList *objects,
-                     GCancellable *cancellable,
-                     GAsyncReadyCallback callback,
-                     gpointer user_data)
+secret_service_search_collections (SecretService *service,
+                                   GList *collections,
+                                   const SecretSchema *schema,
+                                   GHashTable *attributes,
+                                   SecretSearchFlags flags,
+                                   GCancellable *cancellable,
+                                   GAsyncReadyCallback callback,
+                                   gpointer user_data)
 {
+	GSimpleAsyncResult *res;
+	SearchClosure *closure;
+	const gchar *schema_name = NULL;
+	GList *l;
+
 	g_return_if_fail (service == NULL || SECRET_IS_SERVICE (service));
+	g_return_if_fail (attributes != NULL);
 	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	for (l = collections; l != NULL; l = g_list_next (l))
+		g_return_if_fail (SECRET_IS_COLLECTION (l->data));
 
-	service_xlock_async (service, TRUE, objects, cancellable, callback, user_data);
+	/* Warnings raised already */
+	if (schema != NULL && !_secret_attributes_validate (schema, attributes, G_STRFUNC, TRUE))
+		return;
+
+	if (schema != NULL && !(schema->flags & SECRET_SCHEMA_DONT_MATCH_NAME))
+		schema_name = schema->name;
+
+	res = g_simple_async_result_new (G_OBJECT (service), callback, user_data,
+	                                 secret_service_search_collections);
+	closure = g_slice_new0 (SearchClosure);
+	closure->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	closure->items = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	closure->flags = flags;
+	closure->attributes = _secret_attributes_to_variant (attributes, schema_name);
+	g_variant_ref_sink (closure->attributes);
+	closure->collections = g_list_copy (collections);
+	for (l = closure->collections; l != NULL; l = g_list_next (l))
+		g_object_ref (l->data);
+	closure->collection_paths = g_new0 (GVariant *, g_list_length (collections));
+	g_simple_async_result_set_op_res_gpointer (res, closure, search_closure_free);
+
+	if (service) {
+		closure->service = g_object_ref (service);
+		search_collections_send (res, closure);
+
+	} else {
+		secret_service_get (SECRET_SERVICE_NONE, cancellable,
+		                    on_search_collections_service, g_object_ref (res));
+	}
+
+	g_object_unref (res);
 }
 
 /**
- * secret_service_lock_finish:
+ * secret_service_search_collections_finish:
  * @service: (allow-none): the secret service
- * @result: asynchronous result passed to the callback
- * @locked: (out) (element-type Gio.DBusProxy) (transfer full) (allow-none):
- *          location to place list of items or collections that were locked
- * @error: location to place an error on failure
- *
- * Complete asynchronous operation to lock items or collections in the secret
- * service.
+ * @result: asynchronous result passed to callback
+ * @error: location to place error on failure
  *
- * The secret service may not be able to lock items individually, and may
- * lock an entire collection instead.
+ * Complete asynchronous operation to search for items in a set of collections.
  *
- * Returns: the number of items or collections that were locked
+ * Returns: (transfer full) (element-type SecretUnstable.Item):
+ *          a list of items that matched the search
  */
-gint
-secret_service_lock_finish (SecretService *service,
-                            GAsyncResult *result,
-                            GList **locked,
-                            GError **error)
+GList *
+secret_service_search_collections_finish (SecretService *service,
+                                          GAsyncResult *result,
+                                          GError **error)
 {
-	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), -1);
-	g_return_val_if_fail (error == NULL || *error == NULL, -1);
+	GSimpleAsyncResult *res;
+	SearchClosure *closure;
 
-	return service_xlock_finish (service, result, locked, error);
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (service),
+	                      secret_service_search_collections), NULL);
+
+	res = G_SIMPLE_ASYNC_RESULT (result);
+
+	if (_secret_util_propagate_error (res, error))
+		return NULL;
+
+	closure = g_simple_async_result_get_op_res_gpointer (res);
+	return search_closure_build_results (closure);
 }
 
 /**
- * secret_service_lock_sync:
+ * secret_service_search_collections_sync:
  * @service: (allow-none): the secret service
- * @objects: (element-type Gio.DBusProxy): the items or collections to lock
+ * @collections: (element-type SecretUnstable.Collection): the collections to search
+ * @schema: (allow-none): the schema for the attributes
+ * @attributes: (element-type utf8 utf8): search for items matching these attributes
+ * @flags: search option flags
  * @cancellable: optional cancellation object
- * @locked: (out) (element-type Gio.DBusProxy) (transfer full) (allow-none):
- *          location to place list of items or collections that were locked
- * @error: location to place an error on failure
+ * @error: location to place error on failure
  *
- * Lock items or collections in the secret service.
+ * Search for items matching the @attributes in each of the @collections.
+ * The searches are all sent at once, and the matching items are merged
+ * in the order of @collections. An item found by more than one search is
+ * only returned once.
  *
- * The secret service may not be able to lock items individually, and may
- * lock an entire collection instead.
+ * Items in collections that are locked are treated as locked items. The
+ * @flags have the same meaning as for secret_service_search_sync().
  *
  * If @service is NULL, then secret_service_get_sync() will be called to get
  * the default #SecretService proxy.
  *
- * This method may block indefinitely and should not be used in user
- * interface threads. The secret service may prompt the user.
- * secret_service_prompt() will be used to handle any prompts that show up.
+ * This method may block indefinitely and should not be used in user interface
+ * threads.
  *
- * Returns: the number of items or collections that were locked
+ * Returns: (transfer full) (element-type SecretUnstable.Item):
+ *          a list of items that matched the search
  */
-gint
-secret_service_lock_sync (SecretService *service,
-                          GList *objects,
-                          GCancellable *cancellable,
-                          GList **locked,
-                          GError **error)
+GList *
+secret_service_search_collections_sync (SecretService *service,
+                                        GList *collections,
+                                        const SecretSchema *schema,
+                                        GHashTable *attributes,
+                                        SecretSearchFlags flags,
+                                        GCancellable *cancellable,
+                                        GError **error)
 {
+	GSimpleAsyncResult *res;
+	SearchClosure *closure;
+	const gchar *schema_name = NULL;
 	SecretSync *sync;
-	gint count;
+	GList *items = NULL;
+	GList *l;
 
-	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), -1);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), -1);
-	g_return_val_if_fail (error == NULL || *error == NULL, -1);
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), NULL);
+	g_return_val_if_fail (attributes != NULL, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	for (l = collections; l != NULL; l = g_list_next (l))
+		g_return_val_if_fail (SECRET_IS_COLLECTION (l->data), NULL);
+
+	/* Warnings raised already */
+	if (schema != NULL && !_secret_attributes_validate (schema, attributes, G_STRFUNC, TRUE))
+		return NULL;
+
+	if (schema != NULL && !(schema->flags & SECRET_SCHEMA_DONT_MATCH_NAME))
+		schema_name = schema->name;
 
+	if (service == NULL) {
+		service = secret_service_get_sync (SECRET_SERVICE_NONE, cancellable, error);
+		if (service == NULL)
+			return NULL;
+	} else {
+		g_object_ref (service);
+	}
+
+	closure = g_slice_new0 (SearchClosure);
+	closure->service = service;
+	closure->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	closure->items = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	closure->flags = flags;
+	closure->attributes = _secret_attributes_to_variant (attributes, schema_name);
+	g_variant_ref_sink (closure->attributes);
+	closure->collections = g_list_copy (collections);
+	for (l = closure->collections; l != NULL; l = g_list_next (l))
+		g_object_ref (l->data);
+	closure->collection_paths = g_new0 (GVariant *, g_list_length (collections));
+	closure->paths_only = TRUE;
+
+	/* All the searches are sent at once, the items are then loaded at once */
 	sync = _secret_sync_new ();
 	g_main_context_push_thread_default (sync->context);
 
-	secret_service_lock (service, objects, cancellable,
-	                     _secret_sync_on_result, sync);
-
-	g_main_loop_run (sync->loop);
+	res = g_simple_async_result_new (G_OBJECT (service), _secret_sync_on_result, sync,
+	                                 secret_service_search_collections_sync);
+	g_simple_async_result_set_op_res_gpointer (res, closure, NULL);
+	search_collections_send (res, closure);
 
-	count = secret_service_lock_finish (service, sync->result, locked, error);
+	if (sync->result == NULL)
+		g_main_loop_run (sync->loop);
 
 	g_main_context_pop_thread_default (sync->context);
 	_secret_sync_free (sync);
 
-	return count;
+	if (!_secret_util_propagate_error (res, error))
+		items = search_closure_load_sync (closure, cancellable, error);
+
+	g_object_unref (res);
+	search_closure_free (closure);
+	return items;
 }
 
-/**
- * secret_service_unlock:
- * @service: (allow-none): the secret service
- * @objects: (element-type Gio.DBusProxy): the items or collections to unlock
- * @cancellable: optional cancellation object
- * @callback: called when the operation completes
- * @user_data: data to pass to the callback
- *
+static GVariant *
+search_pack_items (GList *items)
+{
+	GVariantBuilder builder;
+	GVariant *label;
+	GVariant *attributes;
+	SecretValue *value;
+	const gchar *secret;
+	const gchar *content_type;
+	gsize length;
+	GList *l;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(osa{ss}ays)"));
+
+	/* Use the cached properties as is, without building hash tables */
+	for (l = items; l != NULL; l = g_list_next (l)) {
+		label = g_dbus_proxy_get_cached_property (l->data, "Label");
+		if (label == NULL)
+			label = g_variant_ref_sink (g_variant_new_string (""));
+		attributes = g_dbus_proxy_get_cached_property (l->data, "Attributes");
+		if (attributes == NULL)
+			attributes = g_variant_ref_sink (g_variant_new_array (G_VARIANT_TYPE ("{ss}"), NULL, 0));
+
+		secret = "";
+		length = 0;
+		content_type = "";
+		value = secret_item_get_secret (l->data);
+		if (value != NULL) {
+			secret = secret_value_get (value, &length);
+			content_type = secret_value_get_content_type (value);
+		}
+
+		g_variant_builder_add (&builder, "(o@s@a{ss}@ays)",
+		                       g_dbus_proxy_get_object_path (l->data), label, attributes,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, secret, length, 1),
+		                       content_type);
+
+		if (value != NULL)
+			secret_value_unref (value);
+		g_variant_unref (attributes);
+		g_variant_unref (label);
+	}
+
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static void
+on_search_packed (GObject *source,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
+	GError *error = NULL;
+	GList *items;
+
+	items = secret_service_search_finish (source ? SECRET_SERVICE (source) : NULL,
+	                                      result, &error);
+	if (error == NULL) {
+		g_simple_async_result_set_op_res_gpointer (res, search_pack_items (items),
+		                                           (GDestroyNotify)g_variant_unref);
+		g_list_free_full (items, g_object_unref);
+	} else {
+		g_simple_async_result_take_error (res, error);
+	}
+
+	g_simple_async_result_complete (res);
+	g_object_unref (res);
+}
+
+/**
+ * secret_service_search_packed:
+ * @service: (allow-none): the secret service
+ * @schema: (allow-none): the schema for the attributes
+ * @attributes: (element-type utf8 utf8): search for items matching these attributes
+ * @flags: search option flags
+ * @cancellable: optional cancellation object
+ * @callback: called when the operation completes
+ * @user_data: data to pass to the callback
+ *
+ * Search for items matching the @attributes, in the same way as
+ * secret_service_search(), and return the results packed into a single
+ * #GVariant. This is meant for language bindings, where returning the
+ * results in one value is much cheaper than a #SecretItem for each
+ * result.
+ *
+ * This function returns immediately and completes asynchronously.
+ */
+void
+secret_service_search_packed (SecretService *service,
+                              const SecretSchema *schema,
+                              GHashTable *attributes,
+                              SecretSearchFlags flags,
+                              GCancellable *cancellable,
+                              GAsyncReadyCallback callback,
+                              gpointer user_data)
+{
+	GSimpleAsyncResult *res;
+
+	g_return_if_fail (service == NULL || SECRET_IS_SERVICE (service));
+	g_return_if_fail (attributes != NULL);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	/* Warnings raised already */
+	if (schema != NULL && !_secret_attributes_validate (schema, attributes, G_STRFUNC, TRUE))
+		return;
+
+	res = g_simple_async_result_new (G_OBJECT (service), callback, user_data,
+	                                 secret_service_search_packed);
+
+	secret_service_search (service, schema, attributes, flags, cancellable,
+	                       on_search_packed, g_object_ref (res));
+
+	g_object_unref (res);
+}
+
+/**
+ * secret_service_search_packed_finish:
+ * @service: (allow-none): the secret service
+ * @result: asynchronous result passed to callback
+ * @error: location to place error on failure
+ *
+ * Complete asynchronous operation to search for items, and return them
+ * packed into a #GVariant.
+ *
+ * The result is an array of type <literal>a(osa{ss}ays)</literal>, with an
+ * entry for each item that matched, in the same order as returned by
+ * secret_service_search_finish(). Each entry contains the item's D-Bus
+ * object path, label, attributes, secret value and secret content type.
+ * The secret value and content type are empty unless the secret was
+ * loaded with %SECRET_SEARCH_LOAD_SECRETS.
+ *
+ * Note that the secret values are copied into the #GVariant, which is
+ * not allocated in non-pageable memory.
+ *
+ * Returns: (transfer full): the packed search results
+ */
+GVariant *
+secret_service_search_packed_finish (SecretService *service,
+                                     GAsyncResult *result,
+                                     GError **error)
+{
+	GSimpleAsyncResult *res;
+
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+	g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (service),
+	                      secret_service_search_packed), NULL);
+
+	res = G_SIMPLE_ASYNC_RESULT (result);
+
+	if (_secret_util_propagate_error (res, error))
+		return NULL;
+
+	return g_variant_ref (g_simple_async_result_get_op_res_gpointer (res));
+}
+
+/**
+ * secret_service_search_packed_sync:
+ * @service: (allow-none): the secret service
+ * @schema: (allow-none): the schema for the attributes
+ * @attributes: (element-type utf8 utf8): search for items matching these attributes
+ * @flags: search option flags
+ * @cancellable: optional cancellation object
+ * @error: location to place error on failure
+ *
+ * Search for items matching the @attributes, in the same way as
+ * secret_service_search_sync(), and return the results packed into a
+ * single #GVariant. See secret_service_search_packed_finish() for the
+ * format of the result.
+ *
+ * This method may block indefinitely and should not be used in user interface
+ * threads.
+ *
+ * Returns: (transfer full): the packed search results
+ */
+GVariant *
+secret_service_search_packed_sync (SecretService *service,
+                                   const SecretSchema *schema,
+                                   GHashTable *attributes,
+                                   SecretSearchFlags flags,
+                                   GCancellable *cancellable,
+                                   GError **error)
+{
+	GError *lerror = NULL;
+	GVariant *packed;
+	GList *items;
+
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), NULL);
+	g_return_val_if_fail (attributes != NULL, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	/* Warnings raised already */
+	if (schema != NULL && !_secret_attributes_validate (schema, attributes, G_STRFUNC, TRUE))
+		return NULL;
+
+	items = secret_service_search_sync (service, schema, attributes, flags,
+	                                    cancellable, &lerror);
+	if (lerror != NULL) {
+		g_propagate_error (error, lerror);
+		return NULL;
+	}
+
+	packed = search_pack_items (items);
+	g_list_free_full (items, g_object_unref);
+	return packed;
+}
+
+SecretValue *
+_secret_service_decode_get_secrets_first (SecretService *self,
+                                          GVariant *out)
+{
+	SecretSession *session;
+	SecretValue *value = NULL;
+	GVariantIter *iter;
+	GVariant *variant;
+	const gchar *path;
+
+	g_variant_get (out, "(a{o(oayays)})", &iter);
+	while (g_variant_iter_next (iter, "{&o@(oayays)}", &path, &variant)) {
+		session = _secret_service_get_session (self);
+		value = _secret_session_decode_secret (session, variant);
+		g_variant_unref (variant);
+		break;
+	}
+	g_variant_iter_free (iter);
+	return value;
+}
+
+GHashTable *
+_secret_service_decode_get_secrets_all (SecretService *self,
+                                        GVariant *out)
+{
+	SecretSession *session;
+	GVariantIter *iter;
+	GVariant *variant;
+	GHashTable *values;
+	SecretValue *value;
+	gchar *path;
+
+	session = _secret_service_get_session (self);
+	values = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                g_free, secret_value_unref);
+	g_variant_get (out, "(a{o(oayays)})", &iter);
+	while (g_variant_iter_loop (iter, "{o@(oayays)}", &path, &variant)) {
+		value = _secret_session_decode_secret (session, variant);
+		if (value && path)
+			g_hash_table_insert (values, g_strdup (path), value);
+	}
+	g_variant_iter_free (iter);
+	return values;
+}
+
+typedef struct {
+	GCancellable *cancellable;
+	GPtrArray *paths;
+	GHashTable *objects;
+	gchar **xlocked;
+	guint count;
+	gboolean locking;
+} XlockClosure;
+
+static void
+xlock_closure_free (gpointer data)
+{
+	XlockClosure *closure = data;
+	if (closure->cancellable)
+		g_object_unref (closure->cancellable);
+	g_ptr_array_free (closure->paths, TRUE);
+	g_strfreev (closure->xlocked);
+	g_hash_table_unref (closure->objects);
+	g_slice_free (XlockClosure, closure);
+}
+
+static void
+on_xlock_paths (GObject *source,
+                GAsyncResult *result,
+                gpointer user_data)
+{
+	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
+	XlockClosure *xlock = g_simple_async_result_get_op_res_gpointer (async);
+	GVariant *lockval;
+	GDBusProxy *object;
+	GError *error = NULL;
+	gint i;
+
+	xlock->count = _secret_service_xlock_paths_finish (SECRET_SERVICE (source), result,
+	                                                   &xlock->xlocked, &error);
+
+	if (error == NULL) {
+		/*
+		 * After a lock or unlock we want the Locked property to immediately
+		 * reflect the new state, and not have to wait for a PropertiesChanged
+		 * signal to be processed later.
+		 */
+
+		lockval = g_variant_ref_sink (g_variant_new_boolean (xlock->locking));
+		for (i = 0; xlock->xlocked[i] != NULL; i++) {
+			object =  g_hash_table_lookup (xlock->objects, xlock->xlocked[i]);
+			if (object != NULL)
+				g_dbus_proxy_set_cached_property (object, "Locked", lockval);
+		}
+		g_variant_unref (lockval);
+
+	} else {
+		g_simple_async_result_take_error (async, error);
+	}
+
+	g_simple_async_result_complete (async);
+	g_object_unref (async);
+}
+
+static void
+on_xlock_service (GObject *source,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
+	XlockClosure *xlock = g_simple_async_result_get_op_res_gpointer (async);
+	GError *error = NULL;
+	SecretService *service;
+
+	service = secret_service_get_finish (result, &error);
+	if (error == NULL) {
+		_secret_service_xlock_paths_async (service, xlock->locking ? "Lock" : "Unlock",
+		                                   (const gchar **)xlock->paths->pdata,
+		                                   xlock->cancellable, on_xlock_paths,
+		                                   g_object_ref (async));
+		g_object_unref (service);
+
+	} else {
+		g_simple_async_result_take_error (async, error);
+		g_simple_async_result_complete (async);
+	}
+
+	g_object_unref (async);
+}
+
+static void
+service_xlock_async (SecretService *service,
+                     gboolean locking,
+                     GList *objects,
+                     GCancellable *cancellable,
+                     GAsyncReadyCallback callback,
+                     gpointer user_data)
+{
+	GSimpleAsyncResult *async;
+	XlockClosure *xlock;
+	const gchar *path;
+	GList *l;
+
+	async = g_simple_async_result_new (G_OBJECT (service), callback, user_data,
+	                                   service_xlock_async);
+	xlock = g_slice_new0 (XlockClosure);
+	xlock->objects = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+	xlock->locking = locking;
+	xlock->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	xlock->paths = g_ptr_array_new ();
+
+	for (l = objects; l != NULL; l = g_list_next (l)) {
+		path = g_dbus_proxy_get_object_path (l->data);
+		g_ptr_array_add (xlock->paths, (gpointer)path);
+		g_hash_table_insert (xlock->objects, g_strdup (path), g_object_ref (l->data));
+	}
+	g_ptr_array_add (xlock->paths, NULL);
+
+	g_simple_async_result_set_op_res_gpointer (async, xlock, xlock_closure_free);
+
+	if (service == NULL) {
+		secret_service_get (SECRET_SERVICE_NONE, cancellable,
+		                    on_xlock_service, g_object_ref (async));
+	} else {
+		_secret_service_xlock_paths_async (service, xlock->locking ? "Lock" : "Unlock",
+		                                   (const gchar **)xlock->paths->pdata,
+		                                   xlock->cancellable, on_xlock_paths,
+		                                   g_object_ref (async));
+	}
+
+	g_object_unref (async);
+}
+
+static gint
+service_xlock_finish (SecretService *service,
+                      GAsyncResult *result,
+                      GList **xlocked,
+                      GError **error)
+{
+	GSimpleAsyncResult *async;
+	XlockClosure *xlock;
+	GDBusProxy *object;
+	gint i;
+
+	g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (service),
+	                                                      service_xlock_async), -1);
+
+	async = G_SIMPLE_ASYNC_RESULT (result);
+	if (_secret_util_propagate_error (async, error))
+		return -1;
+
+	xlock = g_simple_async_result_get_op_res_gpointer (async);
+	if (xlocked) {
+		*xlocked = NULL;
+		for (i = 0; xlock->xlocked[i] != NULL; i++) {
+			object = g_hash_table_lookup (xlock->objects, xlock->xlocked[i]);
+			if (object != NULL)
+				*xlocked = g_list_prepend (*xlocked, g_object_ref (object));
+		}
+	}
+
+	return xlock->count;
+}
+
+/**
+ * secret_service_lock:
+ * @service: (allow-none): the secret service
+ * @objects: (element-type Gio.DBusProxy): the items or collections to lock
+ * @cancellable: optional cancellation object
+ * @callback: called when the operation completes
+ * @user_data: data to pass to the callback
+ *
+ * Lock items or collections in the secret service.
+ *
+ * The secret service may not be able to lock items individually, and may
+ * lock an entire collection instead.
+ *
+ * If @service is NULL, then secret_service_get() will be called to get
+ * the default #SecretService proxy.
+ *
+ * This method returns immediately and completes asynchronously. The secret
+ * service may prompt the user. secret_service_prompt() will be used to handle
+ * any prompts that show up.
+ */
+void
+secret_service_lock (SecretService *service,
+                     GList *objects,
+                     GCancellable *cancellable,
+                     GAsyncReadyCallback callback,
+                     gpointer user_data)
+{
+	g_return_if_fail (service == NULL || SECRET_IS_SERVICE (service));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	service_xlock_async (service, TRUE, objects, cancellable, callback, user_data);
+}
+
+/**
+ * secret_service_lock_finish:
+ * @service: (allow-none): the secret service
+ * @result: asynchronous result passed to the callback
+ * @locked: (out) (element-type Gio.DBusProxy) (transfer full) (allow-none):
+ *          location to place list of items or collections that were locked
+ * @error: location to place an error on failure
+ *
+ * Complete asynchronous operation to lock items or collections in the secret
+ * service.
+ *
+ * The secret service may not be able to lock items individually, and may
+ * lock an entire collection instead.
+ *
+ * Returns: the number of items or collections that were locked
+ */
+gint
+secret_service_lock_finish (SecretService *service,
+                            GAsyncResult *result,
+                            GList **locked,
+                            GError **error)
+{
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), -1);
+	g_return_val_if_fail (error == NULL || *error == NULL, -1);
+
+	return service_xlock_finish (service, result, locked, error);
+}
+
+/**
+ * secret_service_lock_sync:
+ * @service: (allow-none): the secret service
+ * @objects: (element-type Gio.DBusProxy): the items or collections to lock
+ * @cancellable: optional cancellation object
+ * @locked: (out) (element-type Gio.DBusProxy) (transfer full) (allow-none):
+ *          location to place list of items or collections that were locked
+ * @error: location to place an error on failure
+ *
+ * Lock items or collections in the secret service.
+ *
+ * The secret service may not be able to lock items individually, and may
+ * lock an entire collection instead.
+ *
+ * If @service is NULL, then secret_service_get_sync() will be called to get
+ * the default #SecretService proxy.
+ *
+ * This method may block indefinitely and should not be used in user
+ * interface threads. The secret service may prompt the user.
+ * secret_service_prompt() will be used to handle any prompts that show up.
+ *
+ * Returns: the number of items or collections that were locked
+ */
+gint
+secret_service_lock_sync (SecretService *service,
+                          GList *objects,
+                          GCancellable *cancellable,
+                          GList **locked,
+                          GError **error)
+{
+	SecretSync *sync;
+	gint count;
+
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), -1);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), -1);
+	g_return_val_if_fail (error == NULL || *error == NULL, -1);
+
+	sync = _secret_sync_new ();
+	g_main_context_push_thread_default (sync->context);
+
+	secret_service_lock (service, objects, cancellable,
+	                     _secret_sync_on_result, sync);
+
+	g_main_loop_run (sync->loop);
+
+	count = secret_service_lock_finish (service, sync->result, locked, error);
+
+	g_main_context_pop_thread_default (sync->context);
+	_secret_sync_free (sync);
+
+	return count;
+}
+
+/**
+ * secret_service_unlock:
+ * @service: (allow-none): the secret service
+ * @objects: (element-type Gio.DBusProxy): the items or collections to unlock
+ * @cancellable: optional cancellation object
+ * @callback: called when the operation completes
+ * @user_data: data to pass to the callback
+ *
+ * Unlock items or collections in the secret service.
+ *
+ * The secret service may not be able to unlock items individually, and may
+ * unlock an entire collection instead.
+ *
+ * If @service is NULL, then secret_service_get() will be called to get
+ * the default #SecretService proxy.
+ *
+ * This method may block indefinitely and should not be used in user
+ * interface threads. The secret service may prompt the user.
+ * secret_service_prompt() will be used to handle any prompts that show up.
+ */
+void
+secret_service_unlock (SecretService *service,
+                       GList *objects,
+                       GCancellable *cancellable,
+                       GAsyncReadyCallback callback,
+                       gpointer user_data)
+{
+	g_return_if_fail (service == NULL || SECRET_IS_SERVICE (service));
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	service_xlock_async (service, FALSE, objects, cancellable, callback, user_data);
+}
+
+/**
+ * secret_service_unlock_finish:
+ * @service: (allow-none): the secret service
+ * @result: asynchronous result passed to the callback
+ * @unlocked: (out) (element-type Gio.DBusProxy) (transfer full) (allow-none):
+ *            location to place list of items or collections that were unlocked
+ * @error: location to place an error on failure
+ *
+ * Complete asynchronous operation to unlock items or collections in the secret
+ * service.
+ *
+ * The secret service may not be able to unlock items individually, and may
+ * unlock an entire collection instead.
+ *
+ * Returns: the number of items or collections that were unlocked
+ */
+gint
+secret_service_unlock_finish (SecretService *service,
+                              GAsyncResult *result,
+                              GList **unlocked,
+                              GError **error)
+{
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), -1);
+	g_return_val_if_fail (error == NULL || *error == NULL, -1);
+
+	return service_xlock_finish (service, result, unlocked, error);
+}
+
+/**
+ * secret_service_unlock_sync:
+ * @service: (allow-none): the secret service
+ * @objects: (element-type Gio.DBusProxy): the items or collections to unlock
+ * @cancellable: optional cancellation object
+ * @unlocked: (out) (element-type Gio.DBusProxy) (transfer full) (allow-none):
+ *            location to place list of items or collections that were unlocked
+ * @error: location to place an error on failure
+ *
  * Unlock items or collections in the secret service.
  *
- * The secret service may not be able to unlock items individually, and may
- * unlock an entire collection instead.
+ * The secret service may not be able to unlock items individually, and may
+ * unlock an entire collection instead.
+ *
+ * If @service is NULL, then secret_service_get_sync() will be called to get
+ * the default #SecretService proxy.
+ *
+ * This method may block indefinitely and should not be used in user
+ * interface threads. The secret service may prompt the user.
+ * secret_service_prompt() will be used to handle any prompts that show up.
+ *
+ * Returns: the number of items or collections that were unlocked
+ */
+gint
+secret_service_unlock_sync (SecretService *service,
+                            GList *objects,
+                            GCancellable *cancellable,
+                            GList **unlocked,
+                            GError **error)
+{
+	SecretSync *sync;
+	gint count;
+
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), -1);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), -1);
+	g_return_val_if_fail (error == NULL || *error == NULL, -1);
+
+	sync = _secret_sync_new ();
+	g_main_context_push_thread_default (sync->context);
+
+	secret_service_unlock (service, objects, cancellable,
+	                       _secret_sync_on_result, sync);
+
+	g_main_loop_run (sync->loop);
+
+	count = secret_service_unlock_finish (service, sync->result, unlocked, error);
+
+	g_main_context_pop_thread_default (sync->context);
+	_secret_sync_free (sync);
+
+	return count;
+}
+
+typedef struct {
+	GCancellable *cancellable;
+	gchar *collection_path;
+	SecretValue *value;
+	GHashTable *properties;
+	gboolean created_collection;
+	gboolean unlocked_collection;
+	gboolean unlock_hinted;
+} StoreClosure;
+
+static void
+store_closure_free (gpointer data)
+{
+	StoreClosure *store = data;
+	if (store->cancellable)
+		g_object_unref (store->cancellable);
+	g_free (store->collection_path);
+	secret_value_unref (store->value);
+	g_hash_table_unref (store->properties);
+	g_slice_free (StoreClosure, store);
+}
+
+static void
+on_store_create (GObject *source,
+                 GAsyncResult *result,
+                 gpointer user_data);
+
+static void
+on_store_keyring (GObject *source,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
+	StoreClosure *store = g_simple_async_result_get_op_res_gpointer (async);
+	SecretService *service = SECRET_SERVICE (source);
+	GError *error = NULL;
+	gchar *path;
+
+	path = secret_service_create_collection_dbus_path_finish (service, result, &error);
+	if (error == NULL) {
+		store->created_collection = TRUE;
+		secret_service_create_item_dbus_path (service, store->collection_path,
+		                                      store->properties, store->value,
+		                                      SECRET_ITEM_CREATE_REPLACE, store->cancellable,
+		                                      on_store_create, g_object_ref (async));
+	} else {
+		g_simple_async_result_take_error (async, error);
+		g_simple_async_result_complete (async);
+	}
+
+	g_object_unref (async);
+	g_free (path);
+}
+
+static void
+on_store_unlock (GObject *source,
+                 GAsyncResult *result,
+                 gpointer user_data)
+{
+	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
+	StoreClosure *store = g_simple_async_result_get_op_res_gpointer (async);
+	SecretService *service = SECRET_SERVICE (source);
+	GError *error = NULL;
+
+	if (secret_service_unlock_dbus_paths_finish (service, result, NULL, &error) > 0)
+		_secret_service_remember_locked (service, store->collection_path, FALSE);
+
+	/* The hint may have been stale, let CreateItem tell whether it's locked */
+	if (error != NULL && store->unlock_hinted &&
+	    !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		_secret_service_remember_locked (service, store->collection_path, FALSE);
+		store->unlock_hinted = FALSE;
+		secret_service_create_item_dbus_path (service, store->collection_path,
+		                                      store->properties, store->value,
+		                                      SECRET_ITEM_CREATE_REPLACE, store->cancellable,
+		                                      on_store_create, g_object_ref (async));
+		g_error_free (error);
+
+	} else if (error == NULL) {
+		store->unlocked_collection = TRUE;
+		secret_service_create_item_dbus_path (service, store->collection_path,
+		                                      store->properties, store->value,
+		                                      SECRET_ITEM_CREATE_REPLACE, store->cancellable,
+		                                      on_store_create, g_object_ref (async));
+	} else {
+		g_simple_async_result_take_error (async, error);
+		g_simple_async_result_complete (async);
+	}
+
+	g_object_unref (async);
+}
+
+static void
+on_store_create (GObject *source,
+                 GAsyncResult *result,
+                 gpointer user_data)
+{
+	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
+	StoreClosure *store = g_simple_async_result_get_op_res_gpointer (async);
+	SecretService *service = SECRET_SERVICE (source);
+	GError *error = NULL;
+	GHashTable *properties;
+
+	_secret_service_create_item_dbus_path_finish_raw (result, &error);
+
+	/*
+	 * This happens when the collection doesn't exist. If the collection is
+	 * the default alias, we should try and create it
+	 */
+
+	if (!store->created_collection &&
+	    (g_error_matches (error, SECRET_ERROR, SECRET_ERROR_NO_SUCH_OBJECT) ||
+	     g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) &&
+	    g_strcmp0 (store->collection_path, SECRET_ALIAS_PREFIX "default") == 0) {
+		properties = _secret_collection_properties_new (_("Default keyring"));
+		secret_service_create_collection_dbus_path (service, properties, "default",
+		                                            SECRET_COLLECTION_CREATE_NONE, store->cancellable,
+		                                            on_store_keyring, g_object_ref (async));
+		g_hash_table_unref (properties);
+		g_error_free (error);
+
+	} else if (!store->unlocked_collection &&
+	           g_error_matches (error, SECRET_ERROR, SECRET_ERROR_IS_LOCKED)) {
+		const gchar *paths[2] = { store->collection_path, NULL };
+		_secret_service_remember_locked (service, store->collection_path, TRUE);
+		secret_service_unlock_dbus_paths (service, paths, store->cancellable,
+		                                  on_store_unlock, g_object_ref (async));
+		g_error_free (error);
+	} else {
+		if (error != NULL)
+			g_simple_async_result_take_error (async, error);
+		g_simple_async_result_complete (async);
+	}
+
+	g_object_unref (async);
+}
+
+static void
+store_create_or_unlock (SecretService *service,
+                        GSimpleAsyncResult *async)
+{
+	StoreClosure *store = g_simple_async_result_get_op_res_gpointer (async);
+	const gchar *paths[2] = { store->collection_path, NULL };
+
+	/* Don't wait for CreateItem to tell us what we already know */
+	if (_secret_service_known_locked (service, store->collection_path)) {
+		store->unlock_hinted = TRUE;
+		secret_service_unlock_dbus_paths (service, paths, store->cancellable,
+		                                  on_store_unlock, g_object_ref (async));
+	} else {
+		secret_service_create_item_dbus_path (service, store->collection_path,
+		                                      store->properties, store->value,
+		                                      SECRET_ITEM_CREATE_REPLACE, store->cancellable,
+		                                      on_store_create, g_object_ref (async));
+	}
+}
+
+static void
+on_store_service (GObject *source,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
+	SecretService *service;
+	GError *error = NULL;
+
+	service = secret_service_get_finish (result, &error);
+	if (error == NULL) {
+		store_create_or_unlock (service, async);
+		g_object_unref (service);
+
+	} else {
+		g_simple_async_result_take_error (async, error);
+		g_simple_async_result_complete (async);
+	}
+
+	g_object_unref (async);
+}
+
+/**
+ * secret_service_store:
+ * @service: (allow-none): the secret service
+ * @schema: (allow-none): the schema to use to check attributes
+ * @attributes: (element-type utf8 utf8): the attribute keys and values
+ * @collection: (allow-none): a collection alias, or D-Bus object path of the collection where to store the secret
+ * @label: label for the secret
+ * @value: the secret value
+ * @cancellable: optional cancellation object
+ * @callback: called when the operation completes
+ * @user_data: data to be passed to the callback
+ *
+ * Store a secret value in the secret service.
+ *
+ * The @attributes should be a set of key and value string pairs.
+ *
+ * If the attributes match a secret item already stored in the collection, then
+ * the item will be updated with these new values.
  *
  * If @service is NULL, then secret_service_get() will be called to get
  * the default #SecretService proxy.
  *
- * This method may block indefinitely and should not be used in user
- * interface threads. The secret service may prompt the user.
- * secret_service_prompt() will be used to handle any prompts that show up.
+ * If @collection is not specified, then the default collection will be
+ * used. Use #SECRET_COLLECTION_SESSION to store the password in the session
+ * collection, which doesn't get stored across login sessions.
+ *
+ * This method will return immediately and complete asynchronously.
  */
 void
-secret_service_unlock (SecretService *service,
-                       GList *objects,
-                       GCancellable *cancellable,
-                       GAsyncReadyCallback callback,
-                       gpointer user_data)
+secret_service_store (SecretService *service,
+                      const SecretSchema *schema,
+                      GHashTable *attributes,
+                      const gchar *collection,
+                      const gchar *label,
+                      SecretValue *value,
+                      GCancellable *cancellable,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data)
 {
+	GSimpleAsyncResult *async;
+	StoreClosure *store;
+	const gchar *schema_name;
+	GVariant *propval;
+
 	g_return_if_fail (service == NULL || SECRET_IS_SERVICE (service));
+	g_return_if_fail (attributes != NULL);
+	g_return_if_fail (label != NULL);
+	g_return_if_fail (value != NULL);
 	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
-	service_xlock_async (service, FALSE, objects, cancellable, callback, user_data);
+	/* Warnings raised already */
+	if (schema != NULL && !_secret_attributes_validate (schema, attributes, G_STRFUNC, FALSE))
+		return;
+
+	async = g_simple_async_result_new  (G_OBJECT (service), callback, user_data,
+	                                    secret_service_store);
+	store = g_slice_new0 (StoreClosure);
+	store->collection_path = _secret_util_collection_to_path (collection);
+	store->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	store->value = secret_value_ref (value);
+	store->properties = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+	                                           (GDestroyNotify)g_variant_unref);
+
+	propval = g_variant_new_string (label);
+	g_hash_table_insert (store->properties,
+	                     SECRET_ITEM_INTERFACE ".Label",
+	                     g_variant_ref_sink (propval));
+
+	/* Always store the schema name in the attributes */
+	schema_name = (schema == NULL) ? NULL : schema->name;
+	propval = _secret_attributes_to_variant (attributes, schema_name);
+	g_hash_table_insert (store->properties,
+	                     SECRET_ITEM_INTERFACE ".Attributes",
+	                     g_variant_ref_sink (propval));
+
+	g_simple_async_result_set_op_res_gpointer (async, store, store_closure_free);
+
+	if (service == NULL) {
+		secret_service_get (SECRET_SERVICE_OPEN_SESSION, cancellable,
+		                    on_store_service, g_object_ref (async));
+
+	} else {
+		store_create_or_unlock (service, async);
+	}
+
+	g_object_unref (async);
 }
 
 /**
- * secret_service_unlock_finish:
+ * secret_service_store_finish:
  * @service: (allow-none): the secret service
- * @result: asynchronous result passed to the callback
- * @unlocked: (out) (element-type Gio.DBusProxy) (transfer full) (allow-none):
- *            location to place list of items or collections that were unlocked
+ * @result: the asynchronous result passed to the callback
  * @error: location to place an error on failure
  *
- * Complete asynchronous operation to unlock items or collections in the secret
- * service.
- *
- * The secret service may not be able to unlock items individually, and may
- * unlock an entire collection instead.
+ * Finish asynchronous operation to store a secret value in the secret service.
  *
- * Returns: the number of items or collections that were unlocked
+ * Returns: whether the storage was successful or not
  */
-gint
-secret_service_unlock_finish (SecretService *service,
-                              GAsyncResult *result,
-                              GList **unlocked,
-                              GError **error)
+gboolean
+secret_service_store_finish (SecretService *service,
+                             GAsyncResult *result,
+                             GError **error)
 {
-	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), -1);
-	g_return_val_if_fail (error == NULL || *error == NULL, -1);
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), FALSE);
+	g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (service),
+	                                                      secret_service_store), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-	return service_xlock_finish (service, result, unlocked, error);
+	if (_secret_util_propagate_error (G_SIMPLE_ASYNC_RESULT (result), error))
+		return FALSE;
+
+	return TRUE;
 }
 
 /**
- * secret_service_unlock_sync:
+ * secret_service_store_sync:
  * @service: (allow-none): the secret service
- * @objects: (element-type Gio.DBusProxy): the items or collections to unlock
+ * @schema: (allow-none): the schema for the attributes
+ * @attributes: (element-type utf8 utf8): the attribute keys and values
+ * @collection: (allow-none): a collection alias, or D-Bus object path of the collection where to store the secret
+ * @label: label for the secret
+ * @value: the secret value
  * @cancellable: optional cancellation object
- * @unlocked: (out) (element-type Gio.DBusProxy) (transfer full) (allow-none):
- *            location to place list of items or collections that were unlocked
  * @error: location to place an error on failure
  *
- * Unlock items or collections in the secret service.
+ * Store a secret value in the secret service.
  *
- * The secret service may not be able to unlock items individually, and may
- * unlock an entire collection instead.
+ * The @attributes should be a set of key and value string pairs.
+ *
+ * If the attributes match a secret item already stored in the collection, then
+ * the item will be updated with these new values.
+ *
+ * If @collection is %NULL, then the default collection will be
+ * used. Use #SECRET_COLLECTION_SESSION to store the password in the session
+ * collection, which doesn't get stored across login sessions.
  *
  * If @service is NULL, then secret_service_get_sync() will be called to get
  * the default #SecretService proxy.
  *
- * This method may block indefinitely and should not be used in user
- * interface threads. The secret service may prompt the user.
- * secret_service_prompt() will be used to handle any prompts that show up.
+ * This method may block indefinitely and should not be used in user interface
+ * threads.
  *
- * Returns: the number of items or collections that were unlocked
+ * Returns: whether the storage was successful or not
  */
-gint
-secret_service_unlock_sync (SecretService *service,
-                            GList *objects,
-                            GCancellable *cancellable,
-                            GList **unlocked,
-                            GError **error)
+gboolean
+secret_service_store_sync (SecretService *service,
+                           const SecretSchema *schema,
+                           GHashTable *attributes,
+                           const gchar *collection,
+                           const gchar *label,
+                           SecretValue *value,
+                           GCancellable *cancellable,
+                           GError **error)
 {
 	SecretSync *sync;
-	gint count;
+	gboolean ret;
 
-	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), -1);
-	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), -1);
-	g_return_val_if_fail (error == NULL || *error == NULL, -1);
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), FALSE);
+	g_return_val_if_fail (attributes != NULL, FALSE);
+	g_return_val_if_fail (label != NULL, FALSE);
+	g_return_val_if_fail (value != NULL, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	/* Warnings raised already */
+	if (schema != NULL && !_secret_attributes_validate (schema, attributes, G_STRFUNC, FALSE))
+		return FALSE;
 
 	sync = _secret_sync_new ();
 	g_main_context_push_thread_default (sync->context);
 
-	secret_service_unlock (service, objects, cancellable,
-	                       _secret_sync_on_result, sync);
+	secret_service_store (service, schema, attributes, collection,
+	                      label, value, cancellable, _secret_sync_on_result, sync);
 
 	g_main_loop_run (sync->loop);
 
-	count = secret_service_unlock_finish (service, sync->result, unlocked, error);
+	ret = secret_service_store_finish (service, sync->result, error);
 
 	g_main_context_pop_thread_default (sync->context);
 	_secret_sync_free (sync);
 
-	return count;
+	return ret;
 }
 
+typedef struct {
+	SecretAttributeSet *attributes;
+	gchar *label;
+	SecretValue *value;
+	gchar **unlocked;
+	gchar **locked;
+	gchar *item_path;
+	SecretItem *item;
+	SecretValue *current;
+	gboolean write;
+} StoreEntry;
+
+typedef enum {
+	STORE_SEARCHING,
+	STORE_COMPARING,
+	STORE_WRITING_FIRST,
+	STORE_WRITING,
+	STORE_DONE
+} StoreStage;
+
 typedef struct {
 	GCancellable *cancellable;
+	SecretService *service;
+	gchar *collection;
 	gchar *collection_path;
-	SecretValue *value;
-	GHashTable *properties;
-	gboolean created_collection;
-	gboolean unlocked_collection;
-} StoreClosure;
+	StoreEntry *entries;
+	guint n_entries;
+	StoreStage stage;
+	gint pending;
+	guint written;
+	guint skipped;
+	GError *error;
+} StoreIfClosure;
+
+typedef struct {
+	GSimpleAsyncResult *async;
+	StoreEntry *entry;
+} StoreIfCall;
 
 static void
-store_closure_free (gpointer data)
+store_if_closure_free (gpointer data)
 {
-	StoreClosure *store = data;
-	if (store->cancellable)
-		g_object_unref (store->cancellable);
-	g_free (store->collection_path);
-	secret_value_unref (store->value);
-	g_hash_table_unref (store->properties);
-	g_slice_free (StoreClosure, store);
+	StoreIfClosure *closure = data;
+	StoreEntry *entry;
+	guint i;
+
+	for (i = 0; i < closure->n_entries; i++) {
+		entry = closure->entries + i;
+		_secret_attribute_set_unref (entry->attributes);
+		g_free (entry->label);
+		secret_value_unref (entry->value);
+		g_strfreev (entry->unlocked);
+		g_strfreev (entry->locked);
+		g_free (entry->item_path);
+		g_clear_object (&entry->item);
+		if (entry->current)
+			secret_value_unref (entry->current);
+	}
+
+	g_free (closure->entries);
+	g_clear_object (&closure->service);
+	g_clear_object (&closure->cancellable);
+	g_free (closure->collection);
+	g_free (closure->collection_path);
+	g_clear_error (&closure->error);
+	g_slice_free (StoreIfClosure, closure);
+}
+
+static StoreIfCall *
+store_if_call_new (GSimpleAsyncResult *async,
+                   StoreEntry *entry)
+{
+	StoreIfCall *call = g_slice_new (StoreIfCall);
+	call->async = g_object_ref (async);
+	call->entry = entry;
+	return call;
 }
 
 static void
-on_store_create (GObject *source,
-                 GAsyncResult *result,
-                 gpointer user_data);
+store_if_call_free (StoreIfCall *call)
+{
+	g_object_unref (call->async);
+	g_slice_free (StoreIfCall, call);
+}
+
+static gboolean
+store_if_entry_unchanged (StoreEntry *entry)
+{
+	SecretAttributeSet *attributes;
+	gboolean unchanged;
+	GVariant *variant;
+	gchar *label;
+
+	if (entry->item == NULL || entry->current == NULL)
+		return FALSE;
+
+	variant = g_dbus_proxy_get_cached_property (G_DBUS_PROXY (entry->item), "Attributes");
+	if (variant == NULL)
+		return FALSE;
+
+	label = secret_item_get_label (entry->item);
+	attributes = _secret_attribute_set_new_for_variant (variant);
+
+	unchanged = g_strcmp0 (label, entry->label) == 0 &&
+	            _secret_attribute_set_equal (entry->attributes, attributes) &&
+	            _secret_value_equal (entry->value, entry->current);
+
+	_secret_attribute_set_unref (attributes);
+	g_variant_unref (variant);
+	g_free (label);
+
+	return unchanged;
+}
+
+/*
+ * Returns the one unlocked item in the collection that the service would
+ * replace, or NULL if it can't be known without writing.
+ */
+static gchar *
+store_if_entry_find_item (StoreEntry *entry,
+                          const gchar *collection_path)
+{
+	const gchar *found = NULL;
+	gchar *parent;
+	guint i;
+
+	for (i = 0; entry->locked && entry->locked[i] != NULL; i++) {
+		parent = _secret_util_parent_path (entry->locked[i]);
+		if (g_strcmp0 (parent, collection_path) == 0) {
+			g_free (parent);
+			return NULL;
+		}
+		g_free (parent);
+	}
+
+	for (i = 0; entry->unlocked && entry->unlocked[i] != NULL; i++) {
+		parent = _secret_util_parent_path (entry->unlocked[i]);
+		if (g_strcmp0 (parent, collection_path) == 0) {
+			if (found != NULL) {
+				g_free (parent);
+				return NULL;
+			}
+			found = entry->unlocked[i];
+		}
+		g_free (parent);
+	}
+
+	return g_strdup (found);
+}
 
 static void
-on_store_keyring (GObject *source,
-                  GAsyncResult *result,
-                  gpointer user_data)
+on_store_if_written (GObject *source,
+                     GAsyncResult *result,
+                     gpointer user_data);
+
+static void
+store_if_write_entry (GSimpleAsyncResult *async,
+                      StoreEntry *entry)
+{
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (async);
+	GHashTable *attributes;
+
+	/* The schema name is already in the attributes */
+	attributes = _secret_attribute_set_to_table (entry->attributes);
+	secret_service_store (closure->service, NULL, attributes, closure->collection,
+	                      entry->label, entry->value, closure->cancellable,
+	                      on_store_if_written, g_object_ref (async));
+	g_hash_table_unref (attributes);
+	closure->pending++;
+}
+
+static void
+store_if_step (GSimpleAsyncResult *async);
+
+static void
+store_if_compare (GSimpleAsyncResult *async)
+{
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (async);
+	StoreEntry *entry;
+	guint i;
+
+	closure->stage = STORE_WRITING_FIRST;
+
+	for (i = 0; i < closure->n_entries; i++) {
+		entry = closure->entries + i;
+		entry->write = !store_if_entry_unchanged (entry);
+		if (!entry->write)
+			closure->skipped++;
+	}
+
+	/*
+	 * The first write goes alone, so that a missing default collection
+	 * is created, or a locked collection unlocked, only once.
+	 */
+	for (i = 0; i < closure->n_entries; i++) {
+		entry = closure->entries + i;
+		if (entry->write) {
+			entry->write = FALSE;
+			store_if_write_entry (async, entry);
+			break;
+		}
+	}
+}
+
+static void
+store_if_write_rest (GSimpleAsyncResult *async)
+{
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (async);
+	StoreEntry *entry;
+	guint i;
+
+	closure->stage = STORE_WRITING;
+
+	for (i = 0; i < closure->n_entries; i++) {
+		entry = closure->entries + i;
+		if (entry->write)
+			store_if_write_entry (async, entry);
+	}
+}
+
+static void
+on_store_if_written (GObject *source,
+                     GAsyncResult *result,
+                     gpointer user_data)
 {
 	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
-	StoreClosure *store = g_simple_async_result_get_op_res_gpointer (async);
-	SecretService *service = SECRET_SERVICE (source);
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (async);
 	GError *error = NULL;
-	gchar *path;
 
-	path = secret_service_create_collection_dbus_path_finish (service, result, &error);
-	if (error == NULL) {
-		store->created_collection = TRUE;
-		secret_service_create_item_dbus_path (service, store->collection_path,
-		                                      store->properties, store->value,
-		                                      SECRET_ITEM_CREATE_REPLACE, store->cancellable,
-		                                      on_store_create, g_object_ref (async));
-	} else {
-		g_simple_async_result_take_error (async, error);
-		g_simple_async_result_complete (async);
+	if (secret_service_store_finish (SECRET_SERVICE (source), result, &error))
+		closure->written++;
+	else if (closure->error == NULL)
+		closure->error = error;
+	else
+		g_error_free (error);
+
+	closure->pending--;
+	store_if_step (async);
+	g_object_unref (async);
+}
+
+static void
+on_store_if_secrets (GObject *source,
+                     GAsyncResult *result,
+                     gpointer user_data)
+{
+	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (async);
+	StoreEntry *entry;
+	GHashTable *values;
+	SecretValue *value;
+	guint i;
+
+	/* On failure the items are simply written */
+	values = secret_service_get_secrets_for_dbus_paths_finish (closure->service, result, NULL);
+	if (values != NULL) {
+		for (i = 0; i < closure->n_entries; i++) {
+			entry = closure->entries + i;
+			if (entry->item_path == NULL || entry->current != NULL)
+				continue;
+			value = g_hash_table_lookup (values, entry->item_path);
+			if (value != NULL)
+				entry->current = secret_value_ref (value);
+		}
+		g_hash_table_unref (values);
 	}
 
+	closure->pending--;
+	store_if_step (async);
 	g_object_unref (async);
-	g_free (path);
 }
 
 static void
-on_store_unlock (GObject *source,
-                 GAsyncResult *result,
-                 gpointer user_data)
+on_store_if_item (GObject *source,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+	StoreIfCall *call = user_data;
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (call->async);
+
+	/* On failure the item is simply written */
+	call->entry->item = secret_item_new_for_dbus_path_finish (result, NULL);
+
+	closure->pending--;
+	store_if_step (call->async);
+	store_if_call_free (call);
+}
+
+static void
+store_if_load (GSimpleAsyncResult *async)
+{
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (async);
+	GPtrArray *paths;
+	StoreEntry *entry;
+	guint i;
+
+	closure->stage = STORE_COMPARING;
+	paths = g_ptr_array_new ();
+
+	for (i = 0; i < closure->n_entries; i++) {
+		entry = closure->entries + i;
+		entry->item_path = store_if_entry_find_item (entry, closure->collection_path);
+		if (entry->item_path == NULL)
+			continue;
+
+		/* Use the item and secret already loaded, if present */
+		entry->item = _secret_service_find_item_instance (closure->service, entry->item_path);
+		if (entry->item == NULL) {
+			secret_item_new_for_dbus_path (closure->service, entry->item_path,
+			                               SECRET_ITEM_NONE, closure->cancellable,
+			                               on_store_if_item, store_if_call_new (async, entry));
+			closure->pending++;
+		} else {
+			entry->current = secret_item_get_secret (entry->item);
+		}
+
+		if (entry->current == NULL)
+			g_ptr_array_add (paths, entry->item_path);
+	}
+
+	/* All secrets in one batch */
+	if (paths->len > 0) {
+		g_ptr_array_add (paths, NULL);
+		secret_service_get_secrets_for_dbus_paths (closure->service,
+		                                           (const gchar **)paths->pdata,
+		                                           closure->cancellable,
+		                                           on_store_if_secrets,
+		                                           g_object_ref (async));
+		closure->pending++;
+	}
+
+	g_ptr_array_free (paths, TRUE);
+}
+
+static void
+store_if_step (GSimpleAsyncResult *async)
+{
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (async);
+
+	while (closure->pending == 0 && closure->error == NULL &&
+	       closure->stage != STORE_DONE) {
+		switch (closure->stage) {
+		case STORE_SEARCHING:
+			store_if_load (async);
+			break;
+		case STORE_COMPARING:
+			store_if_compare (async);
+			break;
+		case STORE_WRITING_FIRST:
+			store_if_write_rest (async);
+			break;
+		default:
+			closure->stage = STORE_DONE;
+			break;
+		}
+	}
+
+	if (closure->pending > 0)
+		return;
+
+	_secret_service_count_stores (closure->service, closure->written, closure->skipped);
+
+	if (closure->error != NULL) {
+		g_simple_async_result_take_error (async, closure->error);
+		closure->error = NULL;
+	}
+
+	g_simple_async_result_complete (async);
+}
+
+static void
+on_store_if_alias (GObject *source,
+                   GAsyncResult *result,
+                   gpointer user_data)
 {
 	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
-	StoreClosure *store = g_simple_async_result_get_op_res_gpointer (async);
-	SecretService *service = SECRET_SERVICE (source);
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (async);
 	GError *error = NULL;
+	gchar *path;
 
-	secret_service_unlock_dbus_paths_finish (service, result, NULL, &error);
+	path = secret_service_read_alias_dbus_path_finish (closure->service, result, &error);
 	if (error == NULL) {
-		store->unlocked_collection = TRUE;
-		secret_service_create_item_dbus_path (service, store->collection_path,
-		                                      store->properties, store->value,
-		                                      SECRET_ITEM_CREATE_REPLACE, store->cancellable,
-		                                      on_store_create, g_object_ref (async));
+		g_free (closure->collection_path);
+		closure->collection_path = path;
+	} else if (closure->error == NULL) {
+		closure->error = error;
 	} else {
-		g_simple_async_result_take_error (async, error);
-		g_simple_async_result_complete (async);
+		g_error_free (error);
 	}
 
+	closure->pending--;
+	store_if_step (async);
 	g_object_unref (async);
 }
 
 static void
-on_store_create (GObject *source,
-                 GAsyncResult *result,
-                 gpointer user_data)
+on_store_if_searched (GObject *source,
+                      GAsyncResult *result,
+                      gpointer user_data)
 {
-	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
-	StoreClosure *store = g_simple_async_result_get_op_res_gpointer (async);
-	SecretService *service = SECRET_SERVICE (source);
+	StoreIfCall *call = user_data;
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (call->async);
 	GError *error = NULL;
-	GHashTable *properties;
 
-	_secret_service_create_item_dbus_path_finish_raw (result, &error);
+	secret_service_search_for_dbus_paths_finish (closure->service, result,
+	                                             &call->entry->unlocked,
+	                                             &call->entry->locked, &error);
+	if (error != NULL && closure->error == NULL)
+		closure->error = error;
+	else if (error != NULL)
+		g_error_free (error);
 
-	/*
-	 * This happens when the collection doesn't exist. If the collection is
-	 * the default alias, we should try and create it
-	 */
+	closure->pending--;
+	store_if_step (call->async);
+	store_if_call_free (call);
+}
 
-	if (!store->created_collection &&
-	    (g_error_matches (error, SECRET_ERROR, SECRET_ERROR_NO_SUCH_OBJECT) ||
-	     g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) &&
-	    g_strcmp0 (store->collection_path, SECRET_ALIAS_PREFIX "default") == 0) {
-		properties = _secret_collection_properties_new (_("Default keyring"));
-		secret_service_create_collection_dbus_path (service, properties, "default",
-		                                            SECRET_COLLECTION_CREATE_NONE, store->cancellable,
-		                                            on_store_keyring, g_object_ref (async));
-		g_hash_table_unref (properties);
-		g_error_free (error);
+static void
+store_if_search (GSimpleAsyncResult *async)
+{
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (async);
+	const gchar *alias;
+	StoreEntry *entry;
+	GVariant *attributes;
+	guint i;
 
-	} else if (!store->unlocked_collection &&
-	           g_error_matches (error, SECRET_ERROR, SECRET_ERROR_IS_LOCKED)) {
-		const gchar *paths[2] = { store->collection_path, NULL };
-		secret_service_unlock_dbus_paths (service, paths, store->cancellable,
-		                                  on_store_unlock, g_object_ref (async));
-		g_error_free (error);
-	} else {
-		if (error != NULL)
-			g_simple_async_result_take_error (async, error);
-		g_simple_async_result_complete (async);
+	/* The alias lookup and all the searches are sent at once */
+	if (g_str_has_prefix (closure->collection_path, SECRET_ALIAS_PREFIX)) {
+		alias = closure->collection_path + strlen (SECRET_ALIAS_PREFIX);
+		secret_service_read_alias_dbus_path (closure->service, alias, closure->cancellable,
+		                                     on_store_if_alias, g_object_ref (async));
+		closure->pending++;
 	}
 
-	g_object_unref (async);
+	for (i = 0; i < closure->n_entries; i++) {
+		entry = closure->entries + i;
+		attributes = _secret_attribute_set_to_variant (entry->attributes);
+		_secret_service_search_for_paths_variant (closure->service, attributes,
+		                                          closure->cancellable, on_store_if_searched,
+		                                          store_if_call_new (async, entry));
+		g_variant_unref (attributes);
+		closure->pending++;
+	}
+
+	/* Nothing to do */
+	if (closure->pending == 0)
+		g_simple_async_result_complete_in_idle (async);
 }
 
 static void
-on_store_service (GObject *source,
-                  GAsyncResult *result,
-                  gpointer user_data)
+on_store_if_service (GObject *source,
+                     GAsyncResult *result,
+                     gpointer user_data)
 {
 	GSimpleAsyncResult *async = G_SIMPLE_ASYNC_RESULT (user_data);
-	StoreClosure *store = g_simple_async_result_get_op_res_gpointer (async);
-	SecretService *service;
+	StoreIfClosure *closure = g_simple_async_result_get_op_res_gpointer (async);
 	GError *error = NULL;
 
-	service = secret_service_get_finish (result, &error);
+	closure->service = secret_service_get_finish (result, &error);
 	if (error == NULL) {
-		secret_service_create_item_dbus_path (service, store->collection_path,
-		                                      store->properties, store->value,
-		                                      SECRET_ITEM_CREATE_REPLACE, store->cancellable,
-		                                      on_store_create, g_object_ref (async));
-		g_object_unref (service);
+		store_if_search (async);
 
 	} else {
 		g_simple_async_result_take_error (async, error);
@@ -1100,8 +2464,57 @@ on_store_service (GObject *source,
 	g_object_unref (async);
 }
 
+static void
+store_if_changed_async (SecretService *service,
+                        const SecretSchema *schema,
+                        const gchar *collection,
+                        GHashTable **attributes,
+                        const gchar **labels,
+                        SecretValue **values,
+                        guint n_items,
+                        GCancellable *cancellable,
+                        GAsyncReadyCallback callback,
+                        gpointer user_data,
+                        gpointer source_tag)
+{
+	GSimpleAsyncResult *async;
+	StoreIfClosure *closure;
+	const gchar *schema_name;
+	guint i;
+
+	schema_name = (schema == NULL) ? NULL : schema->name;
+
+	async = g_simple_async_result_new (G_OBJECT (service), callback, user_data, source_tag);
+	closure = g_slice_new0 (StoreIfClosure);
+	closure->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	closure->collection = g_strdup (collection);
+	closure->collection_path = _secret_util_collection_to_path (collection);
+	closure->entries = g_new0 (StoreEntry, n_items);
+	closure->n_entries = n_items;
+	closure->stage = STORE_SEARCHING;
+
+	for (i = 0; i < n_items; i++) {
+		/* Always store the schema name in the attributes, as secret_service_store() */
+		closure->entries[i].attributes = _secret_attribute_set_new (attributes[i], schema_name);
+		closure->entries[i].label = g_strdup (labels[i]);
+		closure->entries[i].value = secret_value_ref (values[i]);
+	}
+
+	g_simple_async_result_set_op_res_gpointer (async, closure, store_if_closure_free);
+
+	if (service == NULL) {
+		secret_service_get (SECRET_SERVICE_OPEN_SESSION, cancellable,
+		                    on_store_if_service, g_object_ref (async));
+	} else {
+		closure->service = g_object_ref (service);
+		store_if_search (async);
+	}
+
+	g_object_unref (async);
+}
+
 /**
- * secret_service_store:
+ * secret_service_store_if_changed:
  * @service: (allow-none): the secret service
  * @schema: (allow-none): the schema to use to check attributes
  * @attributes: (element-type utf8 utf8): the attribute keys and values
@@ -1112,38 +2525,33 @@ on_store_service (GObject *source,
  * @callback: called when the operation completes
  * @user_data: data to be passed to the callback
  *
- * Store a secret value in the secret service.
- *
- * The @attributes should be a set of key and value string pairs.
+ * Store a secret value in the secret service, unless it is already stored.
  *
- * If the attributes match a secret item already stored in the collection, then
- * the item will be updated with these new values.
+ * This is like secret_service_store(), but if an item matching the
+ * @attributes already exists in the collection with the same label, attributes
+ * and secret, then nothing is written. This avoids having the secret service
+ * rewrite its storage for each unchanged item.
  *
- * If @service is NULL, then secret_service_get() will be called to get
- * the default #SecretService proxy.
+ * Items and secrets already loaded by the #SecretService are used for the
+ * comparison. Otherwise the secret is retrieved from the secret service.
+ * Locked items are always written.
  *
- * If @collection is not specified, then the default collection will be
- * used. Use #SECRET_COLLECTION_SESSION to store the password in the session
- * collection, which doesn't get stored across login sessions.
+ * Use secret_service_get_store_counts() to find out how many writes were
+ * skipped.
  *
  * This method will return immediately and complete asynchronously.
  */
 void
-secret_service_store (SecretService *service,
-                      const SecretSchema *schema,
-                      GHashTable *attributes,
-                      const gchar *collection,
-                      const gchar *label,
-                      SecretValue *value,
-                      GCancellable *cancellable,
-                      GAsyncReadyCallback callback,
-                      gpointer user_data)
+secret_service_store_if_changed (SecretService *service,
+                                 const SecretSchema *schema,
+                                 GHashTable *attributes,
+                                 const gchar *collection,
+                                 const gchar *label,
+                                 SecretValue *value,
+                                 GCancellable *cancellable,
+                                 GAsyncReadyCallback callback,
+                                 gpointer user_data)
 {
-	GSimpleAsyncResult *async;
-	StoreClosure *store;
-	const gchar *schema_name;
-	GVariant *propval;
-
 	g_return_if_fail (service == NULL || SECRET_IS_SERVICE (service));
 	g_return_if_fail (attributes != NULL);
 	g_return_if_fail (label != NULL);
@@ -1154,93 +2562,61 @@ secret_service_store (SecretService *service,
 	if (schema != NULL && !_secret_attributes_validate (schema, attributes, G_STRFUNC, FALSE))
 		return;
 
-	async = g_simple_async_result_new  (G_OBJECT (service), callback, user_data,
-	                                    secret_service_store);
-	store = g_slice_new0 (StoreClosure);
-	store->collection_path = _secret_util_collection_to_path (collection);
-	store->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
-	store->value = secret_value_ref (value);
-	store->properties = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
-	                                           (GDestroyNotify)g_variant_unref);
-
-	propval = g_variant_new_string (label);
-	g_hash_table_insert (store->properties,
-	                     SECRET_ITEM_INTERFACE ".Label",
-	                     g_variant_ref_sink (propval));
-
-	/* Always store the schema name in the attributes */
-	schema_name = (schema == NULL) ? NULL : schema->name;
-	propval = _secret_attributes_to_variant (attributes, schema_name);
-	g_hash_table_insert (store->properties,
-	                     SECRET_ITEM_INTERFACE ".Attributes",
-	                     g_variant_ref_sink (propval));
-
-	g_simple_async_result_set_op_res_gpointer (async, store, store_closure_free);
-
-	if (service == NULL) {
-		secret_service_get (SECRET_SERVICE_OPEN_SESSION, cancellable,
-		                    on_store_service, g_object_ref (async));
-
-	} else {
-		secret_service_create_item_dbus_path (service, store->collection_path,
-		                                      store->properties, store->value,
-		                                      SECRET_ITEM_CREATE_REPLACE, store->cancellable,
-		                                      on_store_create, g_object_ref (async));
-	}
-
-	g_object_unref (async);
+	store_if_changed_async (service, schema, collection, &attributes, &label, &value, 1,
+	                        cancellable, callback, user_data, secret_service_store_if_changed);
 }
 
 /**
- * secret_service_store_finish:
+ * secret_service_store_if_changed_finish:
  * @service: (allow-none): the secret service
  * @result: the asynchronous result passed to the callback
+ * @written: (out) (allow-none): location to place whether the item was written
  * @error: location to place an error on failure
  *
- * Finish asynchronous operation to store a secret value in the secret service.
+ * Finish asynchronous operation to store a secret value in the secret service,
+ * unless it was already stored.
  *
  * Returns: whether the storage was successful or not
  */
 gboolean
-secret_service_store_finish (SecretService *service,
-                             GAsyncResult *result,
-                             GError **error)
+secret_service_store_if_changed_finish (SecretService *service,
+                                        GAsyncResult *result,
+                                        gboolean *written,
+                                        GError **error)
 {
+	StoreIfClosure *closure;
+
 	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), FALSE);
 	g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (service),
-	                                                      secret_service_store), FALSE);
+	                                                      secret_service_store_if_changed), FALSE);
 	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
 	if (_secret_util_propagate_error (G_SIMPLE_ASYNC_RESULT (result), error))
 		return FALSE;
 
+	closure = g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (result));
+	if (written)
+		*written = closure->written > 0;
 	return TRUE;
 }
 
 /**
- * secret_service_store_sync:
+ * secret_service_store_if_changed_sync:
  * @service: (allow-none): the secret service
  * @schema: (allow-none): the schema for the attributes
  * @attributes: (element-type utf8 utf8): the attribute keys and values
  * @collection: (allow-none): a collection alias, or D-Bus object path of the collection where to store the secret
  * @label: label for the secret
  * @value: the secret value
+ * @written: (out) (allow-none): location to place whether the item was written
  * @cancellable: optional cancellation object
  * @error: location to place an error on failure
  *
- * Store a secret value in the secret service.
- *
- * The @attributes should be a set of key and value string pairs.
- *
- * If the attributes match a secret item already stored in the collection, then
- * the item will be updated with these new values.
- *
- * If @collection is %NULL, then the default collection will be
- * used. Use #SECRET_COLLECTION_SESSION to store the password in the session
- * collection, which doesn't get stored across login sessions.
+ * Store a secret value in the secret service, unless it is already stored.
  *
- * If @service is NULL, then secret_service_get_sync() will be called to get
- * the default #SecretService proxy.
+ * This is like secret_service_store_sync(), but if an item matching the
+ * @attributes already exists in the collection with the same label, attributes
+ * and secret, then nothing is written. See secret_service_store_if_changed().
  *
  * This method may block indefinitely and should not be used in user interface
  * threads.
@@ -1248,14 +2624,15 @@ secret_service_store_finish (SecretService *service,
  * Returns: whether the storage was successful or not
  */
 gboolean
-secret_service_store_sync (SecretService *service,
-                           const SecretSchema *schema,
-                           GHashTable *attributes,
-                           const gchar *collection,
-                           const gchar *label,
-                           SecretValue *value,
-                           GCancellable *cancellable,
-                           GError **error)
+secret_service_store_if_changed_sync (SecretService *service,
+                                      const SecretSchema *schema,
+                                      GHashTable *attributes,
+                                      const gchar *collection,
+                                      const gchar *label,
+                                      SecretValue *value,
+                                      gboolean *written,
+                                      GCancellable *cancellable,
+                                      GError **error)
 {
 	SecretSync *sync;
 	gboolean ret;
@@ -1274,12 +2651,174 @@ secret_service_store_sync (SecretService *service,
 	sync = _secret_sync_new ();
 	g_main_context_push_thread_default (sync->context);
 
-	secret_service_store (service, schema, attributes, collection,
-	                      label, value, cancellable, _secret_sync_on_result, sync);
+	secret_service_store_if_changed (service, schema, attributes, collection, label, value,
+	                                 cancellable, _secret_sync_on_result, sync);
 
 	g_main_loop_run (sync->loop);
 
-	ret = secret_service_store_finish (service, sync->result, error);
+	ret = secret_service_store_if_changed_finish (service, sync->result, written, error);
+
+	g_main_context_pop_thread_default (sync->context);
+	_secret_sync_free (sync);
+
+	return ret;
+}
+
+/**
+ * secret_service_store_all_if_changed:
+ * @service: (allow-none): the secret service
+ * @schema: (allow-none): the schema to use to check attributes
+ * @collection: (allow-none): a collection alias, or D-Bus object path of the collection where to store the secrets
+ * @attributes: (array length=n_items): the attributes for each item
+ * @labels: (array length=n_items): the label for each item
+ * @values: (array length=n_items): the secret value for each item
+ * @n_items: the number of items to store
+ * @cancellable: optional cancellation object
+ * @callback: called when the operation completes
+ * @user_data: data to be passed to the callback
+ *
+ * Store many secret values in the secret service, skipping those which
+ * are already stored. See secret_service_store_if_changed().
+ *
+ * The searches for all the items are sent at once, and the secrets that
+ * need comparing are retrieved together. Items that changed are then
+ * written in parallel, after the first one.
+ *
+ * This method will return immediately and complete asynchronously.
+ */
+void
+secret_service_store_all_if_changed (SecretService *service,
+                                     const SecretSchema *schema,
+                                     const gchar *collection,
+                                     GHashTable **attributes,
+                                     const gchar **labels,
+                                     SecretValue **values,
+                                     guint n_items,
+                                     GCancellable *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data)
+{
+	guint i;
+
+	g_return_if_fail (service == NULL || SECRET_IS_SERVICE (service));
+	g_return_if_fail (attributes != NULL || n_items == 0);
+	g_return_if_fail (labels != NULL || n_items == 0);
+	g_return_if_fail (values != NULL || n_items == 0);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+	for (i = 0; i < n_items; i++) {
+		g_return_if_fail (attributes[i] != NULL);
+		g_return_if_fail (labels[i] != NULL);
+		g_return_if_fail (values[i] != NULL);
+
+		/* Warnings raised already */
+		if (schema != NULL && !_secret_attributes_validate (schema, attributes[i], G_STRFUNC, FALSE))
+			return;
+	}
+
+	store_if_changed_async (service, schema, collection, attributes, labels, values, n_items,
+	                        cancellable, callback, user_data, secret_service_store_all_if_changed);
+}
+
+/**
+ * secret_service_store_all_if_changed_finish:
+ * @service: (allow-none): the secret service
+ * @result: the asynchronous result passed to the callback
+ * @written: (out) (allow-none): location to place the number of items written
+ * @error: location to place an error on failure
+ *
+ * Finish asynchronous operation to store many secret values in the secret
+ * service.
+ *
+ * Returns: whether the storage of all the items was successful or not
+ */
+gboolean
+secret_service_store_all_if_changed_finish (SecretService *service,
+                                            GAsyncResult *result,
+                                            guint *written,
+                                            GError **error)
+{
+	StoreIfClosure *closure;
+
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), FALSE);
+	g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (service),
+	                                                      secret_service_store_all_if_changed), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	closure = g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (result));
+	if (written)
+		*written = closure->written;
+
+	if (_secret_util_propagate_error (G_SIMPLE_ASYNC_RESULT (result), error))
+		return FALSE;
+
+	return TRUE;
+}
+
+/**
+ * secret_service_store_all_if_changed_sync:
+ * @service: (allow-none): the secret service
+ * @schema: (allow-none): the schema to use to check attributes
+ * @collection: (allow-none): a collection alias, or D-Bus object path of the collection where to store the secrets
+ * @attributes: (array length=n_items): the attributes for each item
+ * @labels: (array length=n_items): the label for each item
+ * @values: (array length=n_items): the secret value for each item
+ * @n_items: the number of items to store
+ * @written: (out) (allow-none): location to place the number of items written
+ * @cancellable: optional cancellation object
+ * @error: location to place an error on failure
+ *
+ * Store many secret values in the secret service, skipping those which
+ * are already stored. See secret_service_store_all_if_changed().
+ *
+ * This method may block indefinitely and should not be used in user interface
+ * threads.
+ *
+ * Returns: whether the storage of all the items was successful or not
+ */
+gboolean
+secret_service_store_all_if_changed_sync (SecretService *service,
+                                          const SecretSchema *schema,
+                                          const gchar *collection,
+                                          GHashTable **attributes,
+                                          const gchar **labels,
+                                          SecretValue **values,
+                                          guint n_items,
+                                          guint *written,
+                                          GCancellable *cancellable,
+                                          GError **error)
+{
+	SecretSync *sync;
+	gboolean ret;
+	guint i;
+
+	g_return_val_if_fail (service == NULL || SECRET_IS_SERVICE (service), FALSE);
+	g_return_val_if_fail (attributes != NULL || n_items == 0, FALSE);
+	g_return_val_if_fail (labels != NULL || n_items == 0, FALSE);
+	g_return_val_if_fail (values != NULL || n_items == 0, FALSE);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	for (i = 0; i < n_items; i++) {
+		g_return_val_if_fail (attributes[i] != NULL, FALSE);
+		g_return_val_if_fail (labels[i] != NULL, FALSE);
+		g_return_val_if_fail (values[i] != NULL, FALSE);
+
+		/* Warnings raised already */
+		if (schema != NULL && !_secret_attributes_validate (schema, attributes[i], G_STRFUNC, FALSE))
+			return FALSE;
+	}
+
+	sync = _secret_sync_new ();
+	g_main_context_push_thread_default (sync->context);
+
+	secret_service_store_all_if_changed (service, schema, collection, attributes, labels,
+	                                     values, n_items, cancellable,
+	                                     _secret_sync_on_result, sync);
+
+	g_main_loop_run (sync->loop);
+
+	ret = secret_service_store_all_if_changed_finish (service, sync->result, written, error);
 
 	g_main_context_pop_thread_default (sync->context);
 	_secret_sync_free (sync);
@@ -1361,11 +2900,15 @@ on_lookup_searched (GObject *source,
 	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
 	LookupClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
 	SecretService *self = SECRET_SERVICE (source);
+	const gchar **unlocked = NULL;
+	const gchar **locked = NULL;
 	GError *error = NULL;
-	gchar **unlocked = NULL;
-	gchar **locked = NULL;
+	GVariant *paths;
+
+	paths = _secret_service_search_for_paths_variant_finish (self, result, &error);
+	if (paths != NULL)
+		g_variant_get (paths, "(^a&o^a&o)", &unlocked, &locked);
 
-	secret_service_search_for_dbus_paths_finish (self, result, &unlocked, &locked, &error);
 	if (error != NULL) {
 		g_simple_async_result_take_error (res, error);
 		g_simple_async_result_complete (res);
@@ -1377,8 +2920,8 @@ on_lookup_searched (GObject *source,
 		                                         g_object_ref (res));
 
 	} else if (locked && locked[0]) {
-		const gchar *paths[] = { locked[0], NULL };
-		secret_service_unlock_dbus_paths (self, paths,
+		const gchar *unlock[] = { locked[0], NULL };
+		secret_service_unlock_dbus_paths (self, unlock,
 		                                  closure->cancellable,
 		                                  on_lookup_unlocked,
 		                                  g_object_ref (res));
@@ -1387,8 +2930,10 @@ on_lookup_searched (GObject *source,
 		g_simple_async_result_complete (res);
 	}
 
-	g_strfreev (unlocked);
-	g_strfreev (locked);
+	g_free (unlocked);
+	g_free (locked);
+	if (paths != NULL)
+		g_variant_unref (paths);
 	g_object_unref (res);
 }
 
@@ -1620,12 +3165,14 @@ on_delete_searched (GObject *source,
 {
 	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
 	DeleteClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	const gchar **unlocked = NULL;
 	GError *error = NULL;
-	gchar **unlocked = NULL;
+	GVariant *paths;
 	gint i;
 
-	secret_service_search_for_dbus_paths_finish (SECRET_SERVICE (source), result, &unlocked, NULL, &error);
+	paths = _secret_service_search_for_paths_variant_finish (SECRET_SERVICE (source), result, &error);
 	if (error == NULL) {
+		g_variant_get (paths, "(^a&o@ao)", &unlocked, NULL);
 		for (i = 0; unlocked[i] != NULL; i++) {
 			_secret_service_delete_path (closure->service, unlocked[i], TRUE,
 			                             closure->cancellable,
@@ -1641,7 +3188,9 @@ on_delete_searched (GObject *source,
 		g_simple_async_result_complete (res);
 	}
 
-	g_strfreev (unlocked);
+	g_free (unlocked);
+	if (paths != NULL)
+		g_variant_unref (paths);
 	g_object_unref (res);
 }
 
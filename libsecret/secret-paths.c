@@ -522,6 +522,24 @@ _secret_service_search_for_paths_variant (SecretService *self,
 	g_object_unref (res);
 }
 
+GVariant *
+_secret_service_search_for_paths_variant_finish (SecretService *self,
+                                                 GAsyncResult *result,
+                                                 GError **error)
+{
+	GSimpleAsyncResult *res;
+
+	g_return_val_if_fail (g_simple_async_result_is_valid (result, G_OBJECT (self),
+	                      secret_service_search_for_dbus_paths), NULL);
+	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+	res = G_SIMPLE_ASYNC_RESULT (result);
+	if (_secret_util_propagate_error (res, error))
+		return NULL;
+
+	return g_variant_ref (g_simple_async_result_get_op_res_gpointer (res));
+}
+
 /**
  * secret_service_search_for_dbus_paths_finish:
  * @self: the secret service
@@ -634,10 +652,9 @@ secret_service_search_for_dbus_paths_sync (SecretService *self,
 	if (schema != NULL && !(schema->flags & SECRET_SCHEMA_DONT_MATCH_NAME))
 		schema_name = schema->name;
 
-	response = g_dbus_proxy_call_sync (G_DBUS_PROXY (self), "SearchItems",
-	                                   g_variant_new ("(@a{ss})",
-	                                                  _secret_attributes_to_variant (attributes, schema_name)),
-	                                   G_DBUS_CALL_FLAGS_NONE, -1, cancellable, error);
+	response = _secret_service_search_for_paths_variant_sync (self,
+	                                                          _secret_attributes_to_variant (attributes, schema_name),
+	                                                          cancellable, error);
 
 	if (response != NULL) {
 		if (unlocked || locked) {
@@ -984,10 +1001,26 @@ secret_service_get_secrets_for_dbus_paths_sync (SecretService *self,
 }
 
 
+GVariant *
+_secret_service_search_for_paths_variant_sync (SecretService *self,
+                                               GVariant *attributes,
+                                               GCancellable *cancellable,
+                                               GError **error)
+{
+	g_return_val_if_fail (SECRET_IS_SERVICE (self), NULL);
+	g_return_val_if_fail (attributes != NULL, NULL);
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), NULL);
+
+	return g_dbus_proxy_call_sync (G_DBUS_PROXY (self), "SearchItems",
+	                               g_variant_new ("(@a{ss})", attributes),
+	                               G_DBUS_CALL_FLAGS_NONE, -1, cancellable, error);
+}
+
 typedef struct {
 	GCancellable *cancellable;
 	SecretPrompt *prompt;
 	GPtrArray *xlocked;
+	gboolean locking;
 } XlockClosure;
 
 static void
@@ -1001,6 +1034,17 @@ xlock_closure_free (gpointer data)
 	g_slice_free (XlockClosure, closure);
 }
 
+static void
+xlock_closure_remember (SecretService *self,
+                        XlockClosure *closure)
+{
+	guint i;
+
+	for (i = 0; i < closure->xlocked->len; i++)
+		_secret_service_remember_locked (self, closure->xlocked->pdata[i],
+		                                 closure->locking);
+}
+
 static void
 on_xlock_prompted (GObject *source,
                    GAsyncResult *result,
@@ -1025,6 +1069,7 @@ on_xlock_prompted (GObject *source,
 		g_variant_unref (retval);
 	}
 
+	xlock_closure_remember (self, closure);
 	g_simple_async_result_complete (res);
 	g_object_unref (res);
 }
@@ -1054,6 +1099,7 @@ on_xlock_called (GObject *source,
 		if (_secret_util_empty_path (prompt)) {
 			for (i = 0; xlocked[i]; i++)
 				g_ptr_array_add (closure->xlocked, g_strdup (xlocked[i]));
+			xlock_closure_remember (self, closure);
 			g_simple_async_result_complete (res);
 
 		} else {
@@ -1086,6 +1132,7 @@ _secret_service_xlock_paths_async (SecretService *self,
 	closure = g_slice_new0 (XlockClosure);
 	closure->cancellable = cancellable ? g_object_ref (cancellable) : cancellable;
 	closure->xlocked = g_ptr_array_new_with_free_func (g_free);
+	closure->locking = g_str_equal (method, "Lock");
 	g_simple_async_result_set_op_res_gpointer (res, closure, xlock_closure_free);
 
 	g_dbus_proxy_call (G_DBUS_PROXY (self), method,
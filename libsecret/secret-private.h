@@ -31,6 +31,8 @@ typedef struct {
 
 typedef struct _SecretSession SecretSession;
 
+typedef struct _SecretAttributeSet SecretAttributeSet;
+
 #define              SECRET_ALIAS_PREFIX                      "/org/freedesktop/secrets/aliases/"
 
 #define              SECRET_SERVICE_PATH                      "/org/freedesktop/secrets"
@@ -86,6 +88,32 @@ GHashTable *         _secret_attributes_for_variant           (GVariant *variant
 
 GHashTable *         _secret_attributes_copy                  (GHashTable *attributes);
 
+SecretAttributeSet * _secret_attribute_set_new                (GHashTable *attributes,
+                                                               const gchar *schema_name);
+
+SecretAttributeSet * _secret_attribute_set_new_for_variant    (GVariant *variant);
+
+SecretAttributeSet * _secret_attribute_set_ref                (SecretAttributeSet *set);
+
+void                 _secret_attribute_set_unref              (gpointer data);
+
+guint                _secret_attribute_set_size               (SecretAttributeSet *set);
+
+const gchar *        _secret_attribute_set_lookup             (SecretAttributeSet *set,
+                                                               const gchar *name);
+
+GVariant *           _secret_attribute_set_to_variant         (SecretAttributeSet *set);
+
+GHashTable *         _secret_attribute_set_to_table           (SecretAttributeSet *set);
+
+gboolean             _secret_attribute_set_subset             (SecretAttributeSet *set,
+                                                               SecretAttributeSet *other);
+
+gboolean             _secret_attribute_set_equal              (SecretAttributeSet *set,
+                                                               SecretAttributeSet *other);
+
+guint                _secret_attribute_set_hash               (SecretAttributeSet *set);
+
 gboolean             _secret_attributes_validate              (const SecretSchema *schema,
                                                                GHashTable *attributes,
                                                                const gchar *pretty_function,
@@ -117,6 +145,10 @@ gboolean             _secret_util_set_property_finish         (GDBusProxy *proxy
                                                                GAsyncResult *result,
                                                                GError **error);
 
+gboolean             _secret_util_get_properties_sync         (GDBusProxy *proxy,
+                                                               GCancellable *cancellable,
+                                                               GError **error);
+
 gboolean             _secret_util_set_property_sync           (GDBusProxy *proxy,
                                                                const gchar *property,
                                                                GVariant *value,
@@ -125,6 +157,8 @@ gboolean             _secret_util_set_property_sync           (GDBusProxy *proxy
 
 gboolean             _secret_util_have_cached_properties      (GDBusProxy *proxy);
 
+SecretService *      _secret_service_get_instance             (void);
+
 SecretSession *      _secret_service_get_session              (SecretService *self);
 
 void                 _secret_service_take_session             (SecretService *self,
@@ -147,12 +181,33 @@ void                 _secret_service_search_for_paths_variant (SecretService *se
                                                                GAsyncReadyCallback callback,
                                                                gpointer user_data);
 
+GVariant *           _secret_service_search_for_paths_variant_finish (SecretService *self,
+                                                                      GAsyncResult *result,
+                                                                      GError **error);
+
+GVariant *           _secret_service_search_for_paths_variant_sync (SecretService *self,
+                                                                    GVariant *attributes,
+                                                                    GCancellable *cancellable,
+                                                                    GError **error);
+
+void                 _secret_service_unlock_load_items_sync   (SecretService *service,
+                                                               GList *items,
+                                                               SecretSearchFlags flags,
+                                                               GCancellable *cancellable);
+
 SecretItem *         _secret_service_find_item_instance       (SecretService *self,
                                                                const gchar *item_path);
 
 SecretCollection *   _secret_service_find_collection_instance (SecretService *self,
                                                                const gchar *collection_path);
 
+void                 _secret_service_remember_locked          (SecretService *self,
+                                                               const gchar *object_path,
+                                                               gboolean locked);
+
+gboolean             _secret_service_known_locked             (SecretService *self,
+                                                               const gchar *object_path);
+
 SecretValue *        _secret_service_decode_get_secrets_first (SecretService *self,
                                                                GVariant *out);
 
@@ -171,6 +226,10 @@ gint                 _secret_service_xlock_paths_finish       (SecretService *se
                                                                gchar ***xlocked,
                                                                GError **error);
 
+void                 _secret_service_count_stores             (SecretService *self,
+                                                               guint written,
+                                                               guint skipped);
+
 void                 _secret_service_create_item_dbus_path_finish_raw  (GAsyncResult *result,
                                                                         GError **error);
 
@@ -183,6 +242,9 @@ gchar *              _secret_value_unref_to_password          (SecretValue *valu
 
 gchar *              _secret_value_unref_to_string            (SecretValue *value);
 
+gboolean             _secret_value_equal                      (SecretValue *value,
+                                                               SecretValue *other);
+
 void                 _secret_session_free                     (gpointer data);
 
 const gchar *        _secret_session_get_algorithms           (SecretSession *session);
@@ -206,6 +268,13 @@ SecretValue *        _secret_session_decode_secret            (SecretSession *se
 void                 _secret_item_set_cached_secret           (SecretItem *self,
                                                                SecretValue *value);
 
+gboolean             _secret_item_new_for_dbus_paths_sync     (SecretService *service,
+                                                               const gchar **paths,
+                                                               guint n_paths,
+                                                               SecretItem **items,
+                                                               GCancellable *cancellable,
+                                                               GError **error);
+
 const SecretSchema * _secret_schema_ref_if_nonstatic          (const SecretSchema *schema);
 
 void                 _secret_schema_unref_if_nonstatic        (const SecretSchema *schema);
@@ -27,6 +27,12 @@
 
 #include "egg/egg-secure-memory.h"
 
+#include <glib/gi18n-lib.h>
+
+#ifdef HAVE_PTHREAD_ATFORK
+#include <pthread.h>
+#endif
+
 /**
  * SECTION:secret-service
  * @title: SecretService
@@ -66,6 +72,13 @@
  * In order to customize prompt handling, override the <literal>prompt_async</literal>
  * and <literal>prompt_finish</literal> virtual methods of the #SecretService class.
  *
+ * A forked child process forgets the #SecretService returned by
+ * secret_service_get() in its parent. Since D-Bus connections can not be used
+ * in a process forked after connecting, a child of a process that has
+ * connected to the Secret Service fails to get or open a #SecretService with
+ * a %G_IO_ERROR_NOT_SUPPORTED error, rather than blocking. A prefork server
+ * should connect in each child, after forking.
+ *
  * These functions have an unstable API and may change across versions. Use
  * <literal>libsecret-unstable</literal> package to access them.
  *
@@ -99,6 +112,15 @@
  *                               while initializing the #SecretService
  * @SECRET_SERVICE_LOAD_COLLECTIONS: load collections while initializing the
  *                                   #SecretService
+ * @SECRET_SERVICE_DEFER_ITEMS: when loading collections, don't load their items.
+ *                              Use secret_collection_load_items() on the
+ *                              collections whose items are needed. The items
+ *                              of the shared proxy are loaded anyway once
+ *                              secret_service_get() is called without this flag.
+ * @SECRET_SERVICE_PRIVATE_CONNECTION: open a separate connection to the session
+ *                                     bus for this #SecretService, rather than
+ *                                     sharing the connection of the application.
+ *                                     Only used when the proxy is created.
  *
  * Flags which determine which parts of the #SecretService proxy are initialized
  * during a secret_service_get() or secret_service_open() operation.
@@ -123,11 +145,22 @@ struct _SecretServicePrivate {
 	GMutex mutex;
 	gpointer session;
 	GHashTable *collections;
+	GHashTable *locked_paths;
+
+	/* Only touched in the main thread */
+	guint lock_watch;
+
+	/* Atomic */
+	gint defer_items;
+	gint stores_written;
+	gint stores_skipped;
 };
 
 G_LOCK_DEFINE (service_instance);
 static gpointer service_instance = NULL;
 static guint service_watch = 0;
+static gboolean service_connected = FALSE;
+static gboolean service_forked = FALSE;
 
 static GInitableIface *secret_service_initable_parent_iface = NULL;
 
@@ -155,6 +188,13 @@ service_get_instance (void)
 	return instance;
 }
 
+SecretService *
+_secret_service_get_instance (void)
+{
+	/* The default instance, if already resolved, without touching the bus */
+	return service_get_instance ();
+}
+
 static gboolean
 service_uncache_instance (SecretService *which)
 {
@@ -220,6 +260,37 @@ service_cache_instance (SecretService *instance)
 		g_bus_unwatch_name (watch);
 }
 
+#ifdef HAVE_PTHREAD_ATFORK
+
+static void
+on_fork_prepare (void)
+{
+	G_LOCK (service_instance);
+}
+
+static void
+on_fork_parent (void)
+{
+	G_UNLOCK (service_instance);
+}
+
+static void
+on_fork_child (void)
+{
+	/*
+	 * The cached instance and its name watch belong to the parent's bus
+	 * connection, whose worker thread doesn't exist in the child. They can't
+	 * be safely released here, so they're forgotten. See service_check_connect().
+	 */
+	service_instance = NULL;
+	service_watch = 0;
+	service_forked = service_connected;
+
+	G_UNLOCK (service_instance);
+}
+
+#endif /* HAVE_PTHREAD_ATFORK */
+
 static void
 secret_service_init (SecretService *self)
 {
@@ -262,6 +333,7 @@ secret_service_set_property (GObject *obj,
 	switch (prop_id) {
 	case PROP_FLAGS:
 		self->pv->init_flags = g_value_get_flags (value);
+		self->pv->defer_items = (self->pv->init_flags & SECRET_SERVICE_DEFER_ITEMS) ? 1 : 0;
 		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
@@ -276,6 +348,12 @@ secret_service_dispose (GObject *obj)
 
 	g_cancellable_cancel (self->pv->cancellable);
 
+	if (self->pv->lock_watch) {
+		g_dbus_connection_signal_unsubscribe (g_dbus_proxy_get_connection (G_DBUS_PROXY (self)),
+		                                      self->pv->lock_watch);
+		self->pv->lock_watch = 0;
+	}
+
 	G_OBJECT_CLASS (secret_service_parent_class)->dispose (obj);
 }
 
@@ -287,6 +365,8 @@ secret_service_finalize (GObject *obj)
 	_secret_session_free (self->pv->session);
 	if (self->pv->collections)
 		g_hash_table_destroy (self->pv->collections);
+	if (self->pv->locked_paths)
+		g_hash_table_destroy (self->pv->locked_paths);
 	g_clear_object (&self->pv->cancellable);
 	g_mutex_clear (&self->pv->mutex);
 
@@ -559,6 +639,71 @@ secret_service_class_init (SecretServiceClass *klass)
 
 	/* Initialize this error domain, registers dbus errors */
 	_secret_error_quark = secret_error_get_quark ();
+
+#ifdef HAVE_PTHREAD_ATFORK
+	pthread_atfork (on_fork_prepare, on_fork_parent, on_fork_child);
+#endif
+}
+
+static void
+on_collection_lock_changed (GDBusConnection *connection,
+                            const gchar *sender_name,
+                            const gchar *object_path,
+                            const gchar *interface_name,
+                            const gchar *signal_name,
+                            GVariant *parameters,
+                            gpointer user_data)
+{
+	SecretService *self;
+	GVariant *changed;
+	gboolean locked;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)")))
+		return;
+
+	self = g_weak_ref_get (user_data);
+	if (self == NULL)
+		return;
+
+	g_variant_get (parameters, "(&s@a{sv}@as)", NULL, &changed, NULL);
+	if (g_variant_lookup (changed, "Locked", "b", &locked))
+		_secret_service_remember_locked (self, object_path, locked);
+
+	g_variant_unref (changed);
+	g_object_unref (self);
+}
+
+static void
+free_weak_ref (gpointer data)
+{
+	GWeakRef *ref = data;
+	g_weak_ref_clear (ref);
+	g_slice_free (GWeakRef, ref);
+}
+
+static void
+service_watch_lock_state (SecretService *self)
+{
+	GDBusProxy *proxy = G_DBUS_PROXY (self);
+	GWeakRef *ref;
+
+	/*
+	 * One match rule for all collections, whether or not we have proxies
+	 * for them, so that we know which collections are locked without
+	 * having to ask.
+	 */
+
+	ref = g_slice_new0 (GWeakRef);
+	g_weak_ref_init (ref, self);
+
+	self->pv->lock_watch = g_dbus_connection_signal_subscribe (g_dbus_proxy_get_connection (proxy),
+	                                                           g_dbus_proxy_get_name (proxy),
+	                                                           SECRET_PROPERTIES_INTERFACE,
+	                                                           "PropertiesChanged", NULL,
+	                                                           SECRET_COLLECTION_INTERFACE,
+	                                                           G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                           on_collection_lock_changed,
+	                                                           ref, free_weak_ref);
 }
 
 typedef struct {
@@ -574,12 +719,23 @@ init_closure_free (gpointer data)
 	g_slice_free (InitClosure, closure);
 }
 
+static void
+service_update_defer_items (SecretService *self,
+                            SecretServiceFlags flags)
+{
+	/* Once any caller wants items, they're loaded for the shared proxy too */
+	if ((flags & SECRET_SERVICE_LOAD_COLLECTIONS) && !(flags & SECRET_SERVICE_DEFER_ITEMS))
+		g_atomic_int_set (&self->pv->defer_items, 0);
+}
+
 static gboolean
 service_ensure_for_flags_sync (SecretService *self,
                                SecretServiceFlags flags,
                                GCancellable *cancellable,
                                GError **error)
 {
+	service_update_defer_items (self, flags);
+
 	if (flags & SECRET_SERVICE_OPEN_SESSION)
 		if (!secret_service_ensure_session_sync (self, cancellable, error))
 			return FALSE;
@@ -640,6 +796,7 @@ service_ensure_for_flags_async (SecretService *self,
 	InitClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
 
 	closure->flags = flags;
+	service_update_defer_items (self, flags);
 
 	if (closure->flags & SECRET_SERVICE_OPEN_SESSION)
 		secret_service_ensure_session (self, closure->cancellable,
@@ -664,6 +821,8 @@ secret_service_initable_init (GInitable *initable,
 		return FALSE;
 
 	self = SECRET_SERVICE (initable);
+	service_watch_lock_state (self);
+
 	return service_ensure_for_flags_sync (self, self->pv->init_flags, cancellable, error);
 }
 
@@ -689,6 +848,7 @@ on_init_base (GObject *source,
 		g_simple_async_result_take_error (res, error);
 		g_simple_async_result_complete (res);
 	} else {
+		service_watch_lock_state (self);
 		service_ensure_for_flags_async (self, self->pv->init_flags, res);
 	}
 
@@ -754,6 +914,229 @@ get_default_bus_name (void)
 	return bus_name;
 }
 
+typedef struct {
+	GType service_gtype;
+	gchar *bus_name;
+	SecretServiceFlags flags;
+	GCancellable *cancellable;
+	GAsyncReadyCallback callback;
+	gpointer user_data;
+} NewClosure;
+
+static void
+new_closure_free (gpointer data)
+{
+	NewClosure *closure = data;
+	g_free (closure->bus_name);
+	g_clear_object (&closure->cancellable);
+	g_slice_free (NewClosure, closure);
+}
+
+static void
+service_new_with_connection (GType service_gtype,
+                             const gchar *bus_name,
+                             SecretServiceFlags flags,
+                             GDBusConnection *connection,
+                             GCancellable *cancellable,
+                             GAsyncReadyCallback callback,
+                             gpointer user_data)
+{
+	/* The proxy only uses the bus type when it has no connection */
+	g_async_initable_new_async (service_gtype, G_PRIORITY_DEFAULT,
+	                            cancellable, callback, user_data,
+	                            "g-flags", G_DBUS_PROXY_FLAGS_NONE,
+	                            "g-interface-info", _secret_gen_service_interface_info (),
+	                            "g-name", bus_name,
+	                            "g-bus-type", connection ? G_BUS_TYPE_NONE : G_BUS_TYPE_SESSION,
+	                            "g-connection", connection,
+	                            "g-object-path", SECRET_SERVICE_PATH,
+	                            "g-interface-name", SECRET_SERVICE_INTERFACE,
+	                            "flags", flags,
+	                            NULL);
+}
+
+static void
+service_new_report_error (GAsyncReadyCallback callback,
+                          gpointer user_data,
+                          GError *error)
+{
+	GSimpleAsyncResult *res;
+
+	/* Without a source object, recognized by service_new_propagate_error() */
+	res = g_simple_async_result_new (NULL, callback, user_data, service_new_report_error);
+	g_simple_async_result_take_error (res, error);
+	g_simple_async_result_complete_in_idle (res);
+	g_object_unref (res);
+}
+
+static gboolean
+service_new_propagate_error (GAsyncResult *result,
+                             GError **error)
+{
+	if (!g_simple_async_result_is_valid (result, NULL, service_new_report_error))
+		return FALSE;
+
+	g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result), error);
+	return TRUE;
+}
+
+static void
+on_new_private_connection (GObject *source,
+                           GAsyncResult *result,
+                           gpointer user_data)
+{
+	NewClosure *closure = user_data;
+	GDBusConnection *connection;
+	GError *error = NULL;
+
+	connection = g_dbus_connection_new_for_address_finish (result, &error);
+	if (error == NULL) {
+		service_new_with_connection (closure->service_gtype, closure->bus_name,
+		                             closure->flags, connection, closure->cancellable,
+		                             closure->callback, closure->user_data);
+		g_object_unref (connection);
+	} else {
+		service_new_report_error (closure->callback, closure->user_data, error);
+	}
+
+	new_closure_free (closure);
+}
+
+static void
+service_new_address_thread (GSimpleAsyncResult *res,
+                            GObject *source,
+                            GCancellable *cancellable)
+{
+	GError *error = NULL;
+	gchar *address;
+
+	/* This may need to read files or even launch a bus, so not in the caller's thread */
+	address = g_dbus_address_get_for_bus_sync (G_BUS_TYPE_SESSION, cancellable, &error);
+	if (address == NULL)
+		g_simple_async_result_take_error (res, error);
+	else
+		g_simple_async_result_set_op_res_gpointer (res, address, g_free);
+}
+
+static void
+on_new_private_address (GObject *source,
+                        GAsyncResult *result,
+                        gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (result);
+	NewClosure *closure = user_data;
+	GError *error = NULL;
+
+	if (g_simple_async_result_propagate_error (res, &error)) {
+		service_new_report_error (closure->callback, closure->user_data, error);
+		new_closure_free (closure);
+		return;
+	}
+
+	g_dbus_connection_new_for_address (g_simple_async_result_get_op_res_gpointer (res),
+	                                   G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+	                                   G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+	                                   NULL, closure->cancellable, on_new_private_connection, closure);
+}
+
+static gboolean
+service_check_connect (GError **error)
+{
+	/*
+	 * GDBus runs the connections of a process in one worker thread, which
+	 * a forked child doesn't inherit. Once a parent connected, any
+	 * connection in its child would hang, so fail instead.
+	 */
+	if (service_forked) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+		                     _("Couldn't connect to the secret storage from a process forked after connecting"));
+		return FALSE;
+	}
+
+	service_connected = TRUE;
+	return TRUE;
+}
+
+static void
+service_new (GType service_gtype,
+             const gchar *bus_name,
+             SecretServiceFlags flags,
+             GCancellable *cancellable,
+             GAsyncReadyCallback callback,
+             gpointer user_data)
+{
+	GSimpleAsyncResult *res;
+	NewClosure *closure;
+	GError *error = NULL;
+
+	if (!service_check_connect (&error)) {
+		service_new_report_error (callback, user_data, error);
+		return;
+	}
+
+	if (!(flags & SECRET_SERVICE_PRIVATE_CONNECTION)) {
+		service_new_with_connection (service_gtype, bus_name, flags, NULL,
+		                             cancellable, callback, user_data);
+		return;
+	}
+
+	closure = g_slice_new0 (NewClosure);
+	closure->service_gtype = service_gtype;
+	closure->bus_name = g_strdup (bus_name);
+	closure->flags = flags;
+	closure->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	closure->callback = callback;
+	closure->user_data = user_data;
+
+	res = g_simple_async_result_new (NULL, on_new_private_address, closure, service_new);
+	g_simple_async_result_run_in_thread (res, service_new_address_thread,
+	                                     G_PRIORITY_DEFAULT, cancellable);
+	g_object_unref (res);
+}
+
+static SecretService *
+service_new_sync (GType service_gtype,
+                  const gchar *bus_name,
+                  SecretServiceFlags flags,
+                  GCancellable *cancellable,
+                  GError **error)
+{
+	GDBusConnection *connection = NULL;
+	SecretService *service;
+	gchar *address;
+
+	if (!service_check_connect (error))
+		return NULL;
+
+	if (flags & SECRET_SERVICE_PRIVATE_CONNECTION) {
+		address = g_dbus_address_get_for_bus_sync (G_BUS_TYPE_SESSION, cancellable, error);
+		if (address == NULL)
+			return NULL;
+		connection = g_dbus_connection_new_for_address_sync (address,
+		                                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+		                                                     G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+		                                                     NULL, cancellable, error);
+		g_free (address);
+		if (connection == NULL)
+			return NULL;
+	}
+
+	service = g_initable_new (service_gtype, cancellable, error,
+	                          "g-flags", G_DBUS_PROXY_FLAGS_NONE,
+	                          "g-interface-info", _secret_gen_service_interface_info (),
+	                          "g-name", bus_name,
+	                          "g-bus-type", connection ? G_BUS_TYPE_NONE : G_BUS_TYPE_SESSION,
+	                          "g-connection", connection,
+	                          "g-object-path", SECRET_SERVICE_PATH,
+	                          "g-interface-name", SECRET_SERVICE_INTERFACE,
+	                          "flags", flags,
+	                          NULL);
+
+	if (connection)
+		g_object_unref (connection);
+	return service;
+}
+
 /**
  * secret_service_get:
  * @flags: flags for which service functionality to ensure is initialized
@@ -766,6 +1149,8 @@ get_default_bus_name (void)
  *
  * If @flags contains any flags of which parts of the secret service to
  * ensure are initialized, then those will be initialized before completing.
+ * The %SECRET_SERVICE_PRIVATE_CONNECTION flag is only honored when the
+ * shared proxy is first created.
  *
  * This method will return immediately and complete asynchronously.
  */
@@ -783,16 +1168,8 @@ secret_service_get (SecretServiceFlags flags,
 
 	/* Create a whole new service */
 	if (service == NULL) {
-		g_async_initable_new_async (SECRET_TYPE_SERVICE, G_PRIORITY_DEFAULT,
-		                            cancellable, callback, user_data,
-		                            "g-flags", G_DBUS_PROXY_FLAGS_NONE,
-		                            "g-interface-info", _secret_gen_service_interface_info (),
-		                            "g-name", get_default_bus_name (),
-		                            "g-bus-type", G_BUS_TYPE_SESSION,
-		                            "g-object-path", SECRET_SERVICE_PATH,
-		                            "g-interface-name", SECRET_SERVICE_INTERFACE,
-		                            "flags", flags,
-		                            NULL);
+		service_new (SECRET_TYPE_SERVICE, get_default_bus_name (), flags,
+		             cancellable, callback, user_data);
 
 	/* Just have to ensure that the service matches flags */
 	} else {
@@ -831,6 +1208,9 @@ secret_service_get_finish (GAsyncResult *result,
 	g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+	if (service_new_propagate_error (result, error))
+		return NULL;
+
 	source_object = g_async_result_get_source_object (result);
 
 	/* Just ensuring that the service matches flags */
@@ -882,15 +1262,8 @@ secret_service_get_sync (SecretServiceFlags flags,
 	service = service_get_instance ();
 
 	if (service == NULL) {
-		service = g_initable_new (SECRET_TYPE_SERVICE, cancellable, error,
-		                          "g-flags", G_DBUS_PROXY_FLAGS_NONE,
-		                          "g-interface-info", _secret_gen_service_interface_info (),
-		                          "g-name", get_default_bus_name (),
-		                          "g-bus-type", G_BUS_TYPE_SESSION,
-		                          "g-object-path", SECRET_SERVICE_PATH,
-		                          "g-interface-name", SECRET_SERVICE_INTERFACE,
-		                          "flags", flags,
-		                          NULL);
+		service = service_new_sync (SECRET_TYPE_SERVICE, get_default_bus_name (),
+		                            flags, cancellable, error);
 
 		if (service != NULL)
 			service_cache_instance (service);
@@ -961,16 +1334,8 @@ secret_service_open (GType service_gtype,
 	if (service_bus_name == NULL)
 		service_bus_name = get_default_bus_name ();
 
-	g_async_initable_new_async (service_gtype, G_PRIORITY_DEFAULT,
-	                            cancellable, callback, user_data,
-	                            "g-flags", G_DBUS_PROXY_FLAGS_NONE,
-	                            "g-interface-info", _secret_gen_service_interface_info (),
-	                            "g-name", service_bus_name,
-	                            "g-bus-type", G_BUS_TYPE_SESSION,
-	                            "g-object-path", SECRET_SERVICE_PATH,
-	                            "g-interface-name", SECRET_SERVICE_INTERFACE,
-	                            "flags", flags,
-	                            NULL);
+	service_new (service_gtype, service_bus_name, flags,
+	             cancellable, callback, user_data);
 }
 
 /**
@@ -994,6 +1359,9 @@ secret_service_open_finish (GAsyncResult *result,
 	g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
 	g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+	if (service_new_propagate_error (result, error))
+		return NULL;
+
 	source_object = g_async_result_get_source_object (result);
 	object = g_async_initable_new_finish (G_ASYNC_INITABLE (source_object),
 	                                      result, error);
@@ -1044,15 +1412,8 @@ secret_service_open_sync (GType service_gtype,
 	if (service_bus_name == NULL)
 		service_bus_name = get_default_bus_name ();
 
-	return g_initable_new (service_gtype, cancellable, error,
-	                       "g-flags", G_DBUS_PROXY_FLAGS_NONE,
-	                       "g-interface-info", _secret_gen_service_interface_info (),
-	                       "g-name", service_bus_name,
-	                       "g-bus-type", G_BUS_TYPE_SESSION,
-	                       "g-object-path", SECRET_SERVICE_PATH,
-	                       "g-interface-name", SECRET_SERVICE_INTERFACE,
-	                       "flags", flags,
-	                       NULL);
+	return service_new_sync (service_gtype, service_bus_name, flags,
+	                         cancellable, error);
 }
 
 /**
@@ -1080,6 +1441,10 @@ secret_service_get_flags (SecretService *self)
 		flags |= SECRET_SERVICE_OPEN_SESSION;
 	if (self->pv->collections)
 		flags |= SECRET_SERVICE_LOAD_COLLECTIONS;
+	if (self->pv->collections && g_atomic_int_get (&self->pv->defer_items))
+		flags |= SECRET_SERVICE_DEFER_ITEMS;
+	if (self->pv->init_flags & SECRET_SERVICE_PRIVATE_CONNECTION)
+		flags |= SECRET_SERVICE_PRIVATE_CONNECTION;
 
 	g_mutex_unlock (&self->pv->mutex);
 
@@ -1163,6 +1528,59 @@ _secret_service_find_collection_instance (SecretService *self,
 	return collection;
 }
 
+void
+_secret_service_remember_locked (SecretService *self,
+                                 const gchar *object_path,
+                                 gboolean locked)
+{
+	g_return_if_fail (SECRET_IS_SERVICE (self));
+	g_return_if_fail (object_path != NULL);
+
+	/* Changes are reported for the collection, never for an alias to it */
+	if (g_str_has_prefix (object_path, SECRET_ALIAS_PREFIX))
+		return;
+
+	g_mutex_lock (&self->pv->mutex);
+
+	if (locked) {
+		if (self->pv->locked_paths == NULL)
+			self->pv->locked_paths = g_hash_table_new_full (g_str_hash, g_str_equal,
+			                                                g_free, NULL);
+		g_hash_table_add (self->pv->locked_paths, g_strdup (object_path));
+
+	} else if (self->pv->locked_paths) {
+		g_hash_table_remove (self->pv->locked_paths, object_path);
+	}
+
+	g_mutex_unlock (&self->pv->mutex);
+}
+
+gboolean
+_secret_service_known_locked (SecretService *self,
+                              const gchar *object_path)
+{
+	SecretCollection *collection;
+	gboolean locked = FALSE;
+
+	g_return_val_if_fail (SECRET_IS_SERVICE (self), FALSE);
+	g_return_val_if_fail (object_path != NULL, FALSE);
+
+	g_mutex_lock (&self->pv->mutex);
+	if (self->pv->locked_paths)
+		locked = g_hash_table_contains (self->pv->locked_paths, object_path);
+	g_mutex_unlock (&self->pv->mutex);
+
+	if (!locked) {
+		collection = _secret_service_find_collection_instance (self, object_path);
+		if (collection != NULL) {
+			locked = secret_collection_get_locked (collection);
+			g_object_unref (collection);
+		}
+	}
+
+	return locked;
+}
+
 SecretSession *
 _secret_service_get_session (SecretService *self)
 {
@@ -1192,6 +1610,43 @@ _secret_service_take_session (SecretService *self,
 	g_mutex_unlock (&self->pv->mutex);
 }
 
+void
+_secret_service_count_stores (SecretService *self,
+                              guint written,
+                              guint skipped)
+{
+	g_return_if_fail (SECRET_IS_SERVICE (self));
+
+	g_atomic_int_add (&self->pv->stores_written, written);
+	g_atomic_int_add (&self->pv->stores_skipped, skipped);
+}
+
+/**
+ * secret_service_get_store_counts:
+ * @self: the secret service proxy
+ * @written: (out) (allow-none): location to place the number of items written
+ * @skipped: (out) (allow-none): location to place the number of writes skipped
+ *
+ * Get the number of items written and the number of writes skipped by
+ * conditional stores, such as secret_service_store_if_changed(), on this
+ * secret service proxy.
+ *
+ * A write is skipped when the item already has the same label, attributes
+ * and secret as would be stored.
+ */
+void
+secret_service_get_store_counts (SecretService *self,
+                                 guint *written,
+                                 guint *skipped)
+{
+	g_return_if_fail (SECRET_IS_SERVICE (self));
+
+	if (written)
+		*written = g_atomic_int_get (&self->pv->stores_written);
+	if (skipped)
+		*skipped = g_atomic_int_get (&self->pv->stores_skipped);
+}
+
 /**
  * secret_service_get_session_algorithms:
  * @self: the secret service proxy
@@ -1418,6 +1873,15 @@ typedef struct {
 	gint collections_loading;
 } EnsureClosure;
 
+static SecretCollectionFlags
+service_collection_flags (SecretService *self)
+{
+	/* Startup cost shouldn't depend on the size of keyrings never used */
+	if (g_atomic_int_get (&self->pv->defer_items))
+		return SECRET_COLLECTION_NONE;
+	return SECRET_COLLECTION_LOAD_ITEMS;
+}
+
 static GHashTable *
 collections_table_new (void)
 {
@@ -1467,6 +1931,39 @@ on_ensure_collection (GObject *source,
 	g_object_unref (res);
 }
 
+static void
+on_ensure_items (GObject *source,
+                 GAsyncResult *result,
+                 gpointer user_data)
+{
+	GSimpleAsyncResult *res = G_SIMPLE_ASYNC_RESULT (user_data);
+	SecretService *self = SECRET_SERVICE (g_async_result_get_source_object (user_data));
+	EnsureClosure *closure = g_simple_async_result_get_op_res_gpointer (res);
+	GError *error = NULL;
+
+	closure->collections_loading--;
+
+	if (!secret_collection_load_items_finish (SECRET_COLLECTION (source), result, &error))
+		g_simple_async_result_take_error (res, error);
+
+	if (closure->collections_loading == 0) {
+		service_update_collections (self, closure->collections);
+		g_simple_async_result_complete (res);
+	}
+
+	g_object_unref (self);
+	g_object_unref (res);
+}
+
+static gboolean
+service_collection_needs_items (SecretService *self,
+                                SecretCollection *collection)
+{
+	/* Loaded earlier while items were deferred, but now they're wanted */
+	return (service_collection_flags (self) & SECRET_COLLECTION_LOAD_ITEMS) &&
+	       !(secret_collection_get_flags (collection) & SECRET_COLLECTION_LOAD_ITEMS);
+}
+
 /**
  * secret_service_load_collections:
  * @self: the secret service
@@ -1482,6 +1979,9 @@ on_ensure_collection (GObject *source,
  * secret_service_get_sync() in order to ensure that the collections have been
  * loaded by the time you get the #SecretService proxy.
  *
+ * The items of each collection are loaded too, unless all callers so far
+ * asked for the %SECRET_SERVICE_DEFER_ITEMS flag.
+ *
  * This method will return immediately and complete asynchronously.
  */
 void
@@ -1516,10 +2016,15 @@ secret_service_load_collections (SecretService *self,
 
 		/* No such collection yet create a new one */
 		if (collection == NULL) {
-			secret_collection_new_for_dbus_path (self, path, SECRET_COLLECTION_LOAD_ITEMS,
+			secret_collection_new_for_dbus_path (self, path, service_collection_flags (self),
 			                                     cancellable, on_ensure_collection, g_object_ref (res));
 			closure->collections_loading++;
 		} else {
+			if (service_collection_needs_items (self, collection)) {
+				secret_collection_load_items (collection, cancellable,
+				                              on_ensure_items, g_object_ref (res));
+				closure->collections_loading++;
+			}
 			g_hash_table_insert (closure->collections, g_strdup (path), collection);
 		}
 	}
@@ -1574,6 +2079,9 @@ secret_service_load_collections_finish (SecretService *self,
  * secret_service_get_sync() in order to ensure that the collections have been
  * loaded by the time you get the #SecretService proxy.
  *
+ * The items of each collection are loaded too, unless all callers so far
+ * asked for the %SECRET_SERVICE_DEFER_ITEMS flag.
+ *
  * This method may block indefinitely and should not be used in user interface
  * threads.
  *
@@ -1607,12 +2115,19 @@ secret_service_load_collections_sync (SecretService *self,
 		/* No such collection yet create a new one */
 		if (collection == NULL) {
 			collection = secret_collection_new_for_dbus_path_sync (self, path,
-			                                                       SECRET_COLLECTION_LOAD_ITEMS,
+			                                                       service_collection_flags (self),
 			                                                       cancellable, error);
 			if (collection == NULL) {
 				ret = FALSE;
 				break;
 			}
+
+		} else if (service_collection_needs_items (self, collection)) {
+			if (!secret_collection_load_items_sync (collection, cancellable, error)) {
+				g_object_unref (collection);
+				ret = FALSE;
+				break;
+			}
 		}
 
 		g_hash_table_insert (collections, g_strdup (path), collection);
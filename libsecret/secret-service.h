@@ -33,6 +33,8 @@ typedef enum {
 	SECRET_SERVICE_NONE = 0,
 	SECRET_SERVICE_OPEN_SESSION = 1 << 1,
 	SECRET_SERVICE_LOAD_COLLECTIONS = 1 << 2,
+	SECRET_SERVICE_DEFER_ITEMS = 1 << 3,
+	SECRET_SERVICE_PRIVATE_CONNECTION = 1 << 4,
 } SecretServiceFlags;
 
 typedef enum {
@@ -132,6 +134,10 @@ SecretServiceFlags   secret_service_get_flags                     (SecretService
 
 const gchar *        secret_service_get_session_algorithms        (SecretService *self);
 
+void                 secret_service_get_store_counts              (SecretService *self,
+                                                                   guint *written,
+                                                                   guint *skipped);
+
 GList *              secret_service_get_collections               (SecretService *self);
 
 void                 secret_service_ensure_session                (SecretService *self,
@@ -196,6 +202,46 @@ GList *              secret_service_search_sync                   (SecretService
                                                                    GCancellable *cancellable,
                                                                    GError **error);
 
+void                 secret_service_search_collections            (SecretService *service,
+                                                                   GList *collections,
+                                                                   const SecretSchema *schema,
+                                                                   GHashTable *attributes,
+                                                                   SecretSearchFlags flags,
+                                                                   GCancellable *cancellable,
+                                                                   GAsyncReadyCallback callback,
+                                                                   gpointer user_data);
+
+GList *              secret_service_search_collections_finish     (SecretService *service,
+                                                                   GAsyncResult *result,
+                                                                   GError **error);
+
+GList *              secret_service_search_collections_sync       (SecretService *service,
+                                                                   GList *collections,
+                                                                   const SecretSchema *schema,
+                                                                   GHashTable *attributes,
+                                                                   SecretSearchFlags flags,
+                                                                   GCancellable *cancellable,
+                                                                   GError **error);
+
+void                 secret_service_search_packed                 (SecretService *service,
+                                                                   const SecretSchema *schema,
+                                                                   GHashTable *attributes,
+                                                                   SecretSearchFlags flags,
+                                                                   GCancellable *cancellable,
+                                                                   GAsyncReadyCallback callback,
+                                                                   gpointer user_data);
+
+GVariant *           secret_service_search_packed_finish          (SecretService *service,
+                                                                   GAsyncResult *result,
+                                                                   GError **error);
+
+GVariant *           secret_service_search_packed_sync            (SecretService *service,
+                                                                   const SecretSchema *schema,
+                                                                   GHashTable *attributes,
+                                                                   SecretSearchFlags flags,
+                                                                   GCancellable *cancellable,
+                                                                   GError **error);
+
 void                 secret_service_lock                          (SecretService *service,
                                                                    GList *objects,
                                                                    GCancellable *cancellable,
@@ -253,6 +299,58 @@ gboolean             secret_service_store_sync                    (SecretService
                                                                    GCancellable *cancellable,
                                                                    GError **error);
 
+void                 secret_service_store_if_changed              (SecretService *service,
+                                                                   const SecretSchema *schema,
+                                                                   GHashTable *attributes,
+                                                                   const gchar *collection,
+                                                                   const gchar *label,
+                                                                   SecretValue *value,
+                                                                   GCancellable *cancellable,
+                                                                   GAsyncReadyCallback callback,
+                                                                   gpointer user_data);
+
+gboolean             secret_service_store_if_changed_finish       (SecretService *service,
+                                                                   GAsyncResult *result,
+                                                                   gboolean *written,
+                                                                   GError **error);
+
+gboolean             secret_service_store_if_changed_sync         (SecretService *service,
+                                                                   const SecretSchema *schema,
+                                                                   GHashTable *attributes,
+                                                                   const gchar *collection,
+                                                                   const gchar *label,
+                                                                   SecretValue *value,
+                                                                   gboolean *written,
+                                                                   GCancellable *cancellable,
+                                                                   GError **error);
+
+void                 secret_service_store_all_if_changed          (SecretService *service,
+                                                                   const SecretSchema *schema,
+                                                                   const gchar *collection,
+                                                                   GHashTable **attributes,
+                                                                   const gchar **labels,
+                                                                   SecretValue **values,
+                                                                   guint n_items,
+                                                                   GCancellable *cancellable,
+                                                                   GAsyncReadyCallback callback,
+                                                                   gpointer user_data);
+
+gboolean             secret_service_store_all_if_changed_finish   (SecretService *service,
+                                                                   GAsyncResult *result,
+                                                                   guint *written,
+                                                                   GError **error);
+
+gboolean             secret_service_store_all_if_changed_sync     (SecretService *service,
+                                                                   const SecretSchema *schema,
+                                                                   const gchar *collection,
+                                                                   GHashTable **attributes,
+                                                                   const gchar **labels,
+                                                                   SecretValue **values,
+                                                                   guint n_items,
+                                                                   guint *written,
+                                                                   GCancellable *cancellable,
+                                                                   GError **error);
+
 void                 secret_service_lookup                        (SecretService *service,
                                                                    const SecretSchema *schema,
                                                                    GHashTable *attributes,
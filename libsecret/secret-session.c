@@ -33,6 +33,9 @@ EGG_SECURE_DECLARE (secret_session);
 #define ALGORITHMS_AES    "dh-ietf1024-sha256-aes128-cbc-pkcs7"
 #define ALGORITHMS_PLAIN  "plain"
 
+/* Key and cipher buffers are aligned to the AES block, for vector loads */
+#define AES_ALIGNMENT     16
+
 struct _SecretSession {
 	gchar *path;
 	const gchar *algorithms;
@@ -65,6 +68,30 @@ _secret_session_free (gpointer data)
 
 #ifdef WITH_GCRYPT
 
+static gboolean
+default_dh_params (gcry_mpi_t *prime,
+                   gcry_mpi_t *base)
+{
+	static gsize initialized = 0;
+	static gcry_mpi_t default_prime = NULL;
+	static gcry_mpi_t default_base = NULL;
+
+	/* Parsed once per process, and still valid in a forked child */
+	if (g_once_init_enter (&initialized)) {
+		if (!egg_dh_default_params ("ietf-ike-grp-modp-1024",
+		                            &default_prime, &default_base))
+			g_warn_if_reached ();
+		g_once_init_leave (&initialized, 1);
+	}
+
+	if (default_prime == NULL)
+		return FALSE;
+
+	*prime = gcry_mpi_copy (default_prime);
+	*base = gcry_mpi_copy (default_base);
+	return TRUE;
+}
+
 static GVariant *
 request_open_session_aes (SecretSession *session)
 {
@@ -81,8 +108,7 @@ request_open_session_aes (SecretSession *session)
 	egg_libgcrypt_initialize ();
 
 	/* Initialize our local parameters and values */
-	if (!egg_dh_default_params ("ietf-ike-grp-modp-1024",
-	                            &session->prime, &base))
+	if (!default_dh_params (&session->prime, &base))
 		g_return_val_if_reached (NULL);
 
 #if 0
@@ -159,7 +185,7 @@ response_open_session_aes (SecretSession *session,
 	}
 
 	session->n_key = 16;
-	session->key = egg_secure_alloc (session->n_key);
+	session->key = egg_secure_alloc_aligned (session->n_key, AES_ALIGNMENT);
 	if (!egg_hkdf_perform ("sha256", ikm, n_ikm, NULL, 0, NULL, 0,
 	                       session->key, session->n_key))
 		g_return_val_if_reached (FALSE);
@@ -426,7 +452,7 @@ service_decode_aes_secret (SecretSession *session,
 
 	/* Copy the memory buffer */
 	n_padded = n_value;
-	padded = egg_secure_alloc (n_padded);
+	padded = egg_secure_alloc_aligned (n_padded, AES_ALIGNMENT);
 	memcpy (padded, value, n_padded);
 
 	/* Perform the decryption */
@@ -532,7 +558,7 @@ pkcs7_pad_bytes_in_secure_memory (gconstpointer secret,
 	g_assert (*n_padded > 0);
 	n_pad = *n_padded - length;
 	g_assert (n_pad > 0 && n_pad <= 16);
-	padded = egg_secure_alloc (*n_padded);
+	padded = egg_secure_alloc_aligned (*n_padded, AES_ALIGNMENT);
 	memcpy (padded, secret, length);
 	memset (padded + length, n_pad, n_pad);
 	return padded;
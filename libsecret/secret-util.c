@@ -373,6 +373,33 @@ _secret_util_set_property_finish (GDBusProxy *proxy,
 	return closure->result;
 }
 
+gboolean
+_secret_util_get_properties_sync (GDBusProxy *proxy,
+                                  GCancellable *cancellable,
+                                  GError **error)
+{
+	GVariant *retval;
+
+	g_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+	retval = g_dbus_connection_call_sync (g_dbus_proxy_get_connection (proxy),
+	                                      g_dbus_proxy_get_name (proxy),
+	                                      g_dbus_proxy_get_object_path (proxy),
+	                                      SECRET_PROPERTIES_INTERFACE, "GetAll",
+	                                      g_variant_new ("(s)", g_dbus_proxy_get_interface_name (proxy)),
+	                                      G_VARIANT_TYPE ("(a{sv})"),
+	                                      G_DBUS_CALL_FLAGS_NONE, -1,
+	                                      cancellable, error);
+
+	if (retval == NULL)
+		return FALSE;
+
+	process_get_all_reply (proxy, retval);
+	g_variant_unref (retval);
+	return TRUE;
+}
+
 gboolean
 _secret_util_set_property_sync (GDBusProxy *proxy,
                                 const gchar *property,
@@ -18,6 +18,7 @@
 #include "secret-value.h"
 
 #include "egg/egg-secure-memory.h"
+#include "egg/egg-text.h"
 
 #include <string.h>
 
@@ -60,6 +61,14 @@ struct _SecretValue {
 	gsize length;
 	GDestroyNotify destroy;
 	gchar *content_type;
+	gint is_text;
+};
+
+/* Whether a value is a password, cached in is_text */
+enum {
+	TEXT_UNKNOWN = 0,
+	TEXT_VALID,
+	TEXT_INVALID
 };
 
 GType
@@ -249,14 +258,26 @@ secret_value_unref (gpointer value)
 static gboolean
 is_password_value (SecretValue *value)
 {
+	gboolean result;
+	gint is_text;
+
+	/* The secret and content type never change, so only check once */
+	is_text = g_atomic_int_get (&value->is_text);
+	if (is_text != TEXT_UNKNOWN)
+		return is_text == TEXT_VALID;
+
 	if (value->content_type && g_str_equal (value->content_type, "text/plain"))
-		return TRUE;
+		result = TRUE;
 
 	/* gnome-keyring-daemon used to return passwords like this, so support this, but validate */
-	if (!value->content_type || g_str_equal (value->content_type, "application/octet-stream"))
-		return g_utf8_validate (value->secret, value->length, NULL);
+	else if (!value->content_type || g_str_equal (value->content_type, "application/octet-stream"))
+		result = egg_text_utf8_validate (value->secret, value->length);
+
+	else
+		result = FALSE;
 
-	return FALSE;
+	g_atomic_int_set (&value->is_text, result ? TEXT_VALID : TEXT_INVALID);
+	return result;
 }
 
 gchar *
@@ -322,3 +343,18 @@ _secret_value_unref_to_string (SecretValue *value)
 
 	return result;
 }
+
+gboolean
+_secret_value_equal (SecretValue *value,
+                     SecretValue *other)
+{
+	g_return_val_if_fail (value != NULL, FALSE);
+	g_return_val_if_fail (other != NULL, FALSE);
+
+	if (value == other)
+		return TRUE;
+
+	return value->length == other->length &&
+	       g_strcmp0 (value->content_type, other->content_type) == 0 &&
+	       memcmp (value->secret, other->secret, value->length) == 0;
+}
@@ -0,0 +1,265 @@
+/* libsecret - GLib wrapper for Secret Service
+ *
+ * Copyright 2012 Red Hat Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ */
+
+/*
+ * Lookup latency with a noisy neighbour on the session bus connection.
+ *
+ * An emitter thread floods the bus with broadcast signals, which the
+ * application subscribes to on the shared session bus connection, and
+ * dispatches in its main loop. Secret lookups are then timed through the
+ * shared #SecretService, and through one opened with
+ * %SECRET_SERVICE_PRIVATE_CONNECTION, whose replies don't queue behind the
+ * signals. Latency percentiles are printed for each.
+ *
+ * Use 'make bench-native' in this directory to run. Set BENCH_ITERATIONS
+ * to change the number of lookups timed.
+ */
+
+#include "config.h"
+
+#include "secret-attributes.h"
+#include "secret-service.h"
+#include "secret-value.h"
+
+#include "mock-service.h"
+
+#include <glib.h>
+
+#include <stdlib.h>
+
+#define NOISE_PATH       "/org/mock/Noise"
+#define NOISE_INTERFACE  "org.mock.Noise"
+#define NOISE_SIGNAL     "Noise"
+
+static const SecretSchema MOCK_SCHEMA = {
+	"org.mock.Schema",
+	SECRET_SCHEMA_NONE,
+	{
+		{ "number", SECRET_SCHEMA_ATTRIBUTE_INTEGER },
+		{ "string", SECRET_SCHEMA_ATTRIBUTE_STRING },
+		{ "even", SECRET_SCHEMA_ATTRIBUTE_BOOLEAN },
+	}
+};
+
+static volatile gint noise_running = 0;
+static volatile gint noise_received = 0;
+
+static gpointer
+noise_emitter_thread (gpointer user_data)
+{
+	const gchar *address = user_data;
+	GDBusConnection *connection;
+	GError *error = NULL;
+	guint sent = 0;
+
+	connection = g_dbus_connection_new_for_address_sync (address,
+	                                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+	                                                     G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+	                                                     NULL, NULL, &error);
+	if (connection == NULL) {
+		g_printerr ("bench-noisy: couldn't connect emitter: %s\n", error->message);
+		g_error_free (error);
+		return NULL;
+	}
+
+	while (g_atomic_int_get (&noise_running)) {
+		g_dbus_connection_emit_signal (connection, NULL, NOISE_PATH, NOISE_INTERFACE,
+		                               NOISE_SIGNAL, g_variant_new ("(u)", sent), NULL);
+
+		/* Keep the outgoing queue bounded */
+		if (++sent % 64 == 0)
+			g_dbus_connection_flush_sync (connection, NULL, NULL);
+	}
+
+	g_dbus_connection_flush_sync (connection, NULL, NULL);
+	g_object_unref (connection);
+	return NULL;
+}
+
+static void
+on_noise (GDBusConnection *connection,
+          const gchar *sender_name,
+          const gchar *object_path,
+          const gchar *interface_name,
+          const gchar *signal_name,
+          GVariant *parameters,
+          gpointer user_data)
+{
+	g_atomic_int_inc (&noise_received);
+}
+
+static gpointer
+noise_dispatch_thread (gpointer user_data)
+{
+	GMainLoop *loop = user_data;
+	g_main_loop_run (loop);
+	return NULL;
+}
+
+static gboolean
+on_quit_loop (gpointer user_data)
+{
+	g_main_loop_quit (user_data);
+	return FALSE;
+}
+
+static gint
+compare_latency (gconstpointer a,
+                 gconstpointer b)
+{
+	gint64 la = *(const gint64 *)a;
+	gint64 lb = *(const gint64 *)b;
+	return (la > lb) - (la < lb);
+}
+
+static void
+bench_lookups (const gchar *name,
+               SecretService *service,
+               GHashTable *attributes,
+               guint iterations)
+{
+	SecretValue *value;
+	GError *error = NULL;
+	gint64 *latencies;
+	gint received;
+	gint64 start;
+	guint i;
+
+	/* Warm up once, so that the session and connection are established */
+	value = secret_service_lookup_sync (service, &MOCK_SCHEMA, attributes, NULL, &error);
+	if (value == NULL) {
+		g_printerr ("bench-noisy: lookup failed: %s\n",
+		            error ? error->message : "no matching item");
+		g_clear_error (&error);
+		return;
+	}
+	secret_value_unref (value);
+
+	latencies = g_new0 (gint64, iterations);
+	received = g_atomic_int_get (&noise_received);
+
+	for (i = 0; i < iterations; i++) {
+		start = g_get_monotonic_time ();
+		value = secret_service_lookup_sync (service, &MOCK_SCHEMA, attributes, NULL, &error);
+		latencies[i] = g_get_monotonic_time () - start;
+		g_assert_no_error (error);
+		secret_value_unref (value);
+	}
+
+	received = g_atomic_int_get (&noise_received) - received;
+	qsort (latencies, iterations, sizeof (gint64), compare_latency);
+
+	g_print ("%-20s %8u %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT
+	         " %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT " %10d\n",
+	         name, iterations,
+	         latencies[iterations / 2],
+	         latencies[(iterations * 90) / 100],
+	         latencies[(iterations * 99) / 100],
+	         latencies[iterations - 1],
+	         received);
+
+	g_free (latencies);
+}
+
+int
+main (int argc, char **argv)
+{
+	SecretService *shared = NULL;
+	SecretService *dedicated = NULL;
+	GDBusConnection *connection;
+	GThread *dispatcher = NULL;
+	GThread *emitter = NULL;
+	GHashTable *attributes;
+	GError *error = NULL;
+	const gchar *env;
+	GMainLoop *loop;
+	guint iterations;
+	guint subscription;
+	gchar *address;
+
+	g_set_prgname ("bench-noisy");
+#if !GLIB_CHECK_VERSION(2,35,0)
+	g_type_init ();
+#endif
+
+	env = g_getenv ("BENCH_ITERATIONS");
+	iterations = env ? strtoul (env, NULL, 10) : 0;
+	if (iterations == 0)
+		iterations = 1000;
+
+	if (!mock_service_start ("mock-service-normal.py", &error)) {
+		g_printerr ("bench-noisy: couldn't start mock service: %s\n", error->message);
+		g_error_free (error);
+		return 77;
+	}
+
+	address = g_dbus_address_get_for_bus_sync (G_BUS_TYPE_SESSION, NULL, &error);
+	g_assert_no_error (error);
+
+	shared = secret_service_get_sync (SECRET_SERVICE_OPEN_SESSION, NULL, &error);
+	g_assert_no_error (error);
+	dedicated = secret_service_open_sync (SECRET_TYPE_SERVICE, NULL,
+	                                      SECRET_SERVICE_OPEN_SESSION | SECRET_SERVICE_PRIVATE_CONNECTION,
+	                                      NULL, &error);
+	g_assert_no_error (error);
+
+	attributes = secret_attributes_build (&MOCK_SCHEMA,
+	                                      "even", FALSE,
+	                                      "string", "one",
+	                                      "number", 1,
+	                                      NULL);
+
+	g_print ("# %-18s %8s %10s %10s %10s %10s %10s\n", "connection", "lookups",
+	         "p50 usecs", "p90 usecs", "p99 usecs", "max usecs", "signals");
+
+	bench_lookups ("shared-quiet", shared, attributes, iterations);
+	bench_lookups ("private-quiet", dedicated, attributes, iterations);
+
+	/* The application listens to the noise on the shared connection */
+	connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+	g_assert_no_error (error);
+	subscription = g_dbus_connection_signal_subscribe (connection, NULL, NOISE_INTERFACE,
+	                                                   NOISE_SIGNAL, NOISE_PATH, NULL,
+	                                                   G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                   on_noise, NULL, NULL);
+
+	loop = g_main_loop_new (NULL, FALSE);
+	dispatcher = g_thread_new ("dispatch", noise_dispatch_thread, loop);
+
+	g_atomic_int_set (&noise_running, 1);
+	emitter = g_thread_new ("emitter", noise_emitter_thread, address);
+
+	/* Let the noise build up before measuring */
+	g_usleep (G_USEC_PER_SEC / 4);
+
+	bench_lookups ("shared-noisy", shared, attributes, iterations);
+	bench_lookups ("private-noisy", dedicated, attributes, iterations);
+
+	g_atomic_int_set (&noise_running, 0);
+	g_thread_join (emitter);
+
+	g_idle_add (on_quit_loop, loop);
+	g_thread_join (dispatcher);
+	g_main_loop_unref (loop);
+
+	g_dbus_connection_signal_unsubscribe (connection, subscription);
+	g_object_unref (connection);
+
+	g_hash_table_unref (attributes);
+	g_object_unref (dedicated);
+	g_object_unref (shared);
+	secret_service_disconnect ();
+	mock_service_stop ();
+	g_free (address);
+
+	return 0;
+}
@@ -0,0 +1,351 @@
+/* libsecret - GLib wrapper for Secret Service
+ *
+ * Copyright 2012 Red Hat Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ */
+
+/*
+ * Deterministic per-operation benchmarks.
+ *
+ * Each operation is run a fixed number of times. When running under
+ * callgrind, statistics are zeroed before and dumped after each operation,
+ * so that instruction counts and calls to malloc() and friends can be
+ * attributed to it. Slices always use malloc() so that they are counted
+ * too. The dump is named "<operation>/<iterations>". Wall clock time per
+ * operation is printed, though it is only meaningful when not under
+ * valgrind. Operations on whole blocks print the page source that served
+ * them. Variants at other hardening levels are skipped in fast builds,
+ * where the level can't be changed.
+ *
+ * Use 'make bench' in this directory to run and report allocations and
+ * instructions per operation from the dumps.
+ */
+
+#include "config.h"
+
+#include "secret-attributes.h"
+#include "secret-private.h"
+#include "secret-service.h"
+#include "secret-value.h"
+
+#include "mock-service.h"
+
+#include "egg/egg-secure-memory.h"
+
+#include <valgrind/valgrind.h>
+
+#include <glib.h>
+
+EGG_SECURE_DECLARE (bench_ops);
+
+/*
+ * The callgrind client requests. These are defined here rather than
+ * including callgrind.h, which is not bundled, but use the same codes.
+ */
+#define BENCH_CALLGRIND_REQUEST(req, arg) \
+	do { unsigned long _unused; \
+	     VALGRIND_DO_CLIENT_REQUEST (_unused, 0, VG_USERREQ_TOOL_BASE ('C', 'T') + (req), \
+	                                 (arg), 0, 0, 0, 0); \
+	     (void)_unused; } while (0)
+#define BENCH_CALLGRIND_ZERO_STATS()          BENCH_CALLGRIND_REQUEST (1, 0)
+#define BENCH_CALLGRIND_DUMP_STATS_AT(name)   BENCH_CALLGRIND_REQUEST (3, (name))
+
+static const SecretSchema MOCK_SCHEMA = {
+	"org.mock.Schema",
+	SECRET_SCHEMA_NONE,
+	{
+		{ "number", SECRET_SCHEMA_ATTRIBUTE_INTEGER },
+		{ "string", SECRET_SCHEMA_ATTRIBUTE_STRING },
+		{ "even", SECRET_SCHEMA_ATTRIBUTE_BOOLEAN },
+	}
+};
+
+typedef struct {
+	GHashTable *attributes;
+	GVariant *attributes_variant;
+	SecretService *service;
+	SecretValue *value;
+	GVariant *encoded;
+	int pages;
+} Fixture;
+
+typedef void (* BenchFunc) (Fixture *fixture);
+
+static void
+bench_secure_alloc_free (Fixture *fixture)
+{
+	gpointer memory;
+
+	memory = egg_secure_alloc (64);
+	egg_secure_free (memory);
+}
+
+static void
+bench_secure_realloc (Fixture *fixture)
+{
+	gpointer memory;
+
+	memory = egg_secure_alloc (16);
+	memory = egg_secure_realloc (memory, 256);
+	egg_secure_free (memory);
+}
+
+/*
+ * Larger than the default block, so that pages are acquired and released,
+ * and than a typical 2 MiB huge page, so that the huge source is used for
+ * it. Room is left for the guards in a block of whole huge pages.
+ */
+#define BENCH_BLOCK_SIZE (4 * 1024 * 1024 - 64)
+
+static void
+bench_secure_block_alloc_free (Fixture *fixture)
+{
+	gpointer memory;
+
+	memory = egg_secure_alloc (BENCH_BLOCK_SIZE);
+	fixture->pages = egg_secure_get_pages_for (memory);
+	egg_secure_free (memory);
+}
+
+static void
+bench_secure_block_touch (Fixture *fixture)
+{
+	volatile guchar *memory;
+	gsize i;
+
+	/* Strided so that every access is likely a different cache line and page */
+	memory = egg_secure_alloc (BENCH_BLOCK_SIZE);
+	fixture->pages = egg_secure_get_pages_for ((gpointer)memory);
+	for (i = 0; i < BENCH_BLOCK_SIZE; i += 4096 + 64)
+		memory[i]++;
+	for (i = 0; i < BENCH_BLOCK_SIZE; i += 64)
+		memory[i]++;
+	egg_secure_free ((gpointer)memory);
+}
+
+static void
+bench_secure_strdup (Fixture *fixture)
+{
+	egg_secure_strfree (egg_secure_strdup ("the secret password"));
+}
+
+static void
+bench_value_new_unref (Fixture *fixture)
+{
+	secret_value_unref (secret_value_new ("the secret password", -1, "text/plain"));
+}
+
+static void
+bench_attributes_build (Fixture *fixture)
+{
+	g_hash_table_unref (secret_attributes_build (&MOCK_SCHEMA,
+	                                             "number", 5,
+	                                             "string", "five",
+	                                             "even", FALSE,
+	                                             NULL));
+}
+
+static void
+bench_attributes_validate (Fixture *fixture)
+{
+	_secret_attributes_validate (&MOCK_SCHEMA, fixture->attributes, G_STRFUNC, TRUE);
+}
+
+static void
+bench_attributes_to_variant (Fixture *fixture)
+{
+	g_variant_unref (g_variant_ref_sink (_secret_attributes_to_variant (fixture->attributes,
+	                                                                    MOCK_SCHEMA.name)));
+}
+
+static void
+bench_attributes_for_variant (Fixture *fixture)
+{
+	g_hash_table_unref (_secret_attributes_for_variant (fixture->attributes_variant));
+}
+
+static void
+bench_session_encode (Fixture *fixture)
+{
+	SecretSession *session;
+
+	session = _secret_service_get_session (fixture->service);
+	g_variant_unref (g_variant_ref_sink (_secret_session_encode_secret (session, fixture->value)));
+}
+
+static void
+bench_session_decode (Fixture *fixture)
+{
+	SecretSession *session;
+
+	session = _secret_service_get_session (fixture->service);
+	secret_value_unref (_secret_session_decode_secret (session, fixture->encoded));
+}
+
+typedef struct {
+	const gchar *name;
+	BenchFunc func;
+	guint iterations;
+	gboolean needs_session;
+	int hardening;
+	int pages;
+} BenchOp;
+
+static const BenchOp BENCH_OPS[] = {
+	{ "secure-alloc-free", bench_secure_alloc_free, 1000, FALSE, 0 },
+	{ "secure-alloc-free-fast", bench_secure_alloc_free, 1000, FALSE, EGG_SECURE_HARDEN_FAST },
+	{ "secure-alloc-free-paranoid", bench_secure_alloc_free, 1000, FALSE, EGG_SECURE_HARDEN_PARANOID },
+	{ "secure-realloc", bench_secure_realloc, 1000, FALSE, 0 },
+	{ "secure-realloc-fast", bench_secure_realloc, 1000, FALSE, EGG_SECURE_HARDEN_FAST },
+	{ "secure-realloc-paranoid", bench_secure_realloc, 1000, FALSE, EGG_SECURE_HARDEN_PARANOID },
+	{ "secure-block-alloc-free", bench_secure_block_alloc_free, 100, FALSE, 0, EGG_SECURE_PAGES_DEFAULT },
+	{ "secure-block-alloc-free-huge", bench_secure_block_alloc_free, 100, FALSE, 0, EGG_SECURE_PAGES_HUGE },
+	{ "secure-block-touch", bench_secure_block_touch, 100, FALSE, 0, EGG_SECURE_PAGES_DEFAULT },
+	{ "secure-block-touch-huge", bench_secure_block_touch, 100, FALSE, 0, EGG_SECURE_PAGES_HUGE },
+	{ "secure-strdup", bench_secure_strdup, 1000, FALSE, 0 },
+	{ "value-new-unref", bench_value_new_unref, 1000, FALSE, 0 },
+	{ "attributes-build", bench_attributes_build, 1000, FALSE, 0 },
+	{ "attributes-validate", bench_attributes_validate, 1000, FALSE, 0 },
+	{ "attributes-to-variant", bench_attributes_to_variant, 1000, FALSE, 0 },
+	{ "attributes-for-variant", bench_attributes_for_variant, 1000, FALSE, 0 },
+	{ "session-encode", bench_session_encode, 100, TRUE, 0 },
+	{ "session-decode", bench_session_decode, 100, TRUE, 0 },
+};
+
+static void
+bench_run (const BenchOp *op,
+           Fixture *fixture)
+{
+	const gchar *served;
+	gint64 usecs;
+	int hardening;
+	int pages;
+	gchar *dump;
+	guint i;
+
+	/* Operations run at the build or SECMEM_HARDENING level unless specified */
+	hardening = egg_secure_get_hardening ();
+	if (op->hardening != 0)
+		egg_secure_set_hardening (op->hardening);
+
+	/* And with pages from the SECMEM_PAGES source unless specified */
+	pages = egg_secure_get_pages ();
+	if (op->pages != 0)
+		egg_secure_set_pages (op->pages);
+
+	/* Warm up once, so that one-time initialization is not counted */
+	fixture->pages = 0;
+	(op->func) (fixture);
+
+	dump = g_strdup_printf ("%s/%u", op->name, op->iterations);
+
+	usecs = g_get_monotonic_time ();
+
+	if (RUNNING_ON_VALGRIND)
+		BENCH_CALLGRIND_ZERO_STATS ();
+
+	for (i = 0; i < op->iterations; i++)
+		(op->func) (fixture);
+
+	if (RUNNING_ON_VALGRIND)
+		BENCH_CALLGRIND_DUMP_STATS_AT (dump);
+
+	usecs = g_get_monotonic_time () - usecs;
+
+	/* The source may have fallen back, for example to stay within RLIMIT_MEMLOCK */
+	switch (fixture->pages) {
+	case EGG_SECURE_PAGES_DEFAULT:
+		served = "default";
+		break;
+	case EGG_SECURE_PAGES_HUGE:
+		served = "huge";
+		break;
+	default:
+		served = "-";
+		break;
+	}
+
+	g_print ("%-28s %8u %10.2f %8s\n", op->name, op->iterations,
+	         (gdouble)usecs / op->iterations, served);
+
+	egg_secure_set_hardening (hardening);
+	egg_secure_set_pages (pages);
+	g_free (dump);
+}
+
+int
+main (int argc, char **argv)
+{
+	GError *error = NULL;
+	Fixture fixture = { NULL, };
+	gboolean have_session;
+	guint i;
+
+	/* Must happen before anything else allocates */
+	g_setenv ("G_SLICE", "always-malloc", TRUE);
+
+	g_set_prgname ("bench-ops");
+#if !GLIB_CHECK_VERSION(2,35,0)
+	g_type_init ();
+#endif
+
+	fixture.attributes = secret_attributes_build (&MOCK_SCHEMA,
+	                                              "number", 5,
+	                                              "string", "five",
+	                                              "even", FALSE,
+	                                              NULL);
+	fixture.attributes_variant = g_variant_ref_sink (_secret_attributes_to_variant (fixture.attributes,
+	                                                                                MOCK_SCHEMA.name));
+	fixture.value = secret_value_new ("the secret password", -1, "text/plain");
+
+	have_session = mock_service_start ("mock-service-normal.py", &error);
+	if (have_session) {
+		fixture.service = secret_service_get_sync (SECRET_SERVICE_OPEN_SESSION, NULL, &error);
+		have_session = fixture.service != NULL;
+	}
+	if (have_session) {
+		fixture.encoded = _secret_session_encode_secret (_secret_service_get_session (fixture.service),
+		                                                 fixture.value);
+		g_variant_ref_sink (fixture.encoded);
+	}
+	if (error != NULL) {
+		g_printerr ("bench-ops: skipping session operations: %s\n", error->message);
+		g_clear_error (&error);
+	}
+
+	g_print ("# %-26s %8s %10s %8s\n", "operation", "iters", "usecs/op", "pages");
+
+#if EGG_SECURE_DEFAULT_HARDENING == EGG_SECURE_HARDEN_FAST
+	g_printerr ("bench-ops: skipping hardening variants: the checks are compiled out\n");
+#endif
+
+	for (i = 0; i < G_N_ELEMENTS (BENCH_OPS); i++) {
+		if (BENCH_OPS[i].needs_session && !have_session)
+			continue;
+#if EGG_SECURE_DEFAULT_HARDENING == EGG_SECURE_HARDEN_FAST
+		if (BENCH_OPS[i].hardening != 0)
+			continue;
+#endif
+		bench_run (BENCH_OPS + i, &fixture);
+	}
+
+	if (fixture.encoded)
+		g_variant_unref (fixture.encoded);
+	if (fixture.service) {
+		g_object_unref (fixture.service);
+		secret_service_disconnect ();
+	}
+	mock_service_stop ();
+
+	secret_value_unref (fixture.value);
+	g_variant_unref (fixture.attributes_variant);
+	g_hash_table_unref (fixture.attributes);
+
+	return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2012 Red Hat Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ */
+
+/*
+ * Compares reading search results one SecretItem at a time with reading
+ * them all from secret_service_search_packed(). Both run the same search,
+ * so the difference is the cost of crossing the binding boundary. Set
+ * MOCK_STRESS_ITEMS to change the number of items.
+ */
+
+const Mock = imports.gi.MockService;
+const Secret = imports.gi.SecretUnstable;
+const GLib = imports.gi.GLib;
+
+const ROUNDS = 5;
+const ATTRIBUTES = { "stress": "yes" };
+const FLAGS = Secret.SearchFlags.ALL | Secret.SearchFlags.LOAD_SECRETS;
+
+if (!GLib.getenv("MOCK_STRESS_ITEMS"))
+	GLib.setenv("MOCK_STRESS_ITEMS", "2000", true);
+
+function perItem(service) {
+	var start = GLib.get_monotonic_time();
+	var items = service.search_sync(null, ATTRIBUTES, FLAGS, null);
+	var middle = GLib.get_monotonic_time();
+	var results = [];
+	for (var i = 0; i < items.length; i++) {
+		results.push([items[i].get_object_path(), items[i].get_label(),
+		              items[i].get_attributes(), items[i].get_secret().get()]);
+	}
+	return [results, middle - start, GLib.get_monotonic_time() - middle];
+}
+
+function packed(service) {
+	var start = GLib.get_monotonic_time();
+	var variant = service.search_packed_sync(null, ATTRIBUTES, FLAGS, null);
+	var middle = GLib.get_monotonic_time();
+	var results = variant.deep_unpack();
+	return [results, middle - start, GLib.get_monotonic_time() - middle];
+}
+
+function run(name, func) {
+	var search = 0;
+	var unpack = 0;
+	var count = 0;
+	for (var i = 0; i < ROUNDS; i++) {
+		var service = Secret.Service.get_sync(Secret.ServiceFlags.NONE, null);
+		var ret = func(service);
+		count = ret[0].length;
+		search += ret[1];
+		unpack += ret[2];
+		service = null;
+		Secret.Service.disconnect();
+	}
+	print(name + "\t" + count + "\t" + (search / 1000 / ROUNDS).toFixed(1) +
+	      "\t" + (unpack / 1000 / ROUNDS).toFixed(1));
+}
+
+Mock.start("mock-service-stress.py");
+print("# approach\titems\tsearch-ms\tbindings-ms");
+run("per-item", perItem);
+run("packed", packed);
+Mock.stop();
@@ -0,0 +1,67 @@
+#!/usr/bin/env python
+
+#
+# Copyright 2012 Red Hat Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published
+# by the Free Software Foundation; either version 2.1 of the licence or (at
+# your option) any later version.
+#
+# See the included COPYING file for more information.
+#
+
+#
+# Compares reading search results one SecretItem at a time with reading
+# them all from secret_service_search_packed(). Both run the same search,
+# so the difference is the cost of crossing the binding boundary. Set
+# MOCK_STRESS_ITEMS to change the number of items.
+#
+
+import os
+import time
+
+os.environ.setdefault("MOCK_STRESS_ITEMS", "2000")
+
+from gi.repository import MockService as Mock
+from gi.repository import SecretUnstable
+
+ROUNDS = 5
+ATTRIBUTES = { "stress": "yes" }
+FLAGS = SecretUnstable.SearchFlags.ALL | SecretUnstable.SearchFlags.LOAD_SECRETS
+
+def per_item(service):
+	start = time.time()
+	items = service.search_sync(None, ATTRIBUTES, FLAGS, None)
+	middle = time.time()
+	results = []
+	for item in items:
+		results.append((item.get_object_path(), item.get_label(),
+		                item.get_attributes(), item.get_secret().get()))
+	return (results, middle - start, time.time() - middle)
+
+def packed(service):
+	start = time.time()
+	variant = service.search_packed_sync(None, ATTRIBUTES, FLAGS, None)
+	middle = time.time()
+	results = variant.unpack()
+	return (results, middle - start, time.time() - middle)
+
+def run(name, func):
+	search = 0.0
+	unpack = 0.0
+	for i in range(0, ROUNDS):
+		service = SecretUnstable.Service.get_sync(SecretUnstable.ServiceFlags.NONE, None)
+		(results, searched, unpacked) = func(service)
+		search += searched
+		unpack += unpacked
+		count = len(results)
+		del service
+		SecretUnstable.Service.disconnect()
+	print("%-10s %8d %12.1f %12.1f" % (name, count, search * 1000 / ROUNDS, unpack * 1000 / ROUNDS))
+
+Mock.start("mock-service-stress.py")
+print("# %-8s %8s %12s %12s" % ("approach", "items", "search-ms", "bindings-ms"))
+run("per-item", per_item)
+run("packed", packed)
+Mock.stop()
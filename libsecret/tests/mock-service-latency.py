@@ -0,0 +1,49 @@
+#!/usr/bin/env python
+
+#
+# Copyright 2012 Red Hat Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published
+# by the Free Software Foundation; either version 2.1 of the licence or (at
+# your option) any later version.
+#
+# See the included COPYING file for more information.
+#
+
+import os
+
+# Latencies resembling a real daemon, unless MOCK_FAULTS is set already.
+# See mock/service.py for the format. test-methods runs some of its tests
+# against this, so that replies arrive late and out of order.
+os.environ.setdefault("MOCK_FAULTS", """{
+	"seed": 1,
+	"prompt_delay_ms": 300,
+	"methods": {
+		"*": { "ms": 1, "jitter": 0.5, "distribution": "normal" },
+		"OpenSession": { "ms": 5, "jitter": 2, "distribution": "normal" },
+		"SearchItems": { "ms": 2, "distribution": "exponential" },
+		"GetSecrets": { "ms": 3, "distribution": "exponential",
+		                "stall_probability": 0.002, "stall_ms": 100 },
+		"CreateItem": { "ms": 8, "jitter": 4, "distribution": "normal",
+		                "stall_probability": 0.01, "stall_ms": 200 },
+		"Unlock": { "ms": 10, "jitter": 5, "distribution": "uniform" }
+	}
+}""")
+
+import mock
+
+# Additional items in the default collection
+n_items = int(os.environ.get("MOCK_LATENCY_ITEMS", "0"))
+
+service = mock.SecretService()
+service.add_standard_objects()
+
+collection = service.aliases["default"]
+for i in range(0, n_items):
+	mock.SecretItem(collection, "bulk%d" % i, label="Bulk %d" % i,
+	                secret="secret %d" % i,
+	                attributes={ "number": str(i), "bulk": "yes",
+	                             "xdg:schema": "org.mock.Bulk" })
+
+service.listen()
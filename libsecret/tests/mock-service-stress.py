@@ -0,0 +1,55 @@
+#!/usr/bin/env python
+
+#
+# Copyright 2012 Red Hat Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published
+# by the Free Software Foundation; either version 2.1 of the licence or (at
+# your option) any later version.
+#
+# See the included COPYING file for more information.
+#
+
+import dbus
+import dbus.service
+import mock
+import os
+
+# The number of items and collections are passed in the environment
+n_items = int(os.environ.get("MOCK_STRESS_ITEMS", "100000"))
+n_collections = int(os.environ.get("MOCK_STRESS_COLLECTIONS", "4"))
+
+class StressService(mock.SecretService):
+
+	# Change the label of some items, and send PropertiesChanged for each
+	@dbus.service.method('org.mock.Stress')
+	def Touch(self, count, label):
+		touched = 0
+		for collection in self.collections.values():
+			for item in collection.items.values():
+				if touched >= count:
+					return dbus.UInt32(touched)
+				item.label = label
+				item.PropertiesChanged('org.freedesktop.Secret.Item',
+				                       { "Label": dbus.String(label, variant_level=1) }, [])
+				touched += 1
+		return dbus.UInt32(touched)
+
+service = StressService()
+
+# Pure python AES would dominate all the timings
+service.algorithms = { "plain": mock.PlainAlgorithm() }
+
+collections = []
+for i in range(0, n_collections):
+	collections.append(mock.SecretCollection(service, "stress%d" % i,
+	                                         label="Stress %d" % i, locked=False))
+
+for i in range(0, n_items):
+	mock.SecretItem(collections[i % n_collections], "item%d" % i, label="Item %d" % i,
+	                secret="secret %d" % i,
+	                attributes={ "number": str(i), "stress": "yes",
+	                             "xdg:schema": "org.mock.Stress" })
+
+service.listen()
@@ -21,8 +21,109 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_SYS_PRCTL_H
+#include <sys/prctl.h>
+#endif
 
 static GPid pid = 0;
+static GPid bus_pid = 0;
+static pid_t parent_pid = 0;
+
+static void
+on_child_setup (gpointer user_data)
+{
+#ifdef HAVE_SYS_PRCTL_H
+	/* Don't outlive the test, even when it crashes or is killed */
+	prctl (PR_SET_PDEATHSIG, SIGTERM);
+
+	/* In case the test went away before the above */
+	if (getppid () != parent_pid)
+		_exit (1);
+#endif
+}
+
+static void
+mock_bus_stop (void)
+{
+	if (!bus_pid)
+		return;
+
+	if (kill (bus_pid, SIGTERM) < 0) {
+		if (errno != ESRCH)
+			g_warning ("kill() failed: %s", g_strerror (errno));
+	}
+
+	g_spawn_close_pid (bus_pid);
+	bus_pid = 0;
+}
+
+/*
+ * Each test process gets its own private session bus, so that test
+ * binaries don't fight over the mock service name and can run in
+ * parallel. The bus lives until the process exits, and where supported
+ * is killed along with it, even when the process crashes. Set the
+ * MOCK_SERVICE_SHARED_BUS environment variable to use the session bus
+ * of the environment instead.
+ */
+static gboolean
+mock_bus_start (GError **error)
+{
+	gchar address[1024] = { 0, };
+	GPollFD poll_fd;
+	gsize length = 0;
+	gssize count;
+	gint out_fd;
+	gchar *line;
+
+	gchar *argv[] = {
+		"dbus-daemon", "--session", "--nofork",
+		"--print-address=1",
+		NULL
+	};
+
+	if (bus_pid || g_getenv ("MOCK_SERVICE_SHARED_BUS"))
+		return TRUE;
+
+	parent_pid = getpid ();
+	if (!g_spawn_async_with_pipes (NULL, argv, NULL, G_SPAWN_SEARCH_PATH,
+	                               on_child_setup, NULL, &bus_pid, NULL, &out_fd, NULL, error))
+		return FALSE;
+
+	poll_fd.events = G_IO_IN | G_IO_HUP | G_IO_ERR;
+	poll_fd.fd = out_fd;
+
+	/* Read the first line, which is the address of the bus */
+	while (strchr (address, '\n') == NULL && length < sizeof (address) - 1) {
+		poll_fd.revents = 0;
+		if (g_poll (&poll_fd, 1, 5000) != 1)
+			break;
+		count = read (out_fd, address + length, sizeof (address) - 1 - length);
+		if (count < 0 && errno == EINTR)
+			continue;
+		if (count <= 0)
+			break;
+		length += count;
+	}
+
+	close (out_fd);
+
+	line = strchr (address, '\n');
+	if (line == NULL) {
+		g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		                     "Couldn't read address of private bus for mock service");
+		mock_bus_stop ();
+		return FALSE;
+	}
+
+	line[0] = '\0';
+	g_setenv ("DBUS_SESSION_BUS_ADDRESS", address, TRUE);
+	atexit (mock_bus_stop);
+	return TRUE;
+}
 
 gboolean
 mock_service_start (const gchar *mock_script,
@@ -32,7 +133,9 @@ mock_service_start (const gchar *mock_script,
 	GSpawnFlags flags;
 	int wait_pipe[2];
 	GPollFD poll_fd;
+	const gchar *env;
 	gboolean ret;
+	gint timeout;
 	gint polled;
 
 	gchar *argv[] = {
@@ -47,6 +150,9 @@ mock_service_start (const gchar *mock_script,
 
 	g_setenv ("SECRET_SERVICE_BUS_NAME", MOCK_SERVICE_NAME, TRUE);
 
+	if (!mock_bus_start (error))
+		return FALSE;
+
 	if (pipe (wait_pipe) < 0) {
 		g_set_error_literal (error, G_IO_ERROR, g_io_error_from_errno (errno),
 		                     "Couldn't create pipe for mock service");
@@ -56,7 +162,8 @@ mock_service_start (const gchar *mock_script,
 	snprintf (ready, sizeof (ready), "%d", wait_pipe[1]);
 
 	flags = G_SPAWN_SEARCH_PATH | G_SPAWN_LEAVE_DESCRIPTORS_OPEN;
-	ret = g_spawn_async (SRCDIR, argv, NULL, flags, NULL, NULL, &pid, error);
+	parent_pid = getpid ();
+	ret = g_spawn_async (SRCDIR, argv, NULL, flags, on_child_setup, NULL, &pid, error);
 
 	close (wait_pipe[1]);
 
@@ -65,7 +172,11 @@ mock_service_start (const gchar *mock_script,
 		poll_fd.fd = wait_pipe[0];
 		poll_fd.revents = 0;
 
-		polled = g_poll (&poll_fd, 1, 2000);
+		/* Mock services with lots of objects take a while to start */
+		env = g_getenv ("MOCK_SERVICE_READY_TIMEOUT");
+		timeout = env ? atoi (env) : 2000;
+
+		polled = g_poll (&poll_fd, 1, timeout);
 		if (polled < -1)
 			g_warning ("couldn't poll file descirptor: %s", g_strerror (errno));
 		if (polled != 1)
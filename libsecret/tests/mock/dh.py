@@ -19,6 +19,7 @@
 # http://trevp.net/tlslite/
 #
 
+import binascii
 import math
 import random
 
@@ -46,21 +47,18 @@ def num_bytes(number):
 	bits = num_bits(number)
 	return int(math.ceil(bits / 8.0))
 
+# Conversions go through hex, which is done natively, rather than
+# looping over each byte in python
 def bytes_to_number(data):
-	number = 0L
-	multiplier = 1L
-	for count in range(len(data) - 1, -1, -1):
-		number += multiplier * ord(data[count])
-		multiplier *= 256
-	return number
+	if not data:
+		return 0L
+	return long(binascii.hexlify(data), 16)
 
 def number_to_bytes(number):
 	n_data = num_bytes(number)
-	data = ['' for i in range(0, n_data)]
-	for count in range(n_data - 1, -1, -1):
-		data[count] = chr(number % 256)
-		number >>= 8
-	return "".join(data)
+	if n_data == 0:
+		return ""
+	return binascii.unhexlify("%0*x" % (n_data * 2, number))
 
 def generate_pair():
 	prime = bytes_to_number (PRIME)
@@ -0,0 +1,84 @@
+
+#
+# Copyright 2012 Red Hat Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published
+# by the Free Software Foundation; either version 2 of the licence or (at
+# your option) any later version.
+#
+# See the included COPYING file for more information.
+#
+
+#
+# AES-CBC through libgcrypt, loaded with ctypes. The pure python aes
+# module dominates the time of any test using an AES session, so this is
+# used when available. Set MOCK_PURE_CRYPTO to use the python version.
+#
+
+import ctypes
+import ctypes.util
+import os
+
+GCRYCTL_DISABLE_SECMEM = 37
+GCRYCTL_INITIALIZATION_FINISHED = 38
+GCRY_CIPHER_AES128 = 7
+GCRY_CIPHER_MODE_CBC = 3
+
+def _load():
+	if os.environ.get("MOCK_PURE_CRYPTO"):
+		return None
+	name = ctypes.util.find_library("gcrypt")
+	if not name:
+		return None
+	try:
+		lib = ctypes.CDLL(name)
+	except OSError:
+		return None
+	lib.gcry_check_version.restype = ctypes.c_char_p
+	lib.gcry_check_version.argtypes = [ ctypes.c_char_p ]
+	if not lib.gcry_check_version(None):
+		return None
+	lib.gcry_control(GCRYCTL_DISABLE_SECMEM, 0)
+	lib.gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0)
+	lib.gcry_cipher_open.argtypes = [ ctypes.POINTER(ctypes.c_void_p), ctypes.c_int,
+	                                  ctypes.c_int, ctypes.c_uint ]
+	lib.gcry_cipher_setkey.argtypes = [ ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t ]
+	lib.gcry_cipher_setiv.argtypes = [ ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t ]
+	lib.gcry_cipher_encrypt.argtypes = [ ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t,
+	                                     ctypes.c_char_p, ctypes.c_size_t ]
+	lib.gcry_cipher_decrypt.argtypes = lib.gcry_cipher_encrypt.argtypes
+	lib.gcry_cipher_close.argtypes = [ ctypes.c_void_p ]
+	lib.gcry_cipher_close.restype = None
+	return lib
+
+_gcrypt = _load()
+
+def available():
+	return _gcrypt is not None
+
+def _aes_cbc(key, iv, data, encrypt):
+	handle = ctypes.c_void_p()
+	if _gcrypt.gcry_cipher_open(ctypes.byref(handle), GCRY_CIPHER_AES128,
+	                            GCRY_CIPHER_MODE_CBC, 0) != 0:
+		raise ValueError("couldn't open cipher")
+	try:
+		if _gcrypt.gcry_cipher_setkey(handle, key, len(key)) != 0 or \
+		   _gcrypt.gcry_cipher_setiv(handle, iv, len(iv)) != 0:
+			raise ValueError("invalid key or iv")
+		output = ctypes.create_string_buffer(len(data))
+		if encrypt:
+			ret = _gcrypt.gcry_cipher_encrypt(handle, output, len(data), data, len(data))
+		else:
+			ret = _gcrypt.gcry_cipher_decrypt(handle, output, len(data), data, len(data))
+		if ret != 0:
+			raise ValueError("couldn't process data")
+		return output.raw
+	finally:
+		_gcrypt.gcry_cipher_close(handle)
+
+def aes_cbc_encrypt(key, iv, data):
+	return _aes_cbc(key, iv, data, True)
+
+def aes_cbc_decrypt(key, iv, data):
+	return _aes_cbc(key, iv, data, False)
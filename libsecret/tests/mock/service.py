@@ -11,8 +11,11 @@
 # See the included COPYING file for more information.
 #
 
+import functools
 import getopt
+import json
 import os
+import random
 import sys
 import time
 import unittest
@@ -20,6 +23,7 @@ import unittest
 import aes
 import dh
 import hkdf
+import native
 
 import dbus
 import dbus.service
@@ -32,6 +36,113 @@ bus_name = 'org.freedesktop.Secret.MockService'
 ready_pipe = -1
 objects = { }
 
+# Latency and fault injection, configured with MOCK_FAULTS. It contains
+# JSON, or the path of a file containing JSON, like this:
+#
+# {
+#   "seed": 1,
+#   "prompt_delay_ms": 500,
+#   "methods": {
+#     "*": { "ms": 1, "jitter": 0.5, "distribution": "normal" },
+#     "GetSecrets": { "ms": 4, "distribution": "exponential",
+#                     "stall_probability": 0.01, "stall_ms": 250 },
+#     "SearchItems": { "ms": 2, "jitter": 1, "distribution": "uniform",
+#                      "error_probability": 0.001,
+#                      "error": "org.freedesktop.DBus.Error.NoReply" }
+#   }
+# }
+#
+# Method names are matched without the interface, "*" matches any method
+# not listed. A latency delays the reply to that call without blocking the
+# service, so calls with different latencies complete out of order. A stall
+# blocks the whole service, delaying all pending and later calls. An error
+# is returned instead of calling the method at all. Prompts take a further
+# prompt_delay_ms to complete.
+#
+# The exported methods of the mock classes are wrapped by inject() below,
+# which replies asynchronously. Methods that subclasses in the
+# mock-service-*.py scripts export themselves are left as they are.
+
+class FaultInjector():
+	def __init__(self, config):
+		self.random = random.Random(config.get("seed", None))
+		self.methods = config.get("methods", { })
+		self.prompt_delay_ms = config.get("prompt_delay_ms", 0)
+
+	def method_config(self, member):
+		return self.methods.get(member, self.methods.get("*", None))
+
+	def sample_latency(self, config):
+		ms = config.get("ms", 0)
+		jitter = config.get("jitter", 0)
+		distribution = config.get("distribution", "uniform")
+		if distribution == "exponential":
+			ms = ms and self.random.expovariate(1.0 / ms) or 0
+		elif distribution == "normal":
+			ms = self.random.gauss(ms, jitter)
+		else:
+			ms = self.random.uniform(ms - jitter, ms + jitter)
+		return max(ms, 0)
+
+	def wrap(self, func):
+		config = self.method_config(func.__name__)
+		if not config or func._dbus_async_callbacks:
+			return func
+
+		out_signature = func._dbus_out_signature
+		if out_signature is not None:
+			out_signature = tuple(dbus.Signature(out_signature))
+
+		@functools.wraps(func)
+		def wrapper(obj, *args, **kwargs):
+			reply_handler = kwargs.pop("_fault_reply")
+			error_handler = kwargs.pop("_fault_error")
+
+			if self.random.random() < config.get("stall_probability", 0):
+				time.sleep(config.get("stall_ms", 0) / 1000.0)
+
+			def invoke():
+				if self.random.random() < config.get("error_probability", 0):
+					name = config.get("error", "org.freedesktop.DBus.Error.Failed")
+					error_handler(dbus.exceptions.DBusException("injected error", name=name))
+					return False
+				try:
+					retval = func(obj, *args, **kwargs)
+				except Exception, ex:
+					error_handler(ex)
+					return False
+				# Same as dbus-python does with the return value of a method
+				if retval is None and not out_signature:
+					retval = ()
+				elif not isinstance(retval, tuple) or (out_signature and len(out_signature) == 1):
+					retval = (retval, )
+				reply_handler(*retval)
+				return False
+
+			ms = self.sample_latency(config)
+			if ms <= 0:
+				invoke()
+			else:
+				gobject.timeout_add(int(ms), invoke)
+
+		wrapper._dbus_async_callbacks = ("_fault_reply", "_fault_error")
+		return wrapper
+
+	def inject(self, cls):
+		for name, func in cls.__dict__.items():
+			if getattr(func, "_dbus_is_method", False):
+				setattr(cls, name, self.wrap(func))
+
+def load_faults():
+	config = os.environ.get("MOCK_FAULTS", "")
+	if not config:
+		return None
+	if not config.lstrip().startswith("{"):
+		config = open(config).read()
+	return FaultInjector(json.loads(config))
+
+faults = load_faults()
+
 class NotSupported(dbus.exceptions.DBusException):
 	def __init__(self, msg):
 		dbus.exceptions.DBusException.__init__(self, msg, name="org.freedesktop.DBus.Error.NotSupported")
@@ -97,8 +208,11 @@ class AesAlgorithm():
 		return (dbus.ByteArray(dh.number_to_bytes(publi), variant_level=1), session)
 
 	def encrypt(self, key, data):
-		key = map(ord, key)
 		data = aes.append_PKCS7_padding(data)
+		if native.available():
+			iv = os.urandom(16)
+			return (iv, native.aes_cbc_encrypt(key, iv, data))
+		key = map(ord, key)
 		keysize = len(key)
 		iv = [ord(i) for i in os.urandom(16)]
 		mode = aes.AESModeOfOperation.modeOfOperation["CBC"]
@@ -108,6 +222,9 @@ class AesAlgorithm():
 		        "".join([chr(i) for i in ciph]))
 
 	def decrypt(self, key, param, data):
+		if native.available():
+			data = native.aes_cbc_decrypt(key, str(param[:16]), str(data))
+			return aes.strip_PKCS7_padding(data)
 		key = map(ord, key)
 		keysize = len(key)
 		iv = map(ord, param[:16])
@@ -120,10 +237,13 @@ class AesAlgorithm():
 
 class SecretPrompt(dbus.service.Object):
 	def __init__(self, service, sender, prompt_name=None, delay=0,
-	             dismiss=False, action=None):
+	             dismiss=False, action=None, latency=None):
 		self.sender = sender
 		self.service = service
 		self.delay = 0
+		self.latency = latency
+		if latency is None:
+			self.latency = faults and faults.prompt_delay_ms / 1000.0 or 0
 		self.dismiss = False
 		self.result = dbus.String("", variant_level=1)
 		self.action = action
@@ -148,7 +268,7 @@ class SecretPrompt(dbus.service.Object):
 	def Prompt(self, window_id):
 		if self.action:
 			self.result = self.action()
-		gobject.timeout_add(self.delay * 1000, self._complete)
+		gobject.timeout_add(int((self.delay + self.latency) * 1000), self._complete)
 
 	@dbus.service.method('org.freedesktop.Secret.Prompt')
 	def Dismiss(self):
@@ -695,6 +815,10 @@ class SecretService(dbus.service.Object):
 		raise InvalidArgs('Not a writable property %s' % property_name)
 
 
+if faults:
+	for cls in (SecretPrompt, SecretSession, SecretItem, SecretCollection, SecretService):
+		faults.inject(cls)
+
 def parse_options(args):
 	global bus_name, ready_pipe
 	try:
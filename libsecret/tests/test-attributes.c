@@ -177,6 +177,111 @@ test_validate_libgnomekeyring (void)
 	g_hash_table_unref (attributes);
 }
 
+static void
+test_set_equal (void)
+{
+	SecretAttributeSet *set;
+	SecretAttributeSet *other;
+	GHashTable *attributes;
+	GVariant *variant;
+
+	attributes = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_replace (attributes, "number", "1");
+	g_hash_table_replace (attributes, "string", "test");
+	g_hash_table_replace (attributes, "xdg:schema", "replaced.Schema");
+
+	set = _secret_attribute_set_new (attributes, "org.mock.Schema");
+	g_assert_cmpuint (_secret_attribute_set_size (set), ==, 3);
+	g_assert_cmpstr (_secret_attribute_set_lookup (set, "string"), ==, "test");
+	g_assert_cmpstr (_secret_attribute_set_lookup (set, "xdg:schema"), ==, "org.mock.Schema");
+	g_assert (_secret_attribute_set_lookup (set, "missing") == NULL);
+
+	/* Same attributes in another order, with a repeated name */
+	variant = g_variant_new_parsed ("{'xdg:schema': 'org.mock.Schema', 'string': 'old',"
+	                                " 'number': '1', 'string': 'test'}");
+	other = _secret_attribute_set_new_for_variant (variant);
+	g_assert (_secret_attribute_set_equal (set, other));
+	g_assert (_secret_attribute_set_equal (other, set));
+	g_assert_cmpuint (_secret_attribute_set_hash (set), ==, _secret_attribute_set_hash (other));
+	_secret_attribute_set_unref (other);
+
+	variant = g_variant_new_parsed ("{'xdg:schema': 'org.mock.Schema', 'string': 'other',"
+	                                " 'number': '1'}");
+	other = _secret_attribute_set_new_for_variant (variant);
+	g_assert (!_secret_attribute_set_equal (set, other));
+	_secret_attribute_set_unref (other);
+
+	_secret_attribute_set_unref (set);
+	g_hash_table_unref (attributes);
+}
+
+static void
+test_set_subset (void)
+{
+	SecretAttributeSet *set;
+	SecretAttributeSet *query;
+	GVariant *variant;
+
+	variant = g_variant_new_parsed ("{'one': '1', 'two': '2', 'three': '3'}");
+	set = _secret_attribute_set_new_for_variant (variant);
+
+	variant = g_variant_new_parsed ("{'two': '2', 'one': '1'}");
+	query = _secret_attribute_set_new_for_variant (variant);
+	g_assert (_secret_attribute_set_subset (query, set));
+	g_assert (!_secret_attribute_set_subset (set, query));
+	_secret_attribute_set_unref (query);
+
+	variant = g_variant_new_parsed ("{'two': '2', 'four': '4'}");
+	query = _secret_attribute_set_new_for_variant (variant);
+	g_assert (!_secret_attribute_set_subset (query, set));
+	_secret_attribute_set_unref (query);
+
+	variant = g_variant_new_parsed ("{'three': 'three'}");
+	query = _secret_attribute_set_new_for_variant (variant);
+	g_assert (!_secret_attribute_set_subset (query, set));
+	_secret_attribute_set_unref (query);
+
+	variant = g_variant_new_parsed ("@a{ss} {}");
+	query = _secret_attribute_set_new_for_variant (variant);
+	g_assert (_secret_attribute_set_subset (query, set));
+	_secret_attribute_set_unref (query);
+
+	_secret_attribute_set_unref (set);
+}
+
+static void
+test_set_convert (void)
+{
+	SecretAttributeSet *set;
+	GHashTable *attributes;
+	GVariant *variant;
+	GVariant *result;
+
+	variant = g_variant_new_parsed ("{'one': '1', 'two': '2'}");
+	g_variant_ref_sink (variant);
+	set = _secret_attribute_set_new_for_variant (variant);
+
+	/* The variant is handed back, not rebuilt */
+	result = _secret_attribute_set_to_variant (set);
+	g_assert (result == variant);
+	g_variant_unref (result);
+
+	attributes = _secret_attribute_set_to_table (set);
+	g_assert_cmpuint (g_hash_table_size (attributes), ==, 2);
+	g_assert_cmpstr (g_hash_table_lookup (attributes, "two"), ==, "2");
+	_secret_attribute_set_unref (set);
+
+	set = _secret_attribute_set_new (attributes, NULL);
+	result = _secret_attribute_set_to_variant (set);
+	g_assert (g_variant_is_of_type (result, G_VARIANT_TYPE ("a{ss}")));
+	g_assert_cmpuint (g_variant_n_children (result), ==, 2);
+	g_variant_unref (result);
+	_secret_attribute_set_unref (set);
+
+	g_hash_table_unref (attributes);
+	g_variant_unref (variant);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -196,5 +301,9 @@ main (int argc, char **argv)
 	g_test_add_func ("/attributes/validate-schema-bad", test_validate_schema_bad);
 	g_test_add_func ("/attributes/validate-libgnomekeyring", test_validate_libgnomekeyring);
 
+	g_test_add_func ("/attributes/set-equal", test_set_equal);
+	g_test_add_func ("/attributes/set-subset", test_set_subset);
+	g_test_add_func ("/attributes/set-convert", test_set_convert);
+
 	return g_test_run ();
 }
@@ -138,6 +138,56 @@ test_new_async (Test *test,
 	g_assert (collection == NULL);
 }
 
+static void
+test_new_default_service (Test *test,
+                          gconstpointer unused)
+{
+	const gchar *collection_path = "/org/freedesktop/secrets/collection/english";
+	GDBusProxy *proxy = G_DBUS_PROXY (test->service);
+	SecretCollection *collection;
+	SecretService *service;
+	GAsyncResult *result = NULL;
+	GError *error = NULL;
+	GObject *source;
+
+	/* Without a service, the default one already resolved in setup() is used */
+	collection = g_initable_new (SECRET_TYPE_COLLECTION, NULL, &error,
+	                             "g-flags", G_DBUS_PROXY_FLAGS_NONE,
+	                             "g-name", g_dbus_proxy_get_name (proxy),
+	                             "g-connection", g_dbus_proxy_get_connection (proxy),
+	                             "g-object-path", collection_path,
+	                             "g-interface-name", SECRET_COLLECTION_INTERFACE,
+	                             NULL);
+	g_assert_no_error (error);
+
+	service = secret_collection_get_service (collection);
+	g_assert (service == test->service);
+	g_object_unref (collection);
+
+	g_async_initable_new_async (SECRET_TYPE_COLLECTION, G_PRIORITY_DEFAULT, NULL,
+	                            on_async_result, &result,
+	                            "g-flags", G_DBUS_PROXY_FLAGS_NONE,
+	                            "g-name", g_dbus_proxy_get_name (proxy),
+	                            "g-connection", g_dbus_proxy_get_connection (proxy),
+	                            "g-object-path", collection_path,
+	                            "g-interface-name", SECRET_COLLECTION_INTERFACE,
+	                            NULL);
+	g_assert (result == NULL);
+
+	egg_test_wait ();
+
+	source = g_async_result_get_source_object (result);
+	collection = SECRET_COLLECTION (g_async_initable_new_finish (G_ASYNC_INITABLE (source),
+	                                                             result, &error));
+	g_assert_no_error (error);
+	g_object_unref (source);
+	g_object_unref (result);
+
+	service = secret_collection_get_service (collection);
+	g_assert (service == test->service);
+	g_object_unref (collection);
+}
+
 static void
 test_new_sync_noexist (Test *test,
                        gconstpointer unused)
@@ -998,6 +1048,7 @@ main (int argc, char **argv)
 
 	g_test_add ("/collection/new-sync", Test, "mock-service-normal.py", setup, test_new_sync, teardown);
 	g_test_add ("/collection/new-async", Test, "mock-service-normal.py", setup, test_new_async, teardown);
+	g_test_add ("/collection/new-default-service", Test, "mock-service-normal.py", setup, test_new_default_service, teardown);
 	g_test_add ("/collection/new-sync-noexist", Test, "mock-service-normal.py", setup, test_new_sync_noexist, teardown);
 	g_test_add ("/collection/new-async-noexist", Test, "mock-service-normal.py", setup, test_new_async_noexist, teardown);
 	g_test_add ("/collection/for-alias-sync", Test, "mock-service-normal.py", setup, test_for_alias_sync, teardown);
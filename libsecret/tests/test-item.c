@@ -176,6 +176,7 @@ test_create_sync (Test *test,
 	SecretCollection *collection;
 	GError *error = NULL;
 	SecretItem *item;
+	SecretItem *other;
 	GHashTable *attributes;
 	SecretValue *value;
 
@@ -200,8 +201,26 @@ test_create_sync (Test *test,
 	secret_value_unref (value);
 
 	g_assert (g_str_has_prefix (g_dbus_proxy_get_object_path (G_DBUS_PROXY (item)), collection_path));
+
+	/* Seeded from what was sent */
 	g_assert_cmpstr (secret_item_get_label (item), ==, "Tunnel");
+	attributes = secret_item_get_attributes (item);
+	g_assert_cmpstr (g_hash_table_lookup (attributes, "string"), ==, "ten");
+	g_hash_table_unref (attributes);
+	value = secret_item_get_secret (item);
+	g_assert (value != NULL);
+	g_assert_cmpstr (secret_value_get (value, NULL), ==, "Hoohah");
+	secret_value_unref (value);
+
+	/* What only the service knows was loaded before it was returned */
 	g_assert (secret_item_get_locked (item) == FALSE);
+	other = secret_item_new_for_dbus_path_sync (test->service,
+	                                            g_dbus_proxy_get_object_path (G_DBUS_PROXY (item)),
+	                                            SECRET_ITEM_NONE, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpuint (secret_item_get_created (item), ==, secret_item_get_created (other));
+	g_assert_cmpuint (secret_item_get_modified (item), ==, secret_item_get_modified (other));
+	g_object_unref (other);
 
 	g_object_unref (item);
 	g_assert (item == NULL);
@@ -216,8 +235,11 @@ test_create_async (Test *test,
 	GAsyncResult *result = NULL;
 	GError *error = NULL;
 	SecretItem *item;
+	SecretItem *other;
 	GHashTable *attributes;
 	SecretValue *value;
+	guint sigs = 1;
+	gchar *label;
 
 	collection = secret_collection_new_for_dbus_path_sync (test->service, collection_path,
 	                                                       SECRET_COLLECTION_NONE, NULL, &error);
@@ -248,6 +270,23 @@ test_create_async (Test *test,
 	g_assert (g_str_has_prefix (g_dbus_proxy_get_object_path (G_DBUS_PROXY (item)), collection_path));
 	g_assert_cmpstr (secret_item_get_label (item), ==, "Tunnel");
 	g_assert (secret_item_get_locked (item) == FALSE);
+	g_assert_cmpuint (secret_item_get_created (item), <=, time (NULL));
+
+	/* Follows changes made elsewhere */
+	other = secret_item_new_for_dbus_path_sync (test->service,
+	                                            g_dbus_proxy_get_object_path (G_DBUS_PROXY (item)),
+	                                            SECRET_ITEM_NONE, NULL, &error);
+	g_assert_no_error (error);
+	g_signal_connect (item, "notify::label", G_CALLBACK (on_notify_stop), &sigs);
+	secret_item_set_label_sync (other, "Another label", NULL, &error);
+	g_assert_no_error (error);
+	g_object_unref (other);
+
+	egg_test_wait ();
+
+	label = secret_item_get_label (item);
+	g_assert_cmpstr (label, ==, "Another label");
+	g_free (label);
 
 	g_object_unref (item);
 	g_assert (item == NULL);
@@ -341,6 +380,104 @@ test_set_label_sync (Test *test,
 	g_object_unref (item);
 }
 
+static void
+on_notify_count (GObject *obj,
+                 GParamSpec *spec,
+                 gpointer user_data)
+{
+	guint *count = user_data;
+	(*count)++;
+}
+
+static void
+test_update_sync (Test *test,
+                  gconstpointer unused)
+{
+	const gchar *item_path = "/org/freedesktop/secrets/collection/english/1";
+	GError *error = NULL;
+	GHashTable *attributes;
+	SecretValue *value;
+	SecretItem *item;
+	guint notifies = 0;
+	gboolean ret;
+	gchar *label;
+
+	item = secret_item_new_for_dbus_path_sync (test->service, item_path, SECRET_ITEM_NONE, NULL, &error);
+	g_assert_no_error (error);
+
+	attributes = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_insert (attributes, "string", "five");
+	g_hash_table_insert (attributes, "number", "5");
+	value = secret_value_new ("Sinking", -1, "text/plain");
+
+	g_signal_connect (item, "notify", G_CALLBACK (on_notify_count), &notifies);
+
+	ret = secret_item_update_sync (item, "Another label", &MOCK_SCHEMA, attributes, value, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+
+	g_hash_table_unref (attributes);
+	secret_value_unref (value);
+
+	/* Label, attributes and flags, notified once each */
+	g_assert_cmpuint (notifies, ==, 3);
+
+	label = secret_item_get_label (item);
+	g_assert_cmpstr (label, ==, "Another label");
+	g_free (label);
+
+	attributes = secret_item_get_attributes (item);
+	g_assert_cmpstr (g_hash_table_lookup (attributes, "string"), ==, "five");
+	g_assert_cmpstr (g_hash_table_lookup (attributes, "xdg:schema"), ==, "org.mock.Schema.Item");
+	g_hash_table_unref (attributes);
+
+	value = secret_item_get_secret (item);
+	g_assert (value != NULL);
+	g_assert_cmpstr (secret_value_get (value, NULL), ==, "Sinking");
+	secret_value_unref (value);
+
+	/* Check that it actually reached the service */
+	secret_item_load_secret_sync (item, NULL, &error);
+	g_assert_no_error (error);
+	value = secret_item_get_secret (item);
+	g_assert_cmpstr (secret_value_get (value, NULL), ==, "Sinking");
+	secret_value_unref (value);
+
+	g_object_unref (item);
+}
+
+static void
+test_update_async (Test *test,
+                   gconstpointer unused)
+{
+	const gchar *item_path = "/org/freedesktop/secrets/collection/english/1";
+	GAsyncResult *result = NULL;
+	GError *error = NULL;
+	SecretItem *item;
+	gboolean ret;
+	gchar *label;
+
+	item = secret_item_new_for_dbus_path_sync (test->service, item_path, SECRET_ITEM_NONE, NULL, &error);
+	g_assert_no_error (error);
+
+	/* Only the label */
+	secret_item_update (item, "Another label", NULL, NULL, NULL, NULL, on_async_result, &result);
+	g_assert (result == NULL);
+
+	egg_test_wait ();
+
+	ret = secret_item_update_finish (item, result, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_object_unref (result);
+
+	label = secret_item_get_label (item);
+	g_assert_cmpstr (label, ==, "Another label");
+	g_free (label);
+
+	g_object_unref (item);
+}
+
 static void
 test_set_label_async (Test *test,
                       gconstpointer unused)
@@ -857,6 +994,8 @@ main (int argc, char **argv)
 	g_test_add ("/item/set-label-sync", Test, "mock-service-normal.py", setup, test_set_label_sync, teardown);
 	g_test_add ("/item/set-label-async", Test, "mock-service-normal.py", setup, test_set_label_async, teardown);
 	g_test_add ("/item/set-label-prop", Test, "mock-service-normal.py", setup, test_set_label_prop, teardown);
+	g_test_add ("/item/update-sync", Test, "mock-service-normal.py", setup, test_update_sync, teardown);
+	g_test_add ("/item/update-async", Test, "mock-service-normal.py", setup, test_update_async, teardown);
 	g_test_add ("/item/set-attributes-sync", Test, "mock-service-normal.py", setup, test_set_attributes_sync, teardown);
 	g_test_add ("/item/set-attributes-async", Test, "mock-service-normal.py", setup, test_set_attributes_async, teardown);
 	g_test_add ("/item/set-attributes-prop", Test, "mock-service-normal.py", setup, test_set_attributes_prop, teardown);
@@ -28,6 +28,7 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 static const SecretSchema MOCK_SCHEMA = {
 	"org.mock.Schema",
@@ -274,6 +275,44 @@ test_search_unlock_sync (Test *test,
 	g_list_free_full (items, g_object_unref);
 }
 
+static void
+test_search_unlock_secrets_sync (Test *test,
+                                 gconstpointer used)
+{
+	GHashTable *attributes;
+	GError *error = NULL;
+	SecretValue *value;
+	GList *items;
+
+	attributes = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_insert (attributes, "number", "1");
+
+	/* Secrets are loaded both for unlocked items, and the items just unlocked */
+	items = secret_service_search_sync (test->service, &MOCK_SCHEMA, attributes,
+	                                    SECRET_SEARCH_ALL | SECRET_SEARCH_UNLOCK | SECRET_SEARCH_LOAD_SECRETS,
+	                                    NULL, &error);
+	g_assert_no_error (error);
+	g_hash_table_unref (attributes);
+
+	g_assert (items != NULL);
+	g_assert_cmpstr (g_dbus_proxy_get_object_path (items->data), ==, "/org/freedesktop/secrets/collection/english/1");
+	value = secret_item_get_secret (items->data);
+	g_assert (value != NULL);
+	g_assert_cmpstr (secret_value_get_text (value), ==, "111");
+	secret_value_unref (value);
+
+	g_assert (items->next != NULL);
+	g_assert_cmpstr (g_dbus_proxy_get_object_path (items->next->data), ==, "/org/freedesktop/secrets/collection/spanish/10");
+	g_assert (secret_item_get_locked (items->next->data) == FALSE);
+	value = secret_item_get_secret (items->next->data);
+	g_assert (value != NULL);
+	g_assert_cmpstr (secret_value_get_text (value), ==, "111");
+	secret_value_unref (value);
+
+	g_assert (items->next->next == NULL);
+	g_list_free_full (items, g_object_unref);
+}
+
 static void
 test_search_unlock_async (Test *test,
                           gconstpointer used)
@@ -389,6 +428,186 @@ test_search_secrets_async (Test *test,
 	g_list_free_full (items, g_object_unref);
 }
 
+static GList *
+load_search_collections (Test *test)
+{
+	GList *collections = NULL;
+	SecretCollection *collection;
+	GError *error = NULL;
+
+	/* The english collection is listed twice, its items should only appear once */
+	collection = secret_collection_new_for_dbus_path_sync (test->service, "/org/freedesktop/secrets/collection/english",
+	                                                       SECRET_COLLECTION_NONE, NULL, &error);
+	g_assert_no_error (error);
+	collections = g_list_append (collections, collection);
+	collections = g_list_append (collections, g_object_ref (collection));
+
+	collection = secret_collection_new_for_dbus_path_sync (test->service, "/org/freedesktop/secrets/collection/spanish",
+	                                                       SECRET_COLLECTION_NONE, NULL, &error);
+	g_assert_no_error (error);
+	collections = g_list_prepend (collections, collection);
+
+	return collections;
+}
+
+static void
+test_search_collections_sync (Test *test,
+                              gconstpointer used)
+{
+	GHashTable *attributes;
+	GList *collections;
+	GError *error = NULL;
+	GList *items;
+
+	collections = load_search_collections (test);
+
+	attributes = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_insert (attributes, "number", "1");
+
+	items = secret_service_search_collections_sync (test->service, collections, &MOCK_SCHEMA, attributes,
+	                                                SECRET_SEARCH_ALL, NULL, &error);
+	g_assert_no_error (error);
+	g_hash_table_unref (attributes);
+	g_list_free_full (collections, g_object_unref);
+
+	/* Unlocked items come first, whatever the order of the collections */
+	g_assert (items != NULL);
+	g_assert_cmpstr (g_dbus_proxy_get_object_path (items->data), ==, "/org/freedesktop/secrets/collection/english/1");
+	g_assert (secret_item_get_locked (items->data) == FALSE);
+
+	g_assert (items->next != NULL);
+	g_assert_cmpstr (g_dbus_proxy_get_object_path (items->next->data), ==, "/org/freedesktop/secrets/collection/spanish/10");
+	g_assert (secret_item_get_locked (items->next->data) == TRUE);
+
+	g_assert (items->next->next == NULL);
+	g_list_free_full (items, g_object_unref);
+}
+
+static void
+test_search_collections_async (Test *test,
+                               gconstpointer used)
+{
+	GAsyncResult *result = NULL;
+	GHashTable *attributes;
+	GList *collections;
+	GError *error = NULL;
+	GList *items;
+
+	collections = load_search_collections (test);
+
+	attributes = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_insert (attributes, "number", "1");
+
+	secret_service_search_collections (test->service, collections, &MOCK_SCHEMA, attributes,
+	                                   SECRET_SEARCH_ALL | SECRET_SEARCH_LOAD_SECRETS, NULL,
+	                                   on_complete_get_result, &result);
+	g_hash_table_unref (attributes);
+	g_list_free_full (collections, g_object_unref);
+	g_assert (result == NULL);
+
+	egg_test_wait ();
+
+	g_assert (G_IS_ASYNC_RESULT (result));
+	items = secret_service_search_collections_finish (test->service, result, &error);
+	g_assert_no_error (error);
+	g_object_unref (result);
+
+	g_assert (items != NULL);
+	g_assert_cmpstr (g_dbus_proxy_get_object_path (items->data), ==, "/org/freedesktop/secrets/collection/english/1");
+	g_assert (secret_item_get_secret (items->data) != NULL);
+
+	g_assert (items->next != NULL);
+	g_assert_cmpstr (g_dbus_proxy_get_object_path (items->next->data), ==, "/org/freedesktop/secrets/collection/spanish/10");
+	g_assert (secret_item_get_secret (items->next->data) == NULL);
+
+	g_assert (items->next->next == NULL);
+	g_list_free_full (items, g_object_unref);
+}
+
+static void
+test_search_packed_sync (Test *test,
+                         gconstpointer used)
+{
+	GHashTable *attributes;
+	GError *error = NULL;
+	GVariant *packed;
+	GVariant *entry;
+	GVariant *attrs;
+	GVariant *secret;
+	const gchar *path;
+	const gchar *label;
+	const gchar *value;
+	gsize length;
+
+	attributes = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_insert (attributes, "number", "1");
+
+	packed = secret_service_search_packed_sync (test->service, &MOCK_SCHEMA, attributes,
+	                                            SECRET_SEARCH_ALL | SECRET_SEARCH_LOAD_SECRETS,
+	                                            NULL, &error);
+	g_assert_no_error (error);
+	g_hash_table_unref (attributes);
+
+	g_assert_cmpstr (g_variant_get_type_string (packed), ==, "a(osa{ss}ays)");
+	g_assert_cmpuint (g_variant_n_children (packed), ==, 2);
+
+	entry = g_variant_get_child_value (packed, 0);
+	g_variant_get (entry, "(&o&s@a{ss}@ays)", &path, &label, &attrs, &secret, NULL);
+	g_assert_cmpstr (path, ==, "/org/freedesktop/secrets/collection/english/1");
+	g_assert_cmpstr (label, ==, "Item One");
+	g_assert (g_variant_lookup (attrs, "string", "&s", &value));
+	g_assert_cmpstr (value, ==, "one");
+	value = g_variant_get_fixed_array (secret, &length, 1);
+	g_assert_cmpuint (length, ==, 3);
+	g_assert (memcmp (value, "111", 3) == 0);
+	g_variant_unref (attrs);
+	g_variant_unref (secret);
+	g_variant_unref (entry);
+
+	/* Locked item, no secret */
+	entry = g_variant_get_child_value (packed, 1);
+	g_variant_get (entry, "(&o&s@a{ss}@ays)", &path, NULL, NULL, &secret, NULL);
+	g_assert_cmpstr (path, ==, "/org/freedesktop/secrets/collection/spanish/10");
+	g_assert_cmpuint (g_variant_n_children (secret), ==, 0);
+	g_variant_unref (secret);
+	g_variant_unref (entry);
+
+	g_variant_unref (packed);
+}
+
+static void
+test_search_packed_async (Test *test,
+                          gconstpointer used)
+{
+	GAsyncResult *result = NULL;
+	GHashTable *attributes;
+	GError *error = NULL;
+	GVariant *packed;
+	const gchar *path;
+
+	attributes = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_insert (attributes, "number", "1");
+
+	secret_service_search_packed (test->service, &MOCK_SCHEMA, attributes,
+	                              SECRET_SEARCH_NONE, NULL,
+	                              on_complete_get_result, &result);
+	g_hash_table_unref (attributes);
+	g_assert (result == NULL);
+
+	egg_test_wait ();
+
+	g_assert (G_IS_ASYNC_RESULT (result));
+	packed = secret_service_search_packed_finish (test->service, result, &error);
+	g_assert_no_error (error);
+	g_object_unref (result);
+
+	g_assert_cmpuint (g_variant_n_children (packed), ==, 1);
+	g_variant_get_child (packed, 0, "(&osa{ss}ays)", &path, NULL, NULL, NULL, NULL);
+	g_assert_cmpstr (path, ==, "/org/freedesktop/secrets/collection/english/1");
+
+	g_variant_unref (packed);
+}
+
 static void
 test_lock_sync (Test *test,
                 gconstpointer used)
@@ -501,6 +720,42 @@ test_clear_async (Test *test,
 	g_object_unref (result);
 }
 
+static void
+test_clear_all_matching (Test *test,
+                         gconstpointer used)
+{
+	GError *error = NULL;
+	GAsyncResult *result = NULL;
+	GHashTable *attributes;
+	SecretValue *value;
+	gboolean ret;
+
+	/* Deletes every unlocked item that matches */
+	attributes = secret_attributes_build (&MOCK_SCHEMA,
+	                                      "even", FALSE,
+	                                      "string", "one",
+	                                      "number", 1,
+	                                      NULL);
+
+	secret_service_clear (test->service, &MOCK_SCHEMA, attributes, NULL,
+	                      on_complete_get_result, &result);
+	g_assert (result == NULL);
+
+	egg_test_wait ();
+
+	ret = secret_service_clear_finish (test->service, result, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_object_unref (result);
+
+	/* None of them are left */
+	value = secret_service_lookup_sync (test->service, &MOCK_SCHEMA, attributes, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (value == NULL);
+
+	g_hash_table_unref (attributes);
+}
+
 static void
 test_clear_locked (Test *test,
                    gconstpointer used)
@@ -663,6 +918,42 @@ test_lookup_locked (Test *test,
 	secret_value_unref (value);
 }
 
+static void
+test_lookup_locked_async (Test *test,
+                          gconstpointer used)
+{
+	GError *error = NULL;
+	GHashTable *attributes;
+	GAsyncResult *result = NULL;
+	SecretValue *value;
+	gsize length;
+
+	attributes = secret_attributes_build (&MOCK_SCHEMA,
+	                                      "even", FALSE,
+	                                      "string", "tres",
+	                                      "number", 3,
+	                                      NULL);
+
+	/* Only matches a locked item, which is unlocked before its secret is read */
+	secret_service_lookup (test->service, &MOCK_SCHEMA, attributes, NULL,
+	                        on_complete_get_result, &result);
+
+	g_assert (result == NULL);
+	g_hash_table_unref (attributes);
+
+	egg_test_wait ();
+
+	value = secret_service_lookup_finish (test->service, result, &error);
+	g_assert_no_error (error);
+
+	g_assert (value != NULL);
+	g_assert_cmpstr (secret_value_get (value, &length), ==, "3333");
+	g_assert_cmpuint (length, ==, 4);
+
+	secret_value_unref (value);
+	g_object_unref (result);
+}
+
 static void
 test_lookup_no_match (Test *test,
                       gconstpointer used)
@@ -765,6 +1056,238 @@ test_store_sync (Test *test,
 	g_strfreev (paths);
 }
 
+static GDBusMessage *
+on_count_create_item (GDBusConnection *connection,
+                      GDBusMessage *message,
+                      gboolean incoming,
+                      gpointer user_data)
+{
+	guint *count = user_data;
+
+	if (!incoming &&
+	    g_dbus_message_get_message_type (message) == G_DBUS_MESSAGE_TYPE_METHOD_CALL &&
+	    g_strcmp0 (g_dbus_message_get_member (message), "CreateItem") == 0)
+		g_atomic_int_inc (count);
+
+	return message;
+}
+
+static void
+test_store_known_locked (Test *test,
+                         gconstpointer used)
+{
+	const gchar *collection_path = "/org/freedesktop/secrets/collection/spanish";
+	const gchar *paths[] = { collection_path, NULL };
+	SecretValue *value = secret_value_new ("apassword", -1, "text/plain");
+	GDBusConnection *connection;
+	GHashTable *attributes;
+	GError *error = NULL;
+	guint count = 0;
+	gboolean ret;
+	guint filter;
+
+	connection = g_dbus_proxy_get_connection (G_DBUS_PROXY (test->service));
+	filter = g_dbus_connection_add_filter (connection, on_count_create_item, &count, NULL);
+
+	attributes = secret_attributes_build (&MOCK_SCHEMA,
+	                                      "even", FALSE,
+	                                      "string", "seventeen",
+	                                      "number", 17,
+	                                      NULL);
+
+	/* Not known to be locked, so CreateItem fails first and is retried */
+	ret = secret_service_store_sync (test->service, &MOCK_SCHEMA, attributes, collection_path,
+	                                 "New Item Label", value, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_assert_cmpuint (g_atomic_int_get (&count), ==, 2);
+
+	ret = secret_service_lock_dbus_paths_sync (test->service, paths, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	/* Now known to be locked, so it is unlocked before CreateItem */
+	g_atomic_int_set (&count, 0);
+	ret = secret_service_store_sync (test->service, &MOCK_SCHEMA, attributes, collection_path,
+	                                 "New Item Label", value, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_assert_cmpuint (g_atomic_int_get (&count), ==, 1);
+
+	g_dbus_connection_remove_filter (connection, filter);
+	secret_value_unref (value);
+	g_hash_table_unref (attributes);
+}
+
+static GDBusMessage *
+on_count_unlock (GDBusConnection *connection,
+                 GDBusMessage *message,
+                 gboolean incoming,
+                 gpointer user_data)
+{
+	guint *count = user_data;
+
+	if (!incoming &&
+	    g_dbus_message_get_message_type (message) == G_DBUS_MESSAGE_TYPE_METHOD_CALL &&
+	    g_strcmp0 (g_dbus_message_get_member (message), "Unlock") == 0)
+		g_atomic_int_inc (count);
+
+	return message;
+}
+
+static void
+test_store_alias_unlocked (Test *test,
+                           gconstpointer used)
+{
+	const gchar *paths[] = { "/org/freedesktop/secrets/collection/english", NULL };
+	SecretValue *value = secret_value_new ("apassword", -1, "text/plain");
+	GDBusConnection *connection;
+	GHashTable *attributes;
+	GError *error = NULL;
+	guint count = 0;
+	gboolean ret;
+	guint filter;
+
+	connection = g_dbus_proxy_get_connection (G_DBUS_PROXY (test->service));
+	filter = g_dbus_connection_add_filter (connection, on_count_unlock, &count, NULL);
+
+	attributes = secret_attributes_build (&MOCK_SCHEMA,
+	                                      "even", FALSE,
+	                                      "string", "seventeen",
+	                                      "number", 17,
+	                                      NULL);
+
+	/* The default alias points to this collection */
+	ret = secret_service_lock_dbus_paths_sync (test->service, paths, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	ret = secret_service_store_sync (test->service, &MOCK_SCHEMA, attributes, SECRET_COLLECTION_DEFAULT,
+	                                 "New Item Label", value, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_assert_cmpuint (g_atomic_int_get (&count), ==, 1);
+
+	ret = secret_service_unlock_dbus_paths_sync (test->service, paths, NULL, NULL, &error);
+	g_assert_no_error (error);
+
+	/* Unlocked through its own path, so the alias isn't unlocked again */
+	g_atomic_int_set (&count, 0);
+	ret = secret_service_store_sync (test->service, &MOCK_SCHEMA, attributes, SECRET_COLLECTION_DEFAULT,
+	                                 "New Item Label", value, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_assert_cmpuint (g_atomic_int_get (&count), ==, 0);
+
+	g_dbus_connection_remove_filter (connection, filter);
+	secret_value_unref (value);
+	g_hash_table_unref (attributes);
+}
+
+static void
+test_store_if_changed (Test *test,
+                       gconstpointer used)
+{
+	const gchar *collection_path = "/org/freedesktop/secrets/collection/english";
+	SecretValue *value = secret_value_new ("apassword", -1, "text/plain");
+	GHashTable *attributes;
+	GError *error = NULL;
+	gboolean written;
+	guint skipped;
+	gboolean ret;
+
+	attributes = secret_attributes_build (&MOCK_SCHEMA,
+	                                      "even", FALSE,
+	                                      "string", "seventeen",
+	                                      "number", 17,
+	                                      NULL);
+
+	ret = secret_service_store_if_changed_sync (test->service, &MOCK_SCHEMA, attributes, collection_path,
+	                                            "New Item Label", value, &written, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_assert (written == TRUE);
+
+	/* Same again, nothing written */
+	ret = secret_service_store_if_changed_sync (test->service, &MOCK_SCHEMA, attributes, collection_path,
+	                                            "New Item Label", value, &written, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_assert (written == FALSE);
+
+	/* Different label */
+	ret = secret_service_store_if_changed_sync (test->service, &MOCK_SCHEMA, attributes, collection_path,
+	                                            "Another Label", value, &written, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (written == TRUE);
+	secret_value_unref (value);
+
+	/* Different secret */
+	value = secret_value_new ("other", -1, "text/plain");
+	ret = secret_service_store_if_changed_sync (test->service, &MOCK_SCHEMA, attributes, collection_path,
+	                                            "Another Label", value, &written, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (written == TRUE);
+	secret_value_unref (value);
+
+	g_hash_table_unref (attributes);
+
+	secret_service_get_store_counts (test->service, NULL, &skipped);
+	g_assert_cmpuint (skipped, ==, 1);
+}
+
+static void
+test_store_all_if_changed (Test *test,
+                           gconstpointer used)
+{
+	GHashTable *attributes[3];
+	const gchar *labels[3] = { "One", "Two", "Three" };
+	SecretValue *values[3];
+	GAsyncResult *result = NULL;
+	GError *error = NULL;
+	guint written;
+	guint skipped;
+	gboolean ret;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (values); i++) {
+		attributes[i] = secret_attributes_build (&MOCK_SCHEMA,
+		                                         "string", "bulk",
+		                                         "number", 100 + i,
+		                                         NULL);
+		values[i] = secret_value_new (labels[i], -1, "text/plain");
+	}
+
+	ret = secret_service_store_all_if_changed_sync (test->service, &MOCK_SCHEMA, NULL,
+	                                                attributes, labels, values, 3,
+	                                                &written, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_assert_cmpuint (written, ==, 3);
+
+	/* Only the changed one is written */
+	secret_value_unref (values[1]);
+	values[1] = secret_value_new ("Changed", -1, "text/plain");
+
+	secret_service_store_all_if_changed (test->service, &MOCK_SCHEMA, NULL,
+	                                     attributes, labels, values, 3,
+	                                     NULL, on_complete_get_result, &result);
+	egg_test_wait ();
+
+	ret = secret_service_store_all_if_changed_finish (test->service, result, &written, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_assert_cmpuint (written, ==, 1);
+	g_object_unref (result);
+
+	secret_service_get_store_counts (test->service, &written, &skipped);
+	g_assert_cmpuint (written, ==, 4);
+	g_assert_cmpuint (skipped, ==, 2);
+
+	for (i = 0; i < G_N_ELEMENTS (values); i++) {
+		g_hash_table_unref (attributes[i]);
+		secret_value_unref (values[i]);
+	}
+}
+
 static void
 test_store_replace (Test *test,
                     gconstpointer used)
@@ -969,8 +1492,14 @@ main (int argc, char **argv)
 	g_test_add ("/service/search-all-async", Test, "mock-service-normal.py", setup, test_search_all_async, teardown);
 	g_test_add ("/service/search-unlock-sync", Test, "mock-service-normal.py", setup, test_search_unlock_sync, teardown);
 	g_test_add ("/service/search-unlock-async", Test, "mock-service-normal.py", setup, test_search_unlock_async, teardown);
+	g_test_add ("/service/search-unlock-secrets-sync", Test, "mock-service-normal.py", setup, test_search_unlock_secrets_sync, teardown);
 	g_test_add ("/service/search-secrets-sync", Test, "mock-service-normal.py", setup, test_search_secrets_sync, teardown);
 	g_test_add ("/service/search-secrets-async", Test, "mock-service-normal.py", setup, test_search_secrets_async, teardown);
+	g_test_add ("/service/search-secrets-latency", Test, "mock-service-latency.py", setup, test_search_secrets_async, teardown);
+	g_test_add ("/service/search-collections-sync", Test, "mock-service-normal.py", setup, test_search_collections_sync, teardown);
+	g_test_add ("/service/search-collections-async", Test, "mock-service-normal.py", setup, test_search_collections_async, teardown);
+	g_test_add ("/service/search-packed-sync", Test, "mock-service-normal.py", setup, test_search_packed_sync, teardown);
+	g_test_add ("/service/search-packed-async", Test, "mock-service-normal.py", setup, test_search_packed_async, teardown);
 
 	g_test_add ("/service/lock-sync", Test, "mock-service-lock.py", setup, test_lock_sync, teardown);
 
@@ -979,18 +1508,25 @@ main (int argc, char **argv)
 	g_test_add ("/service/lookup-sync", Test, "mock-service-normal.py", setup, test_lookup_sync, teardown);
 	g_test_add ("/service/lookup-async", Test, "mock-service-normal.py", setup, test_lookup_async, teardown);
 	g_test_add ("/service/lookup-locked", Test, "mock-service-normal.py", setup, test_lookup_locked, teardown);
+	g_test_add ("/service/lookup-locked-async", Test, "mock-service-normal.py", setup, test_lookup_locked_async, teardown);
+	g_test_add ("/service/lookup-locked-latency", Test, "mock-service-latency.py", setup, test_lookup_locked_async, teardown);
 	g_test_add ("/service/lookup-no-match", Test, "mock-service-normal.py", setup, test_lookup_no_match, teardown);
 	g_test_add ("/service/lookup-no-name", Test, "mock-service-normal.py", setup, test_lookup_no_name, teardown);
 
 	g_test_add ("/service/clear-sync", Test, "mock-service-delete.py", setup, test_clear_sync, teardown);
 	g_test_add ("/service/clear-async", Test, "mock-service-delete.py", setup, test_clear_async, teardown);
+	g_test_add ("/service/clear-all-matching", Test, "mock-service-delete.py", setup, test_clear_all_matching, teardown);
 	g_test_add ("/service/clear-locked", Test, "mock-service-delete.py", setup, test_clear_locked, teardown);
 	g_test_add ("/service/clear-no-match", Test, "mock-service-delete.py", setup, test_clear_no_match, teardown);
 	g_test_add ("/service/clear-no-name", Test, "mock-service-delete.py", setup, test_clear_no_name, teardown);
 
 	g_test_add ("/service/store-sync", Test, "mock-service-normal.py", setup, test_store_sync, teardown);
 	g_test_add ("/service/store-async", Test, "mock-service-normal.py", setup, test_store_async, teardown);
+	g_test_add ("/service/store-known-locked", Test, "mock-service-normal.py", setup, test_store_known_locked, teardown);
+	g_test_add ("/service/store-alias-unlocked", Test, "mock-service-normal.py", setup, test_store_alias_unlocked, teardown);
 	g_test_add ("/service/store-replace", Test, "mock-service-normal.py", setup, test_store_replace, teardown);
+	g_test_add ("/service/store-if-changed", Test, "mock-service-normal.py", setup, test_store_if_changed, teardown);
+	g_test_add ("/service/store-all-if-changed", Test, "mock-service-normal.py", setup, test_store_all_if_changed, teardown);
 	g_test_add ("/service/store-no-default", Test, "mock-service-empty.py", setup, test_store_no_default, teardown);
 
 	g_test_add ("/service/set-alias-sync", Test, "mock-service-normal.py", setup, test_set_alias_sync, teardown);
@@ -25,8 +25,11 @@
 
 #include <glib.h>
 
+#include <sys/wait.h>
+
 #include <errno.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 typedef struct {
 	SecretService *service;
@@ -373,6 +376,162 @@ test_open_more_sync (Test *test,
 	g_assert (service == NULL);
 }
 
+static void
+test_open_defer_items (Test *test,
+                       gconstpointer used)
+{
+	SecretService *service;
+	GError *error = NULL;
+	GList *collections, *l;
+	GList *items;
+	gboolean ret;
+
+	service = secret_service_open_sync (SECRET_TYPE_SERVICE, NULL,
+	                                    SECRET_SERVICE_LOAD_COLLECTIONS | SECRET_SERVICE_DEFER_ITEMS,
+	                                    NULL, &error);
+	g_assert_no_error (error);
+	g_assert (SECRET_IS_SERVICE (service));
+	g_object_add_weak_pointer (G_OBJECT (service), (gpointer *)&service);
+
+	g_assert_cmpuint (secret_service_get_flags (service), ==, SECRET_SERVICE_LOAD_COLLECTIONS | SECRET_SERVICE_DEFER_ITEMS);
+	collections = secret_service_get_collections (service);
+	g_assert (collections != NULL);
+
+	/* Only the collections, no items until asked for */
+	for (l = collections; l != NULL; l = g_list_next (l)) {
+		g_assert_cmpuint (secret_collection_get_flags (l->data), ==, SECRET_COLLECTION_NONE);
+		g_assert (secret_collection_get_items (l->data) == NULL);
+	}
+
+	ret = secret_collection_load_items_sync (collections->data, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (ret == TRUE);
+	g_assert_cmpuint (secret_collection_get_flags (collections->data), ==, SECRET_COLLECTION_LOAD_ITEMS);
+
+	items = secret_collection_get_items (collections->data);
+	g_list_free_full (items, g_object_unref);
+	g_list_free_full (collections, g_object_unref);
+
+	g_object_unref (service);
+	g_assert (service == NULL);
+}
+
+static void
+test_get_defer_items_then_items (Test *test,
+                                 gconstpointer used)
+{
+	SecretService *service;
+	SecretService *service2;
+	GError *error = NULL;
+	GList *collections, *l;
+
+	service = secret_service_get_sync (SECRET_SERVICE_LOAD_COLLECTIONS | SECRET_SERVICE_DEFER_ITEMS,
+	                                   NULL, &error);
+	g_assert_no_error (error);
+	g_object_add_weak_pointer (G_OBJECT (service), (gpointer *)&service);
+
+	g_assert_cmpuint (secret_service_get_flags (service), ==, SECRET_SERVICE_LOAD_COLLECTIONS | SECRET_SERVICE_DEFER_ITEMS);
+
+	/* Another caller of the shared proxy wants the items */
+	service2 = secret_service_get_sync (SECRET_SERVICE_LOAD_COLLECTIONS, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (service == service2);
+
+	g_assert_cmpuint (secret_service_get_flags (service), ==, SECRET_SERVICE_LOAD_COLLECTIONS);
+	collections = secret_service_get_collections (service);
+	g_assert (collections != NULL);
+	for (l = collections; l != NULL; l = g_list_next (l))
+		g_assert_cmpuint (secret_collection_get_flags (l->data), ==, SECRET_COLLECTION_LOAD_ITEMS);
+	g_list_free_full (collections, g_object_unref);
+
+	g_object_unref (service2);
+	g_object_unref (service);
+	secret_service_disconnect ();
+	g_assert (service == NULL);
+}
+
+static void
+test_open_private_connection (Test *test,
+                              gconstpointer used)
+{
+	GAsyncResult *result = NULL;
+	GDBusConnection *connection;
+	SecretService *service;
+	GError *error = NULL;
+
+	connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+	g_assert_no_error (error);
+
+	service = secret_service_open_sync (SECRET_TYPE_SERVICE, NULL,
+	                                    SECRET_SERVICE_PRIVATE_CONNECTION | SECRET_SERVICE_OPEN_SESSION,
+	                                    NULL, &error);
+	g_assert_no_error (error);
+	g_assert (SECRET_IS_SERVICE (service));
+	g_object_add_weak_pointer (G_OBJECT (service), (gpointer *)&service);
+
+	g_assert_cmpuint (secret_service_get_flags (service), ==,
+	                  SECRET_SERVICE_PRIVATE_CONNECTION | SECRET_SERVICE_OPEN_SESSION);
+	g_assert (g_dbus_proxy_get_connection (G_DBUS_PROXY (service)) != connection);
+	g_assert (secret_service_get_session_dbus_path (service) != NULL);
+
+	g_object_unref (service);
+	g_assert (service == NULL);
+
+	secret_service_open (SECRET_TYPE_SERVICE, NULL, SECRET_SERVICE_PRIVATE_CONNECTION,
+	                     NULL, on_complete_get_result, &result);
+	g_assert (result == NULL);
+
+	egg_test_wait ();
+
+	service = secret_service_open_finish (result, &error);
+	g_assert_no_error (error);
+	g_object_unref (result);
+	g_object_add_weak_pointer (G_OBJECT (service), (gpointer *)&service);
+
+	g_assert_cmpuint (secret_service_get_flags (service), ==, SECRET_SERVICE_PRIVATE_CONNECTION);
+	g_assert (g_dbus_proxy_get_connection (G_DBUS_PROXY (service)) != connection);
+
+	g_object_unref (service);
+	g_assert (service == NULL);
+
+	g_object_unref (connection);
+}
+
+static void
+test_get_after_fork (Test *test,
+                     gconstpointer used)
+{
+	SecretService *service;
+	SecretService *again;
+	GError *error = NULL;
+	int status;
+	pid_t pid;
+
+	service = secret_service_get_sync (SECRET_SERVICE_NONE, NULL, &error);
+	g_assert_no_error (error);
+
+	pid = fork ();
+	g_assert (pid >= 0);
+
+	/* The child must fail rather than use, or block on, the parent's connection */
+	if (pid == 0) {
+		again = secret_service_get_sync (SECRET_SERVICE_NONE, NULL, &error);
+		_exit (again == NULL && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED) ? 0 : 1);
+	}
+
+	g_assert_cmpint (waitpid (pid, &status, 0), ==, pid);
+	g_assert (WIFEXITED (status));
+	g_assert_cmpint (WEXITSTATUS (status), ==, 0);
+
+	/* The parent keeps its instance */
+	again = secret_service_get_sync (SECRET_SERVICE_NONE, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (again == service);
+
+	g_object_unref (again);
+	g_object_unref (service);
+}
+
 static void
 test_open_more_async (Test *test,
                      gconstpointer data)
@@ -596,6 +755,10 @@ main (int argc, char **argv)
 	g_test_add_func ("/service/open-async", test_open_async);
 	g_test_add ("/service/open-more-sync", Test, "mock-service-normal.py", setup_mock, test_open_more_sync, teardown_mock);
 	g_test_add ("/service/open-more-async", Test, "mock-service-normal.py", setup_mock, test_open_more_async, teardown_mock);
+	g_test_add ("/service/open-defer-items", Test, "mock-service-normal.py", setup_mock, test_open_defer_items, teardown_mock);
+	g_test_add ("/service/get-defer-items-then-items", Test, "mock-service-normal.py", setup_mock, test_get_defer_items_then_items, teardown_mock);
+	g_test_add ("/service/open-private-connection", Test, "mock-service-normal.py", setup_mock, test_open_private_connection, teardown_mock);
+	g_test_add ("/service/get-after-fork", Test, "mock-service-normal.py", setup_mock, test_get_after_fork, teardown_mock);
 
 	g_test_add ("/service/connect-sync", Test, "mock-service-normal.py", setup_mock, test_connect_async, teardown_mock);
 	g_test_add ("/service/connect-ensure-sync", Test, "mock-service-normal.py", setup_mock, test_connect_ensure_async, teardown_mock);
@@ -0,0 +1,359 @@
+/* libsecret - GLib wrapper for Secret Service
+ *
+ * Copyright 2012 Red Hat Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the licence or (at
+ * your option) any later version.
+ *
+ * See the included COPYING file for more information.
+ */
+
+/*
+ * Scalability stress test. A mock service is filled with a large number
+ * of items spread over several collections, and common operations are
+ * measured at increasing scales: time, D-Bus messages, resident and
+ * locked memory. The test fails if the cost grows super-linearly, that is
+ * when the exponent of a power law fitted to it is too large.
+ *
+ * Run with 'make stress'. The largest scale is set by STRESS_ITEMS,
+ * which defaults to 100000.
+ */
+
+#include "config.h"
+
+#include "secret-collection.h"
+#include "secret-item.h"
+#include "secret-paths.h"
+#include "secret-private.h"
+#include "secret-service.h"
+
+#include "mock-service.h"
+
+#include "egg/egg-testing.h"
+
+#include <glib.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Largest allowed exponent of cost against the number of items. Linear
+ * is 1.0, and quadratic 2.0. Time is given some room for noise and for
+ * logarithmic factors, messages are deterministic.
+ */
+#define MAX_TIME_EXPONENT      1.2
+#define MAX_MESSAGE_EXPONENT   1.05
+
+#define N_SCALES 3
+
+typedef enum {
+	PHASE_GET_SERVICE,
+	PHASE_LOAD_ITEMS,
+	PHASE_SEARCH,
+	PHASE_UPDATES,
+	N_PHASES
+} Phase;
+
+static const gchar *PHASE_NAMES[] = {
+	"get-load-collections",
+	"collection-load-items",
+	"search-all-load-secrets",
+	"signal-updates",
+};
+
+typedef struct {
+	gint64 usecs;
+	guint messages;
+	gsize rss_kb;
+	gsize locked_kb;
+} Measure;
+
+typedef struct {
+	guint n_items;
+	Measure phases[N_PHASES];
+	gsize peak_rss_kb;
+} Scale;
+
+static volatile gint n_messages = 0;
+
+static GDBusMessage *
+on_count_message (GDBusConnection *connection,
+                  GDBusMessage *message,
+                  gboolean incoming,
+                  gpointer user_data)
+{
+	g_atomic_int_inc (&n_messages);
+	return message;
+}
+
+static gsize
+read_status_kb (const gchar *field)
+{
+	gchar *contents;
+	gchar *line;
+	gsize value = 0;
+
+	if (!g_file_get_contents ("/proc/self/status", &contents, NULL, NULL))
+		return 0;
+
+	line = strstr (contents, field);
+	if (line != NULL)
+		value = strtoul (line + strlen (field) + 1, NULL, 10);
+
+	g_free (contents);
+	return value;
+}
+
+static void
+measure_begin (Measure *measure)
+{
+	measure->usecs = g_get_monotonic_time ();
+	measure->messages = g_atomic_int_get (&n_messages);
+}
+
+static void
+measure_end (Measure *measure)
+{
+	measure->usecs = g_get_monotonic_time () - measure->usecs;
+	measure->messages = g_atomic_int_get (&n_messages) - measure->messages;
+	measure->rss_kb = read_status_kb ("VmRSS:");
+	measure->locked_kb = read_status_kb ("VmLck:");
+}
+
+static void
+on_notify_label (GObject *obj,
+                 GParamSpec *pspec,
+                 gpointer user_data)
+{
+	guint *remaining = user_data;
+
+	g_assert_cmpuint (*remaining, >, 0);
+	if (--(*remaining) == 0)
+		egg_test_wait_stop ();
+}
+
+static void
+run_scale (Scale *scale)
+{
+	GDBusConnection *connection;
+	SecretCollection *collection;
+	SecretService *service;
+	GHashTable *attributes;
+	GError *error = NULL;
+	GList *collections = NULL;
+	GList *items, *l, *k;
+	GVariant *paths;
+	GVariantIter iter;
+	const gchar *path;
+	GVariant *retval;
+	gchar *count;
+	guint filter;
+	guint remaining;
+	guint loaded;
+
+	count = g_strdup_printf ("%u", scale->n_items);
+	g_setenv ("MOCK_STRESS_ITEMS", count, TRUE);
+	g_free (count);
+
+	mock_service_start ("mock-service-stress.py", &error);
+	g_assert_no_error (error);
+
+	connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, &error);
+	g_assert_no_error (error);
+	filter = g_dbus_connection_add_filter (connection, on_count_message, NULL, NULL);
+
+	/* Loading the service with all collections and items */
+	measure_begin (&scale->phases[PHASE_GET_SERVICE]);
+	service = secret_service_get_sync (SECRET_SERVICE_LOAD_COLLECTIONS, NULL, &error);
+	g_assert_no_error (error);
+	measure_end (&scale->phases[PHASE_GET_SERVICE]);
+
+	loaded = 0;
+	collections = secret_service_get_collections (service);
+	for (l = collections; l != NULL; l = g_list_next (l)) {
+		items = secret_collection_get_items (l->data);
+		loaded += g_list_length (items);
+		g_list_free_full (items, g_object_unref);
+	}
+	g_list_free_full (collections, g_object_unref);
+	g_assert_cmpuint (loaded, ==, scale->n_items);
+
+	g_object_unref (service);
+	secret_service_disconnect ();
+
+	/* Fresh collection proxies, loading their items */
+	service = secret_service_get_sync (SECRET_SERVICE_NONE, NULL, &error);
+	g_assert_no_error (error);
+
+	collections = NULL;
+	paths = g_dbus_proxy_get_cached_property (G_DBUS_PROXY (service), "Collections");
+	g_assert (paths != NULL);
+	g_variant_iter_init (&iter, paths);
+	while (g_variant_iter_next (&iter, "&o", &path)) {
+		collection = secret_collection_new_for_dbus_path_sync (service, path,
+		                                                       SECRET_COLLECTION_NONE,
+		                                                       NULL, &error);
+		g_assert_no_error (error);
+		collections = g_list_prepend (collections, collection);
+	}
+	g_variant_unref (paths);
+
+	measure_begin (&scale->phases[PHASE_LOAD_ITEMS]);
+	for (l = collections; l != NULL; l = g_list_next (l)) {
+		secret_collection_load_items_sync (l->data, NULL, &error);
+		g_assert_no_error (error);
+	}
+	measure_end (&scale->phases[PHASE_LOAD_ITEMS]);
+
+	/* Searching for everything, with secrets */
+	attributes = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_insert (attributes, "stress", "yes");
+
+	measure_begin (&scale->phases[PHASE_SEARCH]);
+	items = secret_service_search_sync (service, NULL, attributes,
+	                                    SECRET_SEARCH_ALL | SECRET_SEARCH_LOAD_SECRETS,
+	                                    NULL, &error);
+	g_assert_no_error (error);
+	measure_end (&scale->phases[PHASE_SEARCH]);
+
+	g_assert_cmpuint (g_list_length (items), ==, scale->n_items);
+	g_list_free_full (items, g_object_unref);
+	g_hash_table_unref (attributes);
+
+	/* Updates driven by PropertiesChanged from the service */
+	remaining = scale->n_items / 10;
+	for (l = collections; l != NULL; l = g_list_next (l)) {
+		items = secret_collection_get_items (l->data);
+		for (k = items; k != NULL; k = g_list_next (k))
+			g_signal_connect (k->data, "notify::label", G_CALLBACK (on_notify_label), &remaining);
+		g_list_free_full (items, g_object_unref);
+	}
+
+	measure_begin (&scale->phases[PHASE_UPDATES]);
+	retval = g_dbus_connection_call_sync (connection, MOCK_SERVICE_NAME,
+	                                      "/org/freedesktop/secrets", "org.mock.Stress",
+	                                      "Touch", g_variant_new ("(us)", remaining, "Touched"),
+	                                      G_VARIANT_TYPE ("(u)"), G_DBUS_CALL_FLAGS_NONE,
+	                                      -1, NULL, &error);
+	g_assert_no_error (error);
+	g_variant_unref (retval);
+	if (remaining > 0)
+		egg_test_wait_until (60 * 1000);
+	measure_end (&scale->phases[PHASE_UPDATES]);
+	g_assert_cmpuint (remaining, ==, 0);
+
+	for (l = collections; l != NULL; l = g_list_next (l)) {
+		items = secret_collection_get_items (l->data);
+		for (k = items; k != NULL; k = g_list_next (k))
+			g_signal_handlers_disconnect_by_func (k->data, on_notify_label, &remaining);
+		g_list_free_full (items, g_object_unref);
+	}
+
+	scale->peak_rss_kb = read_status_kb ("VmHWM:");
+
+	g_list_free_full (collections, g_object_unref);
+	g_object_unref (service);
+	secret_service_disconnect ();
+
+	g_dbus_connection_remove_filter (connection, filter);
+	g_object_unref (connection);
+
+	mock_service_stop ();
+}
+
+/* Least squares fit of log (cost) = exponent * log (items) + c */
+static gdouble
+fit_exponent (const Scale *scales,
+              const gdouble *costs)
+{
+	gdouble sx = 0, sy = 0, sxx = 0, sxy = 0;
+	gdouble x, y;
+	gint i;
+
+	for (i = 0; i < N_SCALES; i++) {
+		x = log (scales[i].n_items);
+		y = log (MAX (costs[i], 1.0));
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+	}
+
+	return (N_SCALES * sxy - sx * sy) / (N_SCALES * sxx - sx * sx);
+}
+
+static void
+test_scaling (void)
+{
+	Scale scales[N_SCALES];
+	const gchar *env;
+	guint max_items;
+	gdouble costs[N_SCALES];
+	gdouble exponent;
+	gint i, j;
+
+	env = g_getenv ("STRESS_ITEMS");
+	max_items = env ? strtoul (env, NULL, 10) : 100000;
+	g_assert_cmpuint (max_items, >=, 1 << N_SCALES);
+
+	/* Filling the mock service takes a while */
+	if (!g_getenv ("MOCK_SERVICE_READY_TIMEOUT"))
+		g_setenv ("MOCK_SERVICE_READY_TIMEOUT", "600000", TRUE);
+
+	/* Each scale is double the previous one */
+	memset (scales, 0, sizeof (scales));
+	for (i = 0; i < N_SCALES; i++) {
+		scales[i].n_items = max_items >> (N_SCALES - 1 - i);
+		run_scale (scales + i);
+	}
+
+	g_print ("\n# %-24s %8s %10s %10s %10s %10s\n", "phase", "items",
+	         "msecs", "messages", "rss-kb", "locked-kb");
+	for (j = 0; j < N_PHASES; j++) {
+		for (i = 0; i < N_SCALES; i++) {
+			g_print ("%-26s %8u %10.1f %10u %10" G_GSIZE_FORMAT " %10" G_GSIZE_FORMAT "\n",
+			         PHASE_NAMES[j], scales[i].n_items,
+			         scales[i].phases[j].usecs / 1000.0,
+			         scales[i].phases[j].messages,
+			         scales[i].phases[j].rss_kb,
+			         scales[i].phases[j].locked_kb);
+		}
+	}
+	for (i = 0; i < N_SCALES; i++)
+		g_print ("%-26s %8u %10s %10s %10" G_GSIZE_FORMAT "\n", "peak-rss",
+		         scales[i].n_items, "-", "-", scales[i].peak_rss_kb);
+
+	/* Fit how the cost grows with the number of items over all scales */
+	for (j = 0; j < N_PHASES; j++) {
+		for (i = 0; i < N_SCALES; i++)
+			costs[i] = scales[i].phases[j].usecs;
+		exponent = fit_exponent (scales, costs);
+		g_print ("%-26s time grows as items^%.2f\n", PHASE_NAMES[j], exponent);
+		if (exponent > MAX_TIME_EXPONENT)
+			g_error ("%s: time grew super-linearly: items^%.2f", PHASE_NAMES[j], exponent);
+
+		for (i = 0; i < N_SCALES; i++)
+			costs[i] = scales[i].phases[j].messages;
+		exponent = fit_exponent (scales, costs);
+		g_print ("%-26s messages grow as items^%.2f\n", PHASE_NAMES[j], exponent);
+		if (exponent > MAX_MESSAGE_EXPONENT)
+			g_error ("%s: messages grew super-linearly: items^%.2f", PHASE_NAMES[j], exponent);
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+	g_set_prgname ("test-stress");
+#if !GLIB_CHECK_VERSION(2,35,0)
+	g_type_init ();
+#endif
+
+	g_test_add_func ("/stress/scaling", test_scaling);
+
+	return egg_tests_run_with_loop ();
+}
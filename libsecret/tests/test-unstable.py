@@ -59,5 +59,19 @@ class TestStore(unittest.TestCase):
 		item_secret = item.get_secret()
 		self.assertEqual(item_secret.get(), "the password")
 
+	def testSearchPacked(self):
+		Secret.password_store_sync(EXAMPLE_SCHEMA, attributes, Secret.COLLECTION_DEFAULT,
+		                           'the label', 'the password', None)
+
+		service = SecretUnstable.Service.get_sync(SecretUnstable.ServiceFlags.NONE, None)
+		packed = service.search_packed_sync(EXAMPLE_SCHEMA, { 'even': 'true' },
+		                                    SecretUnstable.SearchFlags.ALL | SecretUnstable.SearchFlags.LOAD_SECRETS,
+		                                    None)
+
+		(path, label, item_attributes, secret, content_type) = packed.unpack()[0]
+		self.assertEqual(label, 'the label')
+		self.assertEqual(item_attributes['string'], 'eight')
+		self.assertEqual(bytes(bytearray(secret)), b'the password')
+
 if __name__ == '__main__':
 		unittest.main()
@@ -16,6 +16,7 @@
 
 #include "secret-item.h"
 #include "secret-password.h"
+#include "secret-paths.h"
 #include "secret-service.h"
 #include "secret-value.h"
 
@@ -26,12 +27,15 @@
 #include <limits.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define SECRET_ALIAS_PREFIX "/org/freedesktop/secrets/aliases/"
 
 static gchar **attribute_args = NULL;
 static gchar *store_label = NULL;
 static gchar *store_collection = NULL;
+static gchar **exec_envs = NULL;
+static gchar **exec_args = NULL;
 
 /* secret-tool store --label="blah" --collection="xxxx" name:xxxx name:yyyy */
 static const GOptionEntry STORE_OPTIONS[] = {
@@ -58,6 +62,15 @@ static const GOptionEntry CLEAR_OPTIONS[] = {
 	{ NULL }
 };
 
+/* secret-tool exec --env NAME=name:xxxx,yyyy:zzzz -- command */
+static const GOptionEntry EXEC_OPTIONS[] = {
+	{ "env", 'e', 0, G_OPTION_ARG_STRING_ARRAY, &exec_envs,
+	  N_("set variable to the password of the item matching the attributes"), "NAME=attribute:value,..." },
+	{ G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_STRING_ARRAY, &exec_args,
+	  N_("the command to run"), NULL },
+	{ NULL }
+};
+
 typedef int       (* SecretToolAction)          (int argc, char *argv[]);
 
 static void       usage                         (void) G_GNUC_NORETURN;
@@ -69,26 +82,15 @@ usage (void)
 	g_printerr ("       secret-tool lookup attribute value ...\n");
 	g_printerr ("       secret-tool clear attribute value ...\n");
 	g_printerr ("       secret-tool search [--all] [--details] attribute value ...\n");
+	g_printerr ("       secret-tool exec --env NAME=attribute:value,... -- command ...\n");
 	exit (2);
 }
 
 static gboolean
 is_password_value (SecretValue *value)
 {
-	const gchar *content_type;
-	const gchar *data;
-	gsize length;
-
-	content_type = secret_value_get_content_type (value);
-	if (content_type && g_str_equal (content_type, "text/plain"))
-		return TRUE;
-
-	data = secret_value_get (value, &length);
-	/* gnome-keyring-daemon used to return passwords like this, so support this, but validate */
-	if (!content_type || g_str_equal (content_type, "application/octet-stream"))
-		return g_utf8_validate (data, length, NULL);
-
-	return FALSE;
+	/* Validated, and remembered, the same way as in the library */
+	return secret_value_get_text (value) != NULL;
 }
 
 static GHashTable *
@@ -477,6 +479,303 @@ secret_tool_action_search (int argc,
 	return 0;
 }
 
+typedef struct {
+	GMainLoop *loop;
+	gint pending;
+	GError *error;
+} ExecSearch;
+
+typedef struct {
+	gchar *name;
+	GHashTable *attributes;
+	gchar *path;
+	gboolean locked;
+	ExecSearch *search;
+} ExecEnv;
+
+static void
+exec_env_free (gpointer data)
+{
+	ExecEnv *env = data;
+	g_free (env->name);
+	g_hash_table_unref (env->attributes);
+	g_free (env->path);
+	g_slice_free (ExecEnv, env);
+}
+
+static ExecEnv *
+exec_env_from_argument (const gchar *arg)
+{
+	ExecEnv *env;
+	const gchar *equals;
+	const gchar *colon;
+	gchar **pairs;
+	guint i;
+
+	/* NAME=attribute:value,attribute:value */
+	equals = strchr (arg, '=');
+	if (equals == NULL || equals == arg) {
+		g_printerr ("%s: must specify --env as NAME=attribute:value,...\n", g_get_prgname ());
+		usage ();
+	}
+
+	env = g_slice_new0 (ExecEnv);
+	env->name = g_strndup (arg, equals - arg);
+	env->attributes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	pairs = g_strsplit (equals + 1, ",", -1);
+	for (i = 0; pairs[i] != NULL; i++) {
+		colon = strchr (pairs[i], ':');
+		if (colon == NULL || colon == pairs[i]) {
+			g_printerr ("%s: must specify attributes and values for %s as attribute:value\n",
+			            g_get_prgname (), env->name);
+			usage ();
+		}
+		g_hash_table_insert (env->attributes, g_strndup (pairs[i], colon - pairs[i]),
+		                     g_strdup (colon + 1));
+	}
+	g_strfreev (pairs);
+
+	if (g_hash_table_size (env->attributes) == 0) {
+		g_printerr ("%s: must specfy attribute and value pairs for %s\n",
+		            g_get_prgname (), env->name);
+		usage ();
+	}
+
+	return env;
+}
+
+static void
+exec_search_complete (ExecSearch *search)
+{
+	search->pending--;
+	if (search->pending == 0)
+		g_main_loop_quit (search->loop);
+}
+
+static void
+on_exec_session (GObject *source,
+                 GAsyncResult *result,
+                 gpointer user_data)
+{
+	ExecSearch *search = user_data;
+	GError *error = NULL;
+
+	if (!secret_service_ensure_session_finish (SECRET_SERVICE (source), result, &error)) {
+		if (search->error == NULL)
+			search->error = error;
+		else
+			g_error_free (error);
+	}
+
+	exec_search_complete (search);
+}
+
+static void
+on_exec_searched (GObject *source,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+	ExecEnv *env = user_data;
+	ExecSearch *search = env->search;
+	gchar **unlocked = NULL;
+	gchar **locked = NULL;
+	GError *error = NULL;
+
+	if (secret_service_search_for_dbus_paths_finish (SECRET_SERVICE (source), result,
+	                                                 &unlocked, &locked, &error)) {
+		/* Prefer an item that is already unlocked, like secret-tool lookup */
+		if (unlocked && unlocked[0]) {
+			env->path = g_strdup (unlocked[0]);
+		} else if (locked && locked[0]) {
+			env->path = g_strdup (locked[0]);
+			env->locked = TRUE;
+		}
+	} else if (search->error == NULL) {
+		search->error = error;
+	} else {
+		g_error_free (error);
+	}
+
+	g_strfreev (unlocked);
+	g_strfreev (locked);
+	exec_search_complete (search);
+}
+
+static gboolean
+exec_unlock_paths (SecretService *service,
+                   GPtrArray *envs,
+                   GError **error)
+{
+	GPtrArray *paths;
+	gchar **unlocked = NULL;
+	GError *unlock_error = NULL;
+	ExecEnv *env;
+	guint i, j;
+
+	paths = g_ptr_array_new ();
+	for (i = 0; i < envs->len; i++) {
+		env = envs->pdata[i];
+		if (env->locked)
+			g_ptr_array_add (paths, env->path);
+	}
+
+	/* All the locked items are unlocked together, with at most one prompt */
+	if (paths->len > 0) {
+		g_ptr_array_add (paths, NULL);
+		secret_service_unlock_dbus_paths_sync (service, (const gchar **)paths->pdata,
+		                                       NULL, &unlocked, &unlock_error);
+		for (i = 0; unlocked && i < envs->len; i++) {
+			env = envs->pdata[i];
+			for (j = 0; env->locked && unlocked[j] != NULL; j++) {
+				if (g_str_equal (unlocked[j], env->path))
+					env->locked = FALSE;
+			}
+		}
+		g_strfreev (unlocked);
+	}
+
+	g_ptr_array_free (paths, TRUE);
+
+	if (unlock_error != NULL) {
+		g_propagate_error (error, unlock_error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static GHashTable *
+exec_lookup_secrets (SecretService *service,
+                     GPtrArray *envs,
+                     GError **error)
+{
+	ExecSearch search = { NULL, 0, NULL };
+	GHashTable *secrets;
+	GPtrArray *paths;
+	ExecEnv *env;
+	guint i;
+
+	/*
+	 * The session is opened while all the searches are in flight, and
+	 * then all the secrets are retrieved in a single GetSecrets call.
+	 */
+	search.loop = g_main_loop_new (NULL, FALSE);
+
+	search.pending++;
+	secret_service_ensure_session (service, NULL, on_exec_session, &search);
+
+	for (i = 0; i < envs->len; i++) {
+		env = envs->pdata[i];
+		env->search = &search;
+		search.pending++;
+		secret_service_search_for_dbus_paths (service, NULL, env->attributes,
+		                                      NULL, on_exec_searched, env);
+	}
+
+	g_main_loop_run (search.loop);
+	g_main_loop_unref (search.loop);
+
+	if (search.error != NULL) {
+		g_propagate_error (error, search.error);
+		return NULL;
+	}
+
+	if (!exec_unlock_paths (service, envs, error))
+		return NULL;
+
+	paths = g_ptr_array_new ();
+	for (i = 0; i < envs->len; i++) {
+		env = envs->pdata[i];
+		if (env->path == NULL || env->locked) {
+			g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+			             _("no unlocked password matches %s"), env->name);
+			g_ptr_array_free (paths, TRUE);
+			return NULL;
+		}
+		g_ptr_array_add (paths, env->path);
+	}
+
+	g_ptr_array_add (paths, NULL);
+	secrets = secret_service_get_secrets_for_dbus_paths_sync (service, (const gchar **)paths->pdata,
+	                                                          NULL, error);
+	g_ptr_array_free (paths, TRUE);
+
+	return secrets;
+}
+
+static int
+secret_tool_action_exec (int argc,
+                         char *argv[])
+{
+	GError *error = NULL;
+	GOptionContext *context;
+	SecretService *service;
+	GHashTable *secrets = NULL;
+	SecretValue *value;
+	GPtrArray *envs;
+	ExecEnv *env;
+	guint i;
+	int errsv;
+
+	context = g_option_context_new ("-- command ...");
+	g_option_context_add_main_entries (context, EXEC_OPTIONS, GETTEXT_PACKAGE);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		usage();
+	}
+
+	g_option_context_free (context);
+
+	if (exec_args == NULL || exec_args[0] == NULL) {
+		g_printerr ("%s: must specify a command to run\n", g_get_prgname ());
+		usage ();
+	}
+
+	envs = g_ptr_array_new_with_free_func (exec_env_free);
+	for (i = 0; exec_envs && exec_envs[i] != NULL; i++)
+		g_ptr_array_add (envs, exec_env_from_argument (exec_envs[i]));
+	g_strfreev (exec_envs);
+
+	if (envs->len > 0) {
+		service = secret_service_get_sync (SECRET_SERVICE_NONE, NULL, &error);
+		if (error == NULL) {
+			secrets = exec_lookup_secrets (service, envs, &error);
+			g_object_unref (service);
+		}
+
+		if (error != NULL) {
+			g_printerr ("%s: %s\n", g_get_prgname (), error->message);
+			g_ptr_array_free (envs, TRUE);
+			g_strfreev (exec_args);
+			return 1;
+		}
+
+		for (i = 0; i < envs->len; i++) {
+			env = envs->pdata[i];
+			value = g_hash_table_lookup (secrets, env->path);
+			if (value == NULL || !is_password_value (value)) {
+				g_printerr ("%s: secret for %s does not contain a textual password\n",
+				            g_get_prgname (), env->name);
+				exit (1);
+			}
+			g_setenv (env->name, secret_value_get_text (value), TRUE);
+		}
+
+		g_hash_table_unref (secrets);
+	}
+
+	g_ptr_array_free (envs, TRUE);
+
+	execvp (exec_args[0], exec_args);
+
+	/* Printing may change errno */
+	errsv = errno;
+	g_printerr ("%s: couldn't run %s: %s\n", g_get_prgname (),
+	            exec_args[0], g_strerror (errsv));
+	return errsv == ENOENT ? 127 : 126;
+}
+
 int
 main (int argc,
       char *argv[])
@@ -506,6 +805,8 @@ main (int argc,
 		action = secret_tool_action_clear;
 	} else if (g_str_equal (argv[1], "search")) {
 		action = secret_tool_action_search;
+	} else if (g_str_equal (argv[1], "exec")) {
+		action = secret_tool_action_exec;
 	} else {
 		usage ();
 	}